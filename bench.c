@@ -0,0 +1,501 @@
+#include "bench.h"
+#include "hal.h"
+#include "klib.h"
+#include "console.h"
+#include "serial.h"
+#include "paging.h"
+#include "vfs.h"
+#include "sched.h"
+#include "syscall.h"
+#include "ramdisk.h"
+#include "journal.h"
+#include "crc32c.h"
+#include "shell.h"
+#ifndef HOST_BUILD
+#include "pmm.h"
+#endif
+
+// Benchmarks
+// Each case prints one line over COM1:
+//   bench name=<case> size=<bytes> iters=<n> min=<cycles> avg=<cycles> max=<cycles>
+typedef struct {
+    unsigned long long total;
+    unsigned long long min;
+    unsigned long long max;
+    unsigned int iters;
+} BenchStats;
+
+static unsigned long long rdtsc_overhead = 0;
+static int bench_cases_run = 0;
+
+static void bench_reset(BenchStats* s) {
+    s->total = 0;
+    s->min = ~0ULL;
+    s->max = 0;
+    s->iters = 0;
+}
+
+static void bench_sample(BenchStats* s, unsigned long long start, unsigned long long end) {
+    unsigned long long cycles = end - start;
+    cycles = cycles > rdtsc_overhead ? cycles - rdtsc_overhead : 0;
+    s->total += cycles;
+    if (cycles < s->min) s->min = cycles;
+    if (cycles > s->max) s->max = cycles;
+    s->iters++;
+}
+
+static void bench_report(const char* name, int size, BenchStats* s) {
+    serial_write("bench name=");
+    serial_write(name);
+    serial_write(" size=");
+    serial_write_u64(size);
+    serial_write(" iters=");
+    serial_write_u64(s->iters);
+    serial_write(" min=");
+    serial_write_u64(s->iters ? s->min : 0);
+    serial_write(" avg=");
+    serial_write_u64(s->iters ? udiv64(s->total, s->iters, 0) : 0);
+    serial_write(" max=");
+    serial_write_u64(s->max);
+    serial_write("\n");
+    bench_cases_run++;
+}
+
+static void bench_calibrate() {
+    unsigned long long best = ~0ULL;
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        unsigned long long t0 = rdtsc();
+        unsigned long long t1 = rdtsc();
+        if (t1 - t0 < best) best = t1 - t0;
+    }
+    rdtsc_overhead = best;
+    serial_write("bench-calibrate rdtsc_overhead=");
+    serial_write_u64(rdtsc_overhead);
+    serial_write("\n");
+}
+
+static void bench_scheduler() {
+    BenchStats s;
+    static SchedSnapshot saved;
+    sched_snapshot(&saved);
+
+    // Steady-state tick: the best task is already running
+    bench_reset(&s);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        unsigned long long t0 = rdtsc();
+        schedule();
+        unsigned long long t1 = rdtsc();
+        bench_sample(&s, t0, t1);
+    }
+    bench_report("sched_tick", 0, &s);
+
+    // Forced switch: park a lower-priority task as current before each call.
+    // The idle loop has no slot to make ready again, so it skips the case.
+    int low = -1;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processes[i].pid && i != current_process) low = i;
+    }
+    if (current_process == IDLE_PROCESS) {
+        serial_write("bench-skip name=sched_switch reason=idle\n");
+    } else if (low >= 0) {
+        bench_reset(&s);
+        for (int i = 0; i < BENCH_ITERS; i++) {
+            int best = current_process;
+            processes[best].state = 0;
+            processes[low].state = 1;
+            current_process = low;
+            unsigned long long t0 = rdtsc();
+            schedule();
+            unsigned long long t1 = rdtsc();
+            bench_sample(&s, t0, t1);
+        }
+        bench_report("sched_switch", 0, &s);
+    }
+
+    sched_restore(&saved);
+}
+
+#ifndef HOST_BUILD
+static void bench_syscall() {
+    BenchStats s;
+    bench_reset(&s);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        unsigned int num = SYS_PS;
+        unsigned long long t0 = rdtsc();
+        asm volatile("int $0x80" : "+a"(num) : : "memory");
+        unsigned long long t1 = rdtsc();
+        bench_sample(&s, t0, t1);
+    }
+    bench_report("syscall_int80", 0, &s);
+}
+#endif
+
+static void bench_vfs() {
+    static const int sizes[] = { 16, 256, 1024, MAX_FILE_SIZE };
+    static char buf[MAX_FILE_SIZE];
+    const char* name = "bench.dat";
+    BenchStats s;
+
+    if (!vfs_initialized) return;
+    for (int i = 0; i < MAX_FILE_SIZE; i++) buf[i] = 'a' + (i % 26);
+    vfs_delete_file(name);
+    if (vfs_create_file(name) < 0) {
+        serial_write("bench-skip name=vfs reason=no_free_inode\n");
+        return;
+    }
+
+    bench_reset(&s);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        unsigned long long t0 = rdtsc();
+        int fd = vfs_open_file(name);
+        unsigned long long t1 = rdtsc();
+        bench_sample(&s, t0, t1);
+        vfs_close_file(fd);
+    }
+    bench_report("vfs_open", 0, &s);
+
+    for (unsigned int k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        int size = sizes[k];
+        bench_reset(&s);
+        for (int i = 0; i < BENCH_ITERS; i++) {
+            int fd = vfs_open_file(name);
+            unsigned long long t0 = rdtsc();
+            vfs_write_file(fd, buf, size);
+            unsigned long long t1 = rdtsc();
+            bench_sample(&s, t0, t1);
+            vfs_close_file(fd);
+        }
+        bench_report("vfs_write", size, &s);
+
+        bench_reset(&s);
+        for (int i = 0; i < BENCH_ITERS; i++) {
+            int fd = vfs_open_file(name);
+            unsigned long long t0 = rdtsc();
+            vfs_read_file(fd, buf, size);
+            unsigned long long t1 = rdtsc();
+            bench_sample(&s, t0, t1);
+            vfs_close_file(fd);
+        }
+        bench_report("vfs_read", size, &s);
+    }
+    vfs_delete_file(name);
+}
+
+// cat-style reads of a 4 KiB text file in block-sized chunks: stored raw,
+// compressed and found in the decompressed cache, and compressed with
+// more files in rotation than the cache holds, so every open misses
+#define BENCH_ZFILES 5
+
+static void bench_compressed() {
+    static char text[MAX_FILE_SIZE], buf[VFS_BLOCK_SIZE];
+    static const char* names[BENCH_ZFILES] = { "benchz0", "benchz1", "benchz2", "benchz3", "benchz4" };
+    static const struct {
+        const char* name;
+        int compressed, files;
+    } cases[] = {
+        { "vfs_cat", 0, 1 },
+        { "vfs_cat_z", 1, 1 },
+        { "vfs_cat_z_cold", 1, BENCH_ZFILES },
+    };
+    BenchStats s;
+
+    if (!vfs_initialized) return;
+    for (int i = 0; i < MAX_FILE_SIZE; i++) text[i] = "the quick brown fox "[i % 20] + (i / 700);
+    for (int f = 0; f < BENCH_ZFILES; f++) {
+        vfs_delete_file(names[f]);
+        int fd = vfs_create_file(names[f]) < 0 ? -1 : vfs_open_file(names[f]);
+        if (fd < 0) {
+            serial_write("bench-skip name=vfs_cat reason=no_free_inode\n");
+            return;
+        }
+        vfs_write_file(fd, text, MAX_FILE_SIZE);
+        vfs_close_file(fd);
+    }
+    for (unsigned int c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        for (int f = 0; f < BENCH_ZFILES; f++) vfs_compress(names[f], cases[c].compressed);
+        bench_reset(&s);
+        for (int i = 0; i < BENCH_ITERS; i++) {
+            int fd = vfs_open_file(names[i % cases[c].files]);
+            unsigned long long t0 = rdtsc();
+            while (vfs_read_file(fd, buf, sizeof(buf)) > 0) {}
+            unsigned long long t1 = rdtsc();
+            bench_sample(&s, t0, t1);
+            vfs_close_file(fd);
+        }
+        bench_report(cases[c].name, MAX_FILE_SIZE, &s);
+    }
+    for (int f = 0; f < BENCH_ZFILES; f++) vfs_delete_file(names[f]);
+}
+
+// What the keyboard interrupt does with a shell line: split it into argv
+// and look the command up in the table
+static void bench_shell() {
+    static const char line[] = "sched 3 edf 2 10";
+    char args[SHELL_LINE_MAX];
+    char* argv[SHELL_ARGS];
+    BenchStats s;
+    volatile int found = 0;
+
+    bench_reset(&s);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        unsigned long long t0 = rdtsc();
+        memcpy(args, line, sizeof(line));
+        found += shell_parse(args, argv, SHELL_ARGS) > 0 && shell_find(argv[0]);
+        unsigned long long t1 = rdtsc();
+        bench_sample(&s, t0, t1);
+    }
+    bench_report("shell_dispatch", sizeof(line) - 1, &s);
+}
+
+// klib memory primitives over a page, aligned and off by one byte
+static void bench_memory() {
+    static char src[PAGE_SIZE + 16], dst[PAGE_SIZE + 16];
+    static const int sizes[] = { 64, 512, PAGE_SIZE };
+    BenchStats s;
+
+    for (unsigned int k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        int size = sizes[k];
+        bench_reset(&s);
+        for (int i = 0; i < BENCH_ITERS; i++) {
+            unsigned long long t0 = rdtsc();
+            memcpy(dst, src, size);
+            unsigned long long t1 = rdtsc();
+            bench_sample(&s, t0, t1);
+        }
+        bench_report("memcpy", size, &s);
+
+        bench_reset(&s);
+        for (int i = 0; i < BENCH_ITERS; i++) {
+            unsigned long long t0 = rdtsc();
+            memcpy(dst + 1, src, size);
+            unsigned long long t1 = rdtsc();
+            bench_sample(&s, t0, t1);
+        }
+        bench_report("memcpy_unaligned", size, &s);
+
+        bench_reset(&s);
+        for (int i = 0; i < BENCH_ITERS; i++) {
+            unsigned long long t0 = rdtsc();
+            memset(dst, i, size);
+            unsigned long long t1 = rdtsc();
+            bench_sample(&s, t0, t1);
+        }
+        bench_report("memset", size, &s);
+    }
+}
+
+// CRC32C by path: a table lookup per byte, slice-by-8 and, where the CPU
+// has SSE4.2, the crc32 instruction
+static void bench_crc32c() {
+    static char buf[PAGE_SIZE];
+    static const int sizes[] = { 64, BLOCK_SIZE, PAGE_SIZE };
+    static const struct {
+        const char* name;
+        unsigned int (*fn)(unsigned int, const void*, size_t);
+    } paths[] = {
+        { "crc32c_byte", crc32c_byte },
+        { "crc32c_slice8", crc32c_sw },
+        { "crc32c_sse42", crc32c_hw },
+    };
+    BenchStats s;
+    volatile unsigned int sink = 0;
+
+    for (int i = 0; i < PAGE_SIZE; i++) buf[i] = (char)(i * 31);
+    for (unsigned int p = 0; p < sizeof(paths) / sizeof(paths[0]); p++) {
+        if (paths[p].fn == crc32c_hw && !crc32c_has_hw) {
+            serial_write("bench-skip name=crc32c_sse42 reason=no_sse4_2\n");
+            continue;
+        }
+        for (unsigned int k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+            bench_reset(&s);
+            for (int i = 0; i < BENCH_ITERS; i++) {
+                unsigned long long t0 = rdtsc();
+                sink = paths[p].fn(sink, buf, sizes[k]);
+                unsigned long long t1 = rdtsc();
+                bench_sample(&s, t0, t1);
+            }
+            bench_report(paths[p].name, sizes[k], &s);
+        }
+    }
+}
+
+// Block layer and journal over a RAM disk: no device latency, so the
+// numbers are the file system's own CPU cost. The journal case mounts the
+// disk, so it only runs while no other device is mounted.
+#define BENCH_DISK_BLOCKS 512
+#define BENCH_SMALL_WRITES 32   // Small writes per group commit
+
+static void bench_ramdisk() {
+    static char mem[BENCH_DISK_BLOCKS * BLOCK_SIZE];
+    static char buf[BLOCK_SIZE];
+    static unsigned int sums[BENCH_DISK_BLOCKS];
+    static RamDisk rd;
+    BenchStats s;
+
+    ramdisk_init(&rd, "bench", mem, BENCH_DISK_BLOCKS);
+    block_enable_sums(&rd.dev, sums); // Checked like a registered device
+    bench_reset(&s);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        unsigned long long t0 = rdtsc();
+        block_write(&rd.dev, i % rd.dev.blocks, buf);
+        unsigned long long t1 = rdtsc();
+        bench_sample(&s, t0, t1);
+    }
+    bench_report("blk_write", BLOCK_SIZE, &s);
+    bench_reset(&s);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        unsigned long long t0 = rdtsc();
+        block_read(&rd.dev, i % rd.dev.blocks, buf);
+        unsigned long long t1 = rdtsc();
+        bench_sample(&s, t0, t1);
+    }
+    bench_report("blk_read", BLOCK_SIZE, &s);
+
+    unsigned int eflags = irq_save(); // No other task writes through the bench disk
+    if (!vfs_initialized || journal_attached()) {
+        irq_restore(eflags);
+        serial_write("bench-skip name=journal_sync reason=mounted\n");
+        return;
+    }
+    memset(mem, 0, BENCH_DISK_BLOCKS * BLOCK_SIZE);
+    ramdisk_init(&rd, "bench", mem, BENCH_DISK_BLOCKS); // Blank: sums made afresh
+    block_enable_sums(&rd.dev, sums);
+    const char* name = "bench.log";
+    vfs_delete_file(name);
+    if (vfs_create_file(name) < 0 || vfs_mount(&rd.dev) < 0) {
+        vfs_delete_file(name);
+        irq_restore(eflags);
+        serial_write("bench-skip name=journal_sync reason=mount_failed\n");
+        return;
+    }
+    // Each sample: BENCH_SMALL_WRITES 16-byte writes, then one group commit
+    bench_reset(&s);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        int fd = vfs_open_file(name);
+        unsigned long long t0 = rdtsc();
+        for (int j = 0; j < BENCH_SMALL_WRITES; j++) vfs_write_file(fd, buf, 16);
+        vfs_sync();
+        unsigned long long t1 = rdtsc();
+        bench_sample(&s, t0, t1);
+        vfs_close_file(fd);
+    }
+    bench_report("journal_sync", BENCH_SMALL_WRITES * 16, &s);
+    vfs_delete_file(name);
+    vfs_unmount();
+    irq_restore(eflags);
+}
+
+static void bench_console() {
+    const char* line = "The quick brown fox jumps over the lazy dog. 0123456789 ABCDEFGHIJKLMNOPQRSTUV";
+    BenchStats s;
+
+    bench_reset(&s);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        unsigned long long t0 = rdtsc();
+        print_string(line, 24, 0);
+        unsigned long long t1 = rdtsc();
+        bench_sample(&s, t0, t1);
+    }
+    bench_report("console_line", VGA_WIDTH, &s);
+
+    bench_reset(&s);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        unsigned long long t0 = rdtsc();
+        print_number(1234567 + i, 24, 0);
+        unsigned long long t1 = rdtsc();
+        bench_sample(&s, t0, t1);
+    }
+    bench_report("console_number", 0, &s);
+
+    bench_reset(&s);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        unsigned long long t0 = rdtsc();
+        clear_screen();
+        unsigned long long t1 = rdtsc();
+        bench_sample(&s, t0, t1);
+    }
+    bench_report("console_clear", VGA_WIDTH * VGA_HEIGHT * 2, &s);
+}
+
+static void bench_paging() {
+    BenchStats s;
+    bench_reset(&s);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        unsigned long long t0 = rdtsc();
+        unsigned int* page_dir = create_user_page_dir();
+        unsigned long long t1 = rdtsc();
+        bench_sample(&s, t0, t1);
+        if (page_dir) free_user_page_dir(page_dir);
+    }
+    bench_report("page_dir_alloc", PAGE_SIZE, &s);
+}
+
+#ifndef HOST_BUILD
+// fork's address-space clone for parents of growing size: it shares page
+// tables copy-on-write, so the cost should stay flat
+static void bench_fork() {
+    static const int page_counts[] = { 1, 64, 1024 };
+    for (unsigned int c = 0; c < sizeof(page_counts) / sizeof(page_counts[0]); c++) {
+        unsigned int* parent = create_user_page_dir();
+        if (!parent) return;
+        int mapped = 0;
+        for (; mapped < page_counts[c]; mapped++) {
+            unsigned int frame = frame_alloc();
+            if (!frame) break;
+            if (paging_map(parent, USER_BASE + mapped * PAGE_SIZE, frame, PAGE_USER | PAGE_WRITE | PAGE_PRESENT) < 0) {
+                frame_free(frame);
+                break;
+            }
+        }
+        if (mapped < page_counts[c]) {
+            serial_write("bench-skip name=fork_clone reason=out_of_frames\n");
+            free_user_page_dir(parent);
+            return;
+        }
+        BenchStats s;
+        bench_reset(&s);
+        for (int i = 0; i < BENCH_ITERS; i++) {
+            unsigned long long t0 = rdtsc();
+            unsigned int* child = create_user_page_dir();
+            if (child) paging_clone(child, parent);
+            unsigned long long t1 = rdtsc();
+            bench_sample(&s, t0, t1);
+            if (child) free_user_page_dir(child);
+        }
+        bench_report("fork_clone", page_counts[c] * PAGE_SIZE, &s);
+        free_user_page_dir(parent);
+    }
+}
+#endif
+
+// Interrupts stay on except where a case borrows state other tasks use:
+// the scheduler's, the frame allocator (unlocked) and the mounted device.
+// The rest only go through locked interfaces, so the shell keeps running.
+int run_benchmarks() {
+    bench_cases_run = 0;
+    serial_write("bench-begin\n");
+    bench_calibrate();
+    unsigned int eflags = irq_save();
+    bench_scheduler();
+#ifndef HOST_BUILD
+    bench_syscall();
+#endif
+    irq_restore(eflags);
+    bench_vfs();
+    bench_compressed();
+    bench_shell();
+    bench_memory();
+    bench_crc32c();
+    bench_ramdisk();
+    bench_console();
+    eflags = irq_save();
+    bench_paging();
+#ifndef HOST_BUILD
+    bench_fork();
+#endif
+    irq_restore(eflags);
+    serial_write("bench-end cases=");
+    serial_write_u64(bench_cases_run);
+    serial_write("\n");
+    return bench_cases_run;
+}
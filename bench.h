@@ -0,0 +1,11 @@
+// Microbenchmarks
+#ifndef BENCH_H
+#define BENCH_H
+
+#ifndef BENCH_ITERS
+#define BENCH_ITERS 1000
+#endif
+
+int run_benchmarks(void);
+
+#endif
@@ -0,0 +1,52 @@
+#!/bin/bash
+# Compare benchmark output against a baseline and flag regressions.
+# Usage: ./bench_compare.sh bench_output.txt [bench_baseline.txt]
+# A case regresses when its avg cycles exceed the baseline by more than
+# BENCH_THRESHOLD percent (default 10).
+
+OUTPUT=${1:-bench_output.txt}
+BASELINE=${2:-bench_baseline.txt}
+THRESHOLD=${BENCH_THRESHOLD:-10}
+
+if [ ! -f "$OUTPUT" ]; then
+  echo "❌ Error: $OUTPUT not found."
+  exit 1
+fi
+
+if ! grep -q '^bench-end' "$OUTPUT"; then
+  echo "❌ Error: benchmark run did not complete (no bench-end line)."
+  exit 1
+fi
+
+if [ ! -f "$BASELINE" ]; then
+  echo "No baseline at $BASELINE; run 'make bench-baseline' to record one."
+  exit 0
+fi
+
+awk -v threshold="$THRESHOLD" '
+  function field(line, key,   n, i, kv, parts) {
+    n = split(line, parts, " ")
+    for (i = 1; i <= n; i++) {
+      split(parts[i], kv, "=")
+      if (kv[1] == key) return kv[2]
+    }
+    return ""
+  }
+  $1 != "bench" { next }
+  {
+    key = field($0, "name") "/" field($0, "size")
+    avg = field($0, "avg") + 0
+  }
+  FNR == NR { base[key] = avg; next }
+  {
+    if (!(key in base)) { printf "  new   %-24s avg=%d\n", key, avg; next }
+    delta = base[key] ? (avg - base[key]) * 100.0 / base[key] : 0
+    status = delta > threshold ? "SLOW" : "ok"
+    if (status == "SLOW") regressions++
+    printf "  %-5s %-24s avg=%d base=%d (%+.1f%%)\n", status, key, avg, base[key], delta
+  }
+  END {
+    if (regressions) { printf "❌ %d case(s) regressed by more than %d%%\n", regressions, threshold; exit 1 }
+    print "✅ No regressions beyond " threshold "%"
+  }
+' "$BASELINE" "$OUTPUT"
@@ -0,0 +1,129 @@
+#include "block.h"
+#include "klib.h"
+#include "crc32c.h"
+
+// Registered devices, by name (mount takes one)
+static BlockDevice* devices[MAX_BLOCK_DEVICES];
+
+// Checksum tables handed out to devices as they register
+static unsigned int sum_pool[BLOCK_SUM_POOL];
+static unsigned int sum_pool_used;
+static unsigned char scratch[BLOCK_SIZE];
+
+// A block of the checksum area: the sums of BLOCK_SUMS_PER_BLOCK data
+// blocks, checked by its own sum
+#define SUM_MAGIC 0x4D555342        // "BSUM"
+
+typedef struct {
+    unsigned int magic;
+    unsigned int sum;               // Over the block with this field zeroed
+    unsigned int sums[BLOCK_SUMS_PER_BLOCK];
+} SumBlock;
+
+// Checksum blocks needed behind the data blocks of a device of raw blocks
+static unsigned int sum_blocks(unsigned int raw) {
+    return (raw + BLOCK_SUMS_PER_BLOCK) / (BLOCK_SUMS_PER_BLOCK + 1);
+}
+
+// Returns the device's index, or -1 if the table is full, the name taken,
+// or its checksums cannot be set up: a device is never used unchecked.
+int block_register(BlockDevice* dev) {
+    if (block_find(dev->name)) return -1;
+    for (int i = 0; i < MAX_BLOCK_DEVICES; i++) {
+        if (!devices[i]) {
+            if (!dev->sums) {
+                unsigned int data = dev->blocks - sum_blocks(dev->blocks);
+                if (data > BLOCK_SUM_POOL - sum_pool_used || block_enable_sums(dev, sum_pool + sum_pool_used) < 0) {
+                    return -1;
+                }
+                sum_pool_used += data;
+            }
+            devices[i] = dev;
+            return i;
+        }
+    }
+    return -1;
+}
+
+BlockDevice* block_find(const char* name) {
+    for (int i = 0; i < MAX_BLOCK_DEVICES; i++) {
+        if (devices[i] && strcmp(devices[i]->name, name) == 0) return devices[i];
+    }
+    return 0;
+}
+
+// Registered device i, 0 for an empty slot
+BlockDevice* block_device(int i) {
+    return i >= 0 && i < MAX_BLOCK_DEVICES ? devices[i] : 0;
+}
+
+// Returns 0, -1 on a device error or BLOCK_BAD_SUM if the data read back is
+// not what was written
+int block_read(BlockDevice* dev, unsigned int block, void* buf) {
+    if (block >= dev->blocks || dev->read(dev, block, buf) < 0) return -1;
+    dev->reads++;
+    if (dev->sums && crc32c(0, buf, BLOCK_SIZE) != dev->sums[block]) {
+        dev->sum_errors++;
+        return BLOCK_BAD_SUM;
+    }
+    return 0;
+}
+
+static unsigned int sum_block_sum(const SumBlock* sb) {
+    static const unsigned char zero[4];
+    unsigned int crc = crc32c(0, sb, __builtin_offsetof(SumBlock, sum));
+    crc = crc32c(crc, zero, sizeof(zero));
+    return crc32c(crc, sb->sums, sizeof(sb->sums));
+}
+
+// Store the k'th block of the checksum area behind data blocks, from sums
+static int write_sum_block(BlockDevice* dev, const unsigned int* sums, unsigned int data, unsigned int k) {
+    SumBlock* sb = (SumBlock*)scratch;
+    unsigned int first = k * BLOCK_SUMS_PER_BLOCK;
+    memset(scratch, 0, BLOCK_SIZE);
+    sb->magic = SUM_MAGIC;
+    for (unsigned int j = 0; j < BLOCK_SUMS_PER_BLOCK && first + j < data; j++) sb->sums[j] = sums[first + j];
+    sb->sum = sum_block_sum(sb);
+    return dev->write(dev, data + k, scratch);
+}
+
+// The data block first, then its sum: a crash between the two leaves only
+// that block failing its check
+int block_write(BlockDevice* dev, unsigned int block, const void* buf) {
+    if (block >= dev->blocks || dev->write(dev, block, buf) < 0) return -1;
+    dev->writes++;
+    if (!dev->sums) return 0;
+    dev->sums[block] = crc32c(0, buf, BLOCK_SIZE);
+    return write_sum_block(dev, dev->sums, dev->blocks, block / BLOCK_SUMS_PER_BLOCK);
+}
+
+// Check dev against sums from now on. Its last blocks become the checksum
+// area and dev->blocks shrinks to the data blocks in front of it; sums needs
+// an entry for each. Stored sums are loaded, so data changed while the
+// device was away fails its read. A checksum block never written is made
+// from the current contents (a new device); one that is itself corrupt is
+// remade too, and counted in sum_errors. Returns -1, leaving dev unchecked
+// and its size as it was, if a block cannot be read or written.
+int block_enable_sums(BlockDevice* dev, unsigned int* sums) {
+    unsigned int data = dev->blocks - sum_blocks(dev->blocks);
+    SumBlock* sb = (SumBlock*)scratch;
+    dev->sums = 0;
+    for (unsigned int k = 0; k * BLOCK_SUMS_PER_BLOCK < data; k++) {
+        unsigned int first = k * BLOCK_SUMS_PER_BLOCK;
+        unsigned int n = data - first < BLOCK_SUMS_PER_BLOCK ? data - first : BLOCK_SUMS_PER_BLOCK;
+        if (dev->read(dev, data + k, scratch) < 0) return -1;
+        if (sb->magic == SUM_MAGIC && sb->sum == sum_block_sum(sb)) {
+            memcpy(sums + first, sb->sums, n * sizeof(unsigned int));
+            continue;
+        }
+        if (sb->magic == SUM_MAGIC) dev->sum_errors++;
+        for (unsigned int j = 0; j < n; j++) {
+            if (dev->read(dev, first + j, scratch) < 0) return -1;
+            sums[first + j] = crc32c(0, scratch, BLOCK_SIZE);
+        }
+        if (write_sum_block(dev, sums, data, k) < 0) return -1;
+    }
+    dev->sums = sums;
+    dev->blocks = data;
+    return 0;
+}
@@ -0,0 +1,36 @@
+// Block devices: fixed-size sectors read and written whole. Drivers fill in
+// a BlockDevice and register it; users go through block_read/block_write,
+// which keep a CRC32C of every block and verify it on each read. The sums
+// live in a checksum area at the end of the device, so they outlast it
+// being detached or the machine rebooted; a copy in memory serves reads.
+#ifndef BLOCK_H
+#define BLOCK_H
+
+#define BLOCK_SIZE 512
+#define MAX_BLOCK_DEVICES 4
+#define BLOCK_SUM_POOL 8192      // Checksummed blocks across devices (4 MiB)
+#define BLOCK_SUMS_PER_BLOCK 126  // CRC32Cs in one block of the checksum area
+#define BLOCK_BAD_SUM -2          // block_read: data does not match its checksum
+
+typedef struct BlockDevice {
+    const char* name;
+    unsigned int blocks;      // Capacity in BLOCK_SIZE sectors; once checksummed,
+                              // the data blocks in front of the checksum area
+    // 0 on success, -1 on a bad block number or device error
+    int (*read)(struct BlockDevice* dev, unsigned int block, void* buf);
+    int (*write)(struct BlockDevice* dev, unsigned int block, const void* buf);
+    void* priv;               // Driver state
+    unsigned int reads;       // Blocks transferred, counted by block_read/block_write
+    unsigned int writes;
+    unsigned int* sums;       // CRC32C per block, 0 when not checked
+    unsigned int sum_errors;  // Reads that failed verification
+} BlockDevice;
+
+int block_register(BlockDevice* dev);
+BlockDevice* block_find(const char* name);
+BlockDevice* block_device(int i);
+int block_read(BlockDevice* dev, unsigned int block, void* buf);
+int block_write(BlockDevice* dev, unsigned int block, const void* buf);
+int block_enable_sums(BlockDevice* dev, unsigned int* sums);
+
+#endif
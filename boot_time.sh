@@ -0,0 +1,40 @@
+#!/bin/bash
+# Measure cold boot time of one or more ISOs built with the 'boottime' command
+# line: the kernel prints its rdtsc at kmain entry over COM1 and exits QEMU.
+# Usage: ./boot_time.sh os-image-boottime.iso os-image-lz-boottime.iso
+# RUNS sets the number of boots per image (default 5).
+
+RUNS=${RUNS:-5}
+QEMU=${QEMU:-qemu-system-i386}
+
+if ! command -v "$QEMU" &> /dev/null; then
+  echo "❌ Error: $QEMU not found."
+  exit 1
+fi
+
+printf "%-28s %6s %12s %16s %12s\n" "image" "runs" "iso bytes" "avg kmain tsc" "avg wall ms"
+for iso in "$@"; do
+  if [ ! -f "$iso" ]; then
+    echo "❌ Error: $iso not found."
+    exit 1
+  fi
+  total_ms=0
+  total_tsc=0
+  for ((i = 0; i < RUNS; i++)); do
+    log=$(mktemp)
+    start=$(date +%s%N)
+    "$QEMU" -cdrom "$iso" -display none -no-reboot -serial file:"$log" \
+      -device isa-debug-exit,iobase=0xf4,iosize=0x04
+    end=$(date +%s%N)
+    tsc=$(awk -F= '/^boot tsc=/ {print $2 + 0; exit}' "$log")
+    rm -f "$log"
+    if [ -z "$tsc" ]; then
+      echo "❌ Error: $iso did not reach kmain."
+      exit 1
+    fi
+    total_ms=$((total_ms + (end - start) / 1000000))
+    total_tsc=$((total_tsc + tsc))
+  done
+  printf "%-28s %6d %12d %16d %12d\n" "$iso" "$RUNS" "$(wc -c < "$iso")" \
+    $((total_tsc / RUNS)) $((total_ms / RUNS))
+done
@@ -0,0 +1,61 @@
+#!/bin/bash
+# Build the kernel in each profile and report build time and image size.
+# The compressed image's stub is linked too, so a kernel that grows into
+# the stub's address fails here rather than at boot.
+# When QEMU is installed the bench image is run too, and the average cycles
+# of every case are printed side by side.
+# Usage: ./build_report.sh
+
+CONFIGS=("PROFILE=debug" "PROFILE=release" "PROFILE=release LTO=1")
+NAMES=("debug" "release" "release+lto")
+
+printf "%-12s %10s %12s %12s %10s %10s\n" "profile" "build(s)" "kernel.bin" "kernel.lz4" "text" "bss"
+for i in "${!CONFIGS[@]}"; do
+  make -s clean > /dev/null
+  start=$(date +%s.%N)
+  if ! make -s ${CONFIGS[$i]} kernel.bin > /dev/null 2>&1; then
+    echo "❌ Error: build failed for ${NAMES[$i]}"
+    exit 1
+  fi
+  end=$(date +%s.%N)
+  if ! make -s ${CONFIGS[$i]} kernel_lz.elf > /dev/null 2>&1; then
+    echo "❌ Error: compressed image failed for ${NAMES[$i]}"
+    exit 1
+  fi
+  read -r text data bss _ <<< "$(size kernel.elf | tail -1)"
+  printf "%-12s %10.2f %12d %12d %10d %10d\n" "${NAMES[$i]}" \
+    "$(echo "$end - $start" | bc)" "$(wc -c < kernel.bin)" "$(wc -c < kernel.lz4)" "$text" "$bss"
+
+  if command -v qemu-system-i386 > /dev/null; then
+    make -s ${CONFIGS[$i]} bench > /dev/null 2>&1
+    cp bench_output.txt "bench_output_${NAMES[$i]}.txt" 2>/dev/null
+  fi
+done
+
+if command -v qemu-system-i386 > /dev/null; then
+  echo
+  echo "avg cycles per case:"
+  awk '
+    function field(line, key,   n, i, kv, parts) {
+      n = split(line, parts, " ")
+      for (i = 1; i <= n; i++) { split(parts[i], kv, "="); if (kv[1] == key) return kv[2] }
+      return ""
+    }
+    FNR == 1 { file++; label[file] = FILENAME; sub(/^bench_output_/, "", label[file]); sub(/\.txt$/, "", label[file]) }
+    $1 == "bench" {
+      key = field($0, "name") "/" field($0, "size")
+      if (!(key in seen)) { seen[key] = 1; order[++n] = key }
+      avg[key, file] = field($0, "avg")
+    }
+    END {
+      printf "%-24s", "case"
+      for (f = 1; f <= file; f++) printf " %12s", label[f]
+      printf "\n"
+      for (i = 1; i <= n; i++) {
+        printf "%-24s", order[i]
+        for (f = 1; f <= file; f++) printf " %12s", avg[order[i], f]
+        printf "\n"
+      }
+    }
+  ' bench_output_debug.txt bench_output_release.txt bench_output_release+lto.txt
+fi
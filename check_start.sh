@@ -1,4 +1,3 @@
-
 #!/bin/bash
 
 # Check if kernel.elf exists
@@ -7,14 +6,30 @@ if [ ! -f kernel.elf ]; then
   exit 1
 fi
 
-# Get the address of the 'start' symbol
-start_addr=$(nm kernel.elf | grep ' T start' | awk '{print $1}')
+# GRUB only boots kernels with a multiboot header in the first 8 KiB
+if command -v grub-file &> /dev/null; then
+  if ! grub-file --is-x86-multiboot kernel.elf; then
+    echo "❌ WARNING: kernel.elf has no valid multiboot header!"
+    echo "👉 Keep the .multiboot section first in .text (linker.ld)"
+    exit 1
+  fi
+else
+  offset=$(od -A d -t x4 -N 8192 -v -w4 kernel.elf | awk '$2 == "1badb002" {print $1; exit}')
+  if [ -z "$offset" ]; then
+    echo "❌ WARNING: multiboot magic not found in the first 8 KiB of kernel.elf!"
+    echo "👉 Keep the .multiboot section first in .text (linker.ld)"
+    exit 1
+  fi
+fi
+
+# Get the address of the '_start' symbol and check it lies at or above 1 MiB
+start_addr=$(nm kernel.elf | grep ' T _start$' | awk '{print $1}')
 
-if [ "$start_addr" = "00001000" ]; then
-  echo "✅ Entry point 'start' is correctly placed at 0x1000."
+if [ -n "$start_addr" ] && [ $((16#$start_addr)) -ge $((16#100000)) ]; then
+  echo "✅ Multiboot header found; entry point '_start' at 0x$start_addr."
   exit 0
 else
-  echo "❌ WARNING: 'start' symbol is at 0x$start_addr, expected 0x1000!"
-  echo "👉 Fix by setting ENTRY(start) in linker.ld and ensuring . = 0x1000"
+  echo "❌ WARNING: '_start' symbol is at 0x$start_addr, expected at or above 0x100000!"
+  echo "👉 Fix by setting ENTRY(_start) in linker.ld and ensuring . = 0x100000"
   exit 1
 fi
@@ -0,0 +1,57 @@
+#include "console.h"
+#include "klib.h"
+
+// VGA Display Functions
+void clear_screen() {
+    unsigned short* vga = VGA_TEXT;
+    memsetw(vga, 0x0700, VGA_WIDTH * VGA_HEIGHT); // White on black
+}
+
+void print_string(const char* str, int row, int col) {
+    unsigned short* vga = VGA_TEXT;
+    int index = row * VGA_WIDTH + col;
+    while (*str && index < VGA_WIDTH * VGA_HEIGHT) {
+        vga[index] = 0x0700 | (*str & 0xFF); // Ensure ASCII
+        str++;
+        index++;
+    }
+}
+
+void print_string_with_attr(const char* str, int row, int col, unsigned char attr) {
+    unsigned short* vga = VGA_TEXT;
+    int index = row * VGA_WIDTH + col;
+    while (*str && index < VGA_WIDTH * VGA_HEIGHT) {
+        vga[index] = (attr << 8) | (*str & 0xFF);
+        str++;
+        index++;
+    }
+}
+
+void print_hex_byte(unsigned char value, int row, int col) {
+    unsigned short* vga = VGA_TEXT;
+    const char hex[] = "0123456789ABCDEF";
+    if (row * VGA_WIDTH + col + 1 < VGA_WIDTH * VGA_HEIGHT) {
+        vga[row * VGA_WIDTH + col] = 0x4F00 | hex[(value >> 4) & 0xF];
+        vga[row * VGA_WIDTH + col + 1] = 0x4F00 | hex[value & 0xF];
+    }
+}
+
+void print_number(int value, int row, int col) {
+    char buf[16];
+    int i = 0, temp = value;
+    if (temp == 0) {
+        buf[i++] = '0';
+    } else {
+        while (temp) {
+            buf[i++] = (temp % 10) + '0';
+            temp /= 10;
+        }
+    }
+    buf[i] = 0;
+    for (int j = 0; j < i / 2; j++) {
+        char t = buf[j];
+        buf[j] = buf[i - j - 1];
+        buf[i - j - 1] = t;
+    }
+    print_string(buf, row, col);
+}
@@ -0,0 +1,13 @@
+// VGA Text Console
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include "hal.h"
+
+void clear_screen(void);
+void print_string(const char* str, int row, int col);
+void print_string_with_attr(const char* str, int row, int col, unsigned char attr);
+void print_hex_byte(unsigned char value, int row, int col);
+void print_number(int value, int row, int col);
+
+#endif
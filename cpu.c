@@ -0,0 +1,59 @@
+#include "cpu.h"
+#include "klib.h"
+
+CpuInfo cpu_info;
+FpuStats fpu_stats;
+
+// Names for /proc/cpuinfo, in feature-id order
+static const struct {
+    int feature;
+    const char* name;
+} feature_names[] = {
+    { CPU_FPU, "fpu" }, { CPU_TSC, "tsc" }, { CPU_CMOV, "cmov" }, { CPU_FXSR, "fxsr" },
+    { CPU_SSE, "sse" }, { CPU_SSE2, "sse2" }, { CPU_SSE3, "sse3" }, { CPU_PCLMUL, "pclmul" },
+    { CPU_SSSE3, "ssse3" }, { CPU_SSE41, "sse4_1" }, { CPU_SSE42, "sse4_2" },
+    { CPU_POPCNT, "popcnt" }, { CPU_AVX, "avx" }, { CPU_AVX2, "avx2" },
+};
+
+static void cpuid(unsigned int leaf, unsigned int* a, unsigned int* b, unsigned int* c, unsigned int* d) {
+    asm volatile("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(0));
+}
+
+void cpu_init() {
+    unsigned int max, a, b, c, d;
+    cpuid(0, &max, &b, &c, &d);
+    memcpy(cpu_info.vendor, &b, 4);
+    memcpy(cpu_info.vendor + 4, &d, 4);
+    memcpy(cpu_info.vendor + 8, &c, 4);
+    cpu_info.vendor[12] = 0;
+    cpuid(1, &a, &b, &c, &d);
+    cpu_info.stepping = a & 0xF;
+    cpu_info.model = (a >> 4) & 0xF;
+    cpu_info.family = (a >> 8) & 0xF;
+    if (cpu_info.family == 0xF) cpu_info.family += (a >> 20) & 0xFF;
+    if (cpu_info.family >= 6) cpu_info.model |= ((a >> 16) & 0xF) << 4;
+    cpu_info.regs[CPU_LEAF1_EDX] = d;
+    cpu_info.regs[CPU_LEAF1_ECX] = c;
+    cpu_info.regs[CPU_LEAF7_EBX] = 0;
+    if (max >= 7) {
+        cpuid(7, &a, &b, &c, &d);
+        cpu_info.regs[CPU_LEAF7_EBX] = b;
+    }
+#ifdef HOST_BUILD
+    cpu_info.sse_enabled = cpu_has(CPU_SSE); // The host OS set it up
+#else
+    cpu_info.sse_enabled = 0; // Until fpu_init
+#endif
+}
+
+int cpu_has(int feature) {
+    return (cpu_info.regs[feature / 32] >> (feature % 32)) & 1;
+}
+
+// Name of the index'th feature this CPU has, 0 past the last
+const char* cpu_feature_name(int index) {
+    for (unsigned int i = 0; i < sizeof(feature_names) / sizeof(feature_names[0]); i++) {
+        if (cpu_has(feature_names[i].feature) && index-- == 0) return feature_names[i].name;
+    }
+    return 0;
+}
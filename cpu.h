@@ -0,0 +1,62 @@
+// CPU features and FPU/SSE state
+// cpu_init probes CPUID once at boot; cpu_has answers from that snapshot.
+// fpu.c (kernel only) enables the FPU and SSE and switches their state
+// lazily: a task's registers are saved only when another task uses them.
+#ifndef CPU_H
+#define CPU_H
+
+// Feature ids: CPUID register and bit
+#define CPU_FEATURE(reg, bit) ((reg) * 32 + (bit))
+#define CPU_LEAF1_EDX 0
+#define CPU_LEAF1_ECX 1
+#define CPU_LEAF7_EBX 2
+#define CPU_REGS 3
+
+#define CPU_FPU    CPU_FEATURE(CPU_LEAF1_EDX, 0)
+#define CPU_TSC    CPU_FEATURE(CPU_LEAF1_EDX, 4)
+#define CPU_CMOV   CPU_FEATURE(CPU_LEAF1_EDX, 15)
+#define CPU_FXSR   CPU_FEATURE(CPU_LEAF1_EDX, 24)
+#define CPU_SSE    CPU_FEATURE(CPU_LEAF1_EDX, 25)
+#define CPU_SSE2   CPU_FEATURE(CPU_LEAF1_EDX, 26)
+#define CPU_SSE3   CPU_FEATURE(CPU_LEAF1_ECX, 0)
+#define CPU_PCLMUL CPU_FEATURE(CPU_LEAF1_ECX, 1)
+#define CPU_SSSE3  CPU_FEATURE(CPU_LEAF1_ECX, 9)
+#define CPU_SSE41  CPU_FEATURE(CPU_LEAF1_ECX, 19)
+#define CPU_SSE42  CPU_FEATURE(CPU_LEAF1_ECX, 20)
+#define CPU_POPCNT CPU_FEATURE(CPU_LEAF1_ECX, 23)
+#define CPU_AVX    CPU_FEATURE(CPU_LEAF1_ECX, 28) // Reported only: no XSAVE, so AVX state is not managed
+#define CPU_AVX2   CPU_FEATURE(CPU_LEAF7_EBX, 5)
+
+#define FPU_STATE_SIZE 512        // FXSAVE image
+
+typedef struct {
+    char vendor[13];              // "GenuineIntel", "AuthenticAMD", ...
+    unsigned int family, model, stepping;
+    unsigned int regs[CPU_REGS];  // Feature words, indexed as above
+    int sse_enabled;              // SSE instructions may execute (CR4.OSFXSR)
+} CpuInfo;
+
+typedef struct {
+    unsigned int traps;           // #NM: first FPU use since a switch
+    unsigned int saves;           // FXSAVEs of another task's state
+    unsigned int restores;        // FXRSTORs into the trapping task
+    unsigned int kernel_uses;     // kernel_fpu_begin sections
+} FpuStats;
+
+extern CpuInfo cpu_info;
+extern FpuStats fpu_stats;
+
+void cpu_init(void);
+int cpu_has(int feature);
+const char* cpu_feature_name(int index);
+
+// fpu.c (kernel only)
+void fpu_init(void);
+int fpu_trap(void);
+void fpu_switch(int next);
+void fpu_reset(int slot);
+void fpu_fork(int parent, int child);
+unsigned int kernel_fpu_begin(void);
+void kernel_fpu_end(unsigned int eflags);
+
+#endif
@@ -0,0 +1,66 @@
+#include "crc32c.h"
+#include "cpu.h"
+
+// Reflected polynomial 0x1EDC6F41. table[0] is the classic byte table;
+// table[k][b] is the CRC of byte b followed by k zero bytes, so slice-by-8
+// folds eight bytes with eight independent lookups.
+#define CRC32C_POLY 0x82F63B78u
+
+typedef unsigned int __attribute__((may_alias)) word_alias;
+
+static unsigned int table[8][256];
+int crc32c_has_hw = 0;
+
+void crc32c_init() {
+    for (unsigned int b = 0; b < 256; b++) {
+        unsigned int crc = b;
+        for (int k = 0; k < 8; k++) crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        table[0][b] = crc;
+    }
+    for (unsigned int b = 0; b < 256; b++) {
+        for (int k = 1; k < 8; k++) table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
+    }
+    crc32c_has_hw = cpu_has(CPU_SSE42);
+}
+
+// One table lookup per byte: the baseline the other paths are measured against
+unsigned int crc32c_byte(unsigned int crc, const void* buf, size_t len) {
+    const unsigned char* p = (const unsigned char*)buf;
+    crc = ~crc;
+    while (len--) crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xFF];
+    return ~crc;
+}
+
+unsigned int crc32c_sw(unsigned int crc, const void* buf, size_t len) {
+    const unsigned char* p = (const unsigned char*)buf;
+    crc = ~crc;
+    for (; len && ((unsigned long)p & 3); len--) crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xFF];
+    for (; len >= 8; len -= 8, p += 8) {
+        unsigned int lo = *(const word_alias*)p ^ crc;
+        unsigned int hi = *(const word_alias*)(p + 4);
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^
+              table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+              table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^
+              table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+    }
+    while (len--) crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xFF];
+    return ~crc;
+}
+
+// The crc32 instruction works on general registers: no FPU state involved
+unsigned int crc32c_hw(unsigned int crc, const void* buf, size_t len) {
+    const unsigned char* p = (const unsigned char*)buf;
+    crc = ~crc;
+    for (; len && ((unsigned long)p & 3); len--) asm("crc32b %1, %0" : "+r"(crc) : "m"(*p++));
+    for (; len >= 8; len -= 8, p += 8) {
+        asm("crc32l %1, %0" : "+r"(crc) : "m"(*(const word_alias*)p));
+        asm("crc32l %1, %0" : "+r"(crc) : "m"(*(const word_alias*)(p + 4)));
+    }
+    for (; len >= 4; len -= 4, p += 4) asm("crc32l %1, %0" : "+r"(crc) : "m"(*(const word_alias*)p));
+    while (len--) asm("crc32b %1, %0" : "+r"(crc) : "m"(*p++));
+    return ~crc;
+}
+
+unsigned int crc32c(unsigned int crc, const void* buf, size_t len) {
+    return crc32c_has_hw ? crc32c_hw(crc, buf, len) : crc32c_sw(crc, buf, len);
+}
@@ -0,0 +1,19 @@
+// CRC32C (Castagnoli): the checksum of stored blocks and journal records
+// crc32c picks the fastest path once crc32c_init has run: the SSE4.2 crc32
+// instruction when CPUID reports it, slice-by-8 tables otherwise. Pass 0 to
+// start and the previous result to continue over more data.
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include "klib.h"
+
+void crc32c_init(void);
+unsigned int crc32c(unsigned int crc, const void* buf, size_t len);
+
+// The individual paths, for tests and benchmarks. crc32c_hw needs SSE4.2.
+extern int crc32c_has_hw;
+unsigned int crc32c_byte(unsigned int crc, const void* buf, size_t len);
+unsigned int crc32c_sw(unsigned int crc, const void* buf, size_t len);
+unsigned int crc32c_hw(unsigned int crc, const void* buf, size_t len);
+
+#endif
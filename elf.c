@@ -0,0 +1,66 @@
+#include "elf.h"
+#include "paging.h"
+#include "pmm.h"
+#include "klib.h"
+
+// Back [start, end) with zeroed user pages. Pages an earlier segment already
+// mapped are kept and only gain write access if this segment needs it.
+static int map_segment(unsigned int* page_dir, unsigned int start, unsigned int end, unsigned int flags) {
+    for (unsigned int page = start & ~0xFFF; page < end; page += PAGE_SIZE) {
+        unsigned int pte = paging_lookup(page_dir, page);
+        if (pte & PAGE_PRESENT) {
+            if (paging_map(page_dir, page, pte, (pte & 0xFFF) | flags) < 0) return -1;
+            continue;
+        }
+        unsigned int frame = frame_alloc();
+        if (!frame) return -1;
+        memset((void*)frame, 0, PAGE_SIZE);
+        if (paging_map(page_dir, page, frame, flags) < 0) {
+            frame_free(frame);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Copy file bytes into the target address space through the identity map
+static void copy_segment(unsigned int* page_dir, unsigned int vaddr, const unsigned char* src, unsigned int len) {
+    while (len) {
+        unsigned int chunk = PAGE_SIZE - (vaddr & 0xFFF);
+        if (chunk > len) chunk = len;
+        unsigned char* dst = (unsigned char*)((paging_lookup(page_dir, vaddr) & ~0xFFF) + (vaddr & 0xFFF));
+        memcpy(dst, src, chunk);
+        vaddr += chunk;
+        src += chunk;
+        len -= chunk;
+    }
+}
+
+// Map the PT_LOAD segments of a static i386 executable into page_dir (a
+// fresh create_user_page_dir). Segments must lie between USER_BASE and the
+// user stack. On failure the caller frees page_dir with whatever was mapped.
+int elf_load(const unsigned char* image, unsigned int size, unsigned int* page_dir, unsigned int* entry) {
+    const Elf32Header* header = (const Elf32Header*)image;
+    if (size < sizeof(Elf32Header) || *(const unsigned int*)header->ident != ELF_MAGIC) return -1;
+    if (header->ident[4] != ELF_CLASS32 || header->ident[5] != ELF_DATA_LSB) return -1;
+    if (header->type != ELF_TYPE_EXEC || header->machine != ELF_MACHINE_386) return -1;
+    if (header->phentsize != sizeof(Elf32ProgramHeader) || header->phoff > size ||
+        header->phnum > (size - header->phoff) / sizeof(Elf32ProgramHeader)) return -1;
+
+    const unsigned int user_end = USER_STACK_TOP - USER_STACK_PAGES * PAGE_SIZE;
+    const Elf32ProgramHeader* ph = (const Elf32ProgramHeader*)(image + header->phoff);
+    int loaded = 0;
+    for (int i = 0; i < header->phnum; i++) {
+        if (ph[i].type != ELF_PT_LOAD || ph[i].memsz == 0) continue;
+        unsigned int start = ph[i].vaddr;
+        if (start < USER_BASE || start >= user_end || ph[i].memsz > user_end - start) return -1;
+        if (ph[i].filesz > ph[i].memsz || ph[i].offset > size || ph[i].filesz > size - ph[i].offset) return -1;
+        unsigned int flags = PAGE_USER | PAGE_PRESENT | (ph[i].flags & ELF_PF_W ? PAGE_WRITE : 0);
+        if (map_segment(page_dir, start, start + ph[i].memsz, flags) < 0) return -1;
+        copy_segment(page_dir, start, image + ph[i].offset, ph[i].filesz);
+        loaded++;
+    }
+    if (!loaded || !(paging_lookup(page_dir, header->entry) & PAGE_USER)) return -1;
+    *entry = header->entry;
+    return 0;
+}
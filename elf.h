@@ -0,0 +1,43 @@
+// ELF32 executable loader
+#ifndef ELF_H
+#define ELF_H
+
+#define ELF_MAGIC 0x464C457F   // "\x7FELF" read as a little-endian word
+#define ELF_CLASS32 1
+#define ELF_DATA_LSB 1
+#define ELF_TYPE_EXEC 2
+#define ELF_MACHINE_386 3
+#define ELF_PT_LOAD 1
+#define ELF_PF_W 2
+
+typedef struct {
+    unsigned char ident[16];
+    unsigned short type;
+    unsigned short machine;
+    unsigned int version;
+    unsigned int entry;
+    unsigned int phoff;
+    unsigned int shoff;
+    unsigned int flags;
+    unsigned short ehsize;
+    unsigned short phentsize;
+    unsigned short phnum;
+    unsigned short shentsize;
+    unsigned short shnum;
+    unsigned short shstrndx;
+} __attribute__((packed)) Elf32Header;
+
+typedef struct {
+    unsigned int type;
+    unsigned int offset;
+    unsigned int vaddr;
+    unsigned int paddr;
+    unsigned int filesz;
+    unsigned int memsz;
+    unsigned int flags;
+    unsigned int align;
+} __attribute__((packed)) Elf32ProgramHeader;
+
+int elf_load(const unsigned char* image, unsigned int size, unsigned int* page_dir, unsigned int* entry);
+
+#endif
@@ -0,0 +1,142 @@
+#include "cpu.h"
+#include "hal.h"
+#include "sched.h"
+#include "klib.h"
+
+// Lazy FPU/SSE switching
+// The registers hold the state of fpu_owner (or of nobody, -1) until
+// another task needs them. task_switch sets CR0.TS when the next task is
+// not the owner, so its first FPU or SSE instruction raises #NM; the trap
+// saves the owner's state, loads the task's own and makes it the owner.
+// Tasks that never use the FPU never trap and cost no save or restore.
+#define CR0_MP (1 << 1)
+#define CR0_EM (1 << 2)
+#define CR0_TS (1 << 3)
+#define CR0_NE (1 << 5)
+#define CR4_OSFXSR     (1 << 9)
+#define CR4_OSXMMEXCPT (1 << 10)
+
+#define FCW_DEFAULT   0x037F      // All x87 exceptions masked, 64-bit precision
+#define MXCSR_DEFAULT 0x1F80      // All SSE exceptions masked, round to nearest
+
+static unsigned char fpu_state[MAX_PROCESSES][FPU_STATE_SIZE] __attribute__((aligned(16)));
+static unsigned char fpu_fresh[FPU_STATE_SIZE] __attribute__((aligned(16)));
+static int fpu_valid[MAX_PROCESSES];  // fpu_state holds the task's registers
+static int fpu_owner = -1;
+static int fpu_enabled = 0;
+
+static inline void clts() {
+    asm volatile("clts" : : : "memory");
+}
+
+static inline void stts() {
+    unsigned int cr0;
+    asm volatile("mov %%cr0, %0" : "=r"(cr0));
+    asm volatile("mov %0, %%cr0" : : "r"(cr0 | CR0_TS) : "memory");
+}
+
+static inline void fxsave(unsigned char* area) {
+    asm volatile("fxsave (%0)" : : "r"(area) : "memory");
+}
+
+static inline void fxrstor(const unsigned char* area) {
+    asm volatile("fxrstor (%0)" : : "r"(area) : "memory");
+}
+
+// Save the owner's registers so that someone else can use them
+static void fpu_save_owner() {
+    if (fpu_owner < 0) return;
+    fxsave(fpu_state[fpu_owner]);
+    fpu_valid[fpu_owner] = 1;
+    fpu_owner = -1;
+    fpu_stats.saves++;
+}
+
+// Enable the x87 FPU natively (#MF rather than IRQ 13) and SSE with its
+// exceptions, then set TS so the first use traps. Without FXSR and SSE
+// the FPU stays off and any use faults like an invalid instruction.
+void fpu_init() {
+    if (!cpu_has(CPU_FPU) || !cpu_has(CPU_FXSR) || !cpu_has(CPU_SSE)) return;
+    unsigned int cr0, cr4;
+    asm volatile("mov %%cr0, %0" : "=r"(cr0));
+    asm volatile("mov %0, %%cr0" : : "r"((cr0 & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE));
+    asm volatile("mov %%cr4, %0" : "=r"(cr4));
+    asm volatile("mov %0, %%cr4" : : "r"(cr4 | CR4_OSFXSR | CR4_OSXMMEXCPT));
+    // What a task starts with: empty x87 stack, zeroed registers, defaults
+    unsigned short fcw = FCW_DEFAULT;
+    unsigned int mxcsr = MXCSR_DEFAULT;
+    memcpy(fpu_fresh, &fcw, sizeof(fcw));
+    memcpy(fpu_fresh + 24, &mxcsr, sizeof(mxcsr));
+    fpu_owner = -1;
+    fpu_enabled = 1;
+    cpu_info.sse_enabled = 1;
+    stts();
+}
+
+// #NM handler (from fault_handler): hand the registers to the running
+// task. Returns 0 if the FPU is not enabled, so the trap is a real fault.
+int fpu_trap() {
+    if (!fpu_enabled) return 0;
+    clts();
+    int slot = current_process;
+    if (fpu_owner != slot) {
+        fpu_save_owner();
+        int own = slot != IDLE_PROCESS && fpu_valid[slot];
+        fxrstor(own ? fpu_state[slot] : fpu_fresh);
+        if (own) fpu_stats.restores++;
+        fpu_owner = slot;
+    }
+    fpu_stats.traps++;
+    return 1;
+}
+
+// task_switch: next runs with the registers only if they are already its own
+void fpu_switch(int next) {
+    if (!fpu_enabled) return;
+    if (next == fpu_owner) {
+        clts();
+    } else {
+        stts();
+    }
+}
+
+// A new task, or a program replaced by exec, starts from the fresh state
+void fpu_reset(int slot) {
+    fpu_valid[slot] = 0;
+    if (fpu_owner == slot) {
+        fpu_owner = -1;
+        stts();
+    }
+}
+
+// fork: the child starts with a copy of the parent's registers
+void fpu_fork(int parent, int child) {
+    if (!fpu_enabled) return;
+    if (fpu_owner == parent) {
+        clts(); // Parent is running, but TS may be set after a kernel section
+        fxsave(fpu_state[parent]);
+        fpu_valid[parent] = 1;
+    }
+    if (fpu_valid[parent]) {
+        memcpy(fpu_state[child], fpu_state[parent], FPU_STATE_SIZE);
+        fpu_valid[child] = 1;
+    }
+}
+
+// Bracket kernel SSE code. The task registers are saved first and TS is
+// set again at the end, so the next task use traps and restores them.
+// Runs with interrupts disabled; returns the flags for kernel_fpu_end.
+unsigned int kernel_fpu_begin() {
+    unsigned int eflags = irq_save();
+    if (fpu_enabled) {
+        clts();
+        fpu_save_owner();
+        fpu_stats.kernel_uses++;
+    }
+    return eflags;
+}
+
+void kernel_fpu_end(unsigned int eflags) {
+    if (fpu_enabled) stts();
+    irq_restore(eflags);
+}
@@ -0,0 +1,63 @@
+#include "gdt.h"
+#include "klib.h"
+
+// 32-bit TSS. Only ss0/esp0 are used: the CPU loads them on every
+// ring 3 -> ring 0 transition; task switching itself is done in software.
+typedef struct {
+    unsigned int prev_tss, esp0, ss0, esp1, ss1, esp2, ss2;
+    unsigned int cr3, eip, eflags, eax, ecx, edx, ebx, esp, ebp, esi, edi;
+    unsigned int es, cs, ss, ds, fs, gs, ldt;
+    unsigned short trap, iomap_base;
+} __attribute__((packed)) TaskStateSegment;
+
+static unsigned long long gdt[6] __attribute__((aligned(8)));
+static TaskStateSegment tss;
+
+static unsigned long long gdt_entry(unsigned int base, unsigned int limit,
+                                    unsigned char access, unsigned char flags) {
+    unsigned long long entry = limit & 0xFFFF;
+    entry |= (unsigned long long)(base & 0xFFFFFF) << 16;
+    entry |= (unsigned long long)access << 40;
+    entry |= (unsigned long long)((limit >> 16) & 0xF) << 48;
+    entry |= (unsigned long long)(flags & 0xF) << 52;
+    entry |= (unsigned long long)(base >> 24) << 56;
+    return entry;
+}
+
+// Replace the boot GDT from kernel.asm (same kernel selectors) with one that
+// also has ring 3 segments and the TSS
+void init_gdt() {
+    memset(&tss, 0, sizeof(tss));
+    tss.ss0 = KERNEL_DS;
+    tss.iomap_base = sizeof(tss); // No I/O bitmap: port I/O from ring 3 faults
+
+    gdt[0] = 0;
+    gdt[1] = gdt_entry(0, 0xFFFFF, 0x9A, 0xC); // Kernel code, 4 GiB
+    gdt[2] = gdt_entry(0, 0xFFFFF, 0x92, 0xC); // Kernel data
+    gdt[3] = gdt_entry(0, 0xFFFFF, 0xFA, 0xC); // User code, DPL 3
+    gdt[4] = gdt_entry(0, 0xFFFFF, 0xF2, 0xC); // User data, DPL 3
+    gdt[5] = gdt_entry((unsigned int)&tss, sizeof(tss) - 1, 0x89, 0x0); // Available 32-bit TSS
+
+    struct {
+        unsigned short limit;
+        unsigned int base;
+    } __attribute__((packed)) gdtr = { sizeof(gdt) - 1, (unsigned int)gdt };
+    asm volatile("lgdt %0" : : "m"(gdtr) : "memory");
+    asm volatile(
+        "ljmp $0x08, $1f\n"
+        "1:\n\t"
+        "mov $0x10, %%ax\n\t"
+        "mov %%ax, %%ds\n\t"
+        "mov %%ax, %%es\n\t"
+        "mov %%ax, %%fs\n\t"
+        "mov %%ax, %%gs\n\t"
+        "mov %%ax, %%ss"
+        : : : "eax", "memory"
+    );
+    asm volatile("ltr %w0" : : "r"(TSS_SEL));
+}
+
+// Kernel stack the CPU switches to when the running user task traps
+void tss_set_kernel_stack(unsigned int esp0) {
+    tss.esp0 = esp0;
+}
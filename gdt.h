@@ -0,0 +1,14 @@
+// Segmentation: flat kernel/user segments and the task state segment
+#ifndef GDT_H
+#define GDT_H
+
+#define KERNEL_CS 0x08
+#define KERNEL_DS 0x10
+#define USER_CS   0x1B  // GDT entry 3, RPL 3
+#define USER_DS   0x23  // GDT entry 4, RPL 3
+#define TSS_SEL   0x28
+
+void init_gdt(void);
+void tss_set_kernel_stack(unsigned int esp0);
+
+#endif
@@ -0,0 +1,78 @@
+// Hardware Abstraction Layer
+// Port I/O, timestamp counter, interrupt flag and VGA text memory. Kernel
+// builds use the real instructions; HOST_BUILD routes them to hal_host.c so
+// the portable subsystems (VFS, scheduler, console, serial) run natively.
+#ifndef HAL_H
+#define HAL_H
+
+#define VGA_WIDTH 80
+#define VGA_HEIGHT 25
+#define VGA_BUFFER 0xB8000
+
+// General registers in the order pusha stores them (lowest address first)
+typedef struct {
+    unsigned int edi, esi, ebp, esp, ebx, edx, ecx, eax;
+} Registers;
+
+// Interrupt frame left by the kernel.asm stubs: pusha block, data segment
+// registers, error code (0 for vectors without one), then the CPU's iret
+// frame. user_esp/user_ss exist only when the interrupt came from ring 3.
+typedef struct {
+    Registers regs;
+    unsigned int gs, fs, es, ds;
+    unsigned int err;
+    unsigned int eip, cs, eflags;
+    unsigned int user_esp, user_ss;
+} TrapFrame;
+
+#define EFLAGS_IF 0x200
+
+static inline unsigned long long rdtsc() {
+    unsigned int lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((unsigned long long)hi << 32) | lo;
+}
+
+#ifdef HOST_BUILD
+
+extern unsigned short host_vga[VGA_WIDTH * VGA_HEIGHT];
+#define VGA_TEXT host_vga
+
+void outb(unsigned short port, unsigned char value);
+void outl(unsigned short port, unsigned int value);
+unsigned char inb(unsigned short port);
+unsigned int irq_save(void);
+void irq_restore(unsigned int flags);
+
+#else
+
+#define VGA_TEXT ((unsigned short*)VGA_BUFFER)
+
+static inline void outb(unsigned short port, unsigned char value) {
+    asm volatile("outb %0, %1" : : "a"(value), "Nd"(port));
+}
+
+static inline void outl(unsigned short port, unsigned int value) {
+    asm volatile("outl %0, %1" : : "a"(value), "Nd"(port));
+}
+
+static inline unsigned char inb(unsigned short port) {
+    unsigned char value;
+    asm volatile("inb %1, %0" : "=a"(value) : "Nd"(port));
+    return value;
+}
+
+// Disable interrupts, returning the previous EFLAGS for irq_restore
+static inline unsigned int irq_save() {
+    unsigned int eflags;
+    asm volatile("pushf\n\tpop %0\n\tcli" : "=r"(eflags) : : "memory");
+    return eflags;
+}
+
+static inline void irq_restore(unsigned int eflags) {
+    if (eflags & 0x200) asm volatile("sti" : : : "memory");
+}
+
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+// Host HAL: emulates just enough hardware for the portable subsystems
+// VGA text memory is a plain array, COM1 writes go to stdout and the QEMU
+// debug-exit port ends the process. Page directories come from static memory
+// and task contexts are not built: the host only exercises scheduling policy.
+#include <stdio.h>
+#include <stdlib.h>
+#include "hal.h"
+#include "serial.h"
+#include "paging.h"
+#include "sched.h"
+
+unsigned short host_vga[VGA_WIDTH * VGA_HEIGHT];
+
+void outb(unsigned short port, unsigned char value) {
+    if (port == COM1_PORT) {
+        if (value != '\r') putchar(value);
+    }
+}
+
+void outl(unsigned short port, unsigned int value) {
+    if (port == QEMU_EXIT_PORT) {
+        fflush(stdout);
+        exit((value << 1) | 1);
+    }
+}
+
+unsigned char inb(unsigned short port) {
+    if (port == COM1_PORT + 5) return 0x20; // Transmit holding register empty
+    return 0;
+}
+
+unsigned int irq_save() {
+    return 0;
+}
+
+void irq_restore(unsigned int flags) {
+    (void)flags;
+}
+
+// Paging stubs: same layout as paging.c, backed by static tables
+static unsigned int host_kernel_dir[1024] __attribute__((aligned(PAGE_SIZE)));
+static unsigned int host_user_dir[1024] __attribute__((aligned(PAGE_SIZE)));
+unsigned int* kernel_page_dir = host_kernel_dir;
+
+void init_paging() {
+}
+
+unsigned int* create_user_page_dir() {
+    for (int i = 0; i < 1024; i++) {
+        host_user_dir[i] = 0;
+    }
+    for (int i = 0; i < KERNEL_PDES; i++) {
+        host_user_dir[i] = kernel_page_dir[i];
+    }
+    host_user_dir[768] = kernel_page_dir[768];
+    return host_user_dir;
+}
+
+void free_user_page_dir(unsigned int* page_dir) {
+    (void)page_dir;
+}
+
+unsigned int paging_user_pages(unsigned int* page_dir) {
+    (void)page_dir;
+    return 0;
+}
+
+unsigned int frames_free = 0; // No frame allocator on the host
+
+void proc_init_context(int slot) {
+    (void)slot;
+}
+
+void proc_sleep(const void* chan) {
+    sleep_on(current_process, chan);
+}
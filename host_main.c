@@ -0,0 +1,1135 @@
+// Host test and benchmark driver for the portable kernel subsystems
+// Usage: sebria_host [check|bench|stress [ops]|all]
+//   check   functional checks of the VFS and scheduler
+//   bench   the in-kernel suite (bench.c) over stdout
+//   stress  millions of VFS and scheduler operations, bench-format output
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hal.h"
+#include "klib.h"
+#include "cpu.h"
+#include "crc32c.h"
+#include "vfs.h"
+#include "sched.h"
+#include "pipe.h"
+#include "lock.h"
+#include "paging.h"
+#include "procfs.h"
+#include "bench.h"
+#include "journal.h"
+#include "ramdisk.h"
+#include "shell.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } \
+} while (0)
+
+static void idle_task() {
+}
+
+static void reset_kernel_state() {
+    init_vfs();
+    init_processes();
+    current_process = 0;
+    schedule_flag = 0;
+}
+
+// mem* and strlen against byte loops, over every alignment and the sizes
+// around each path's thresholds, with and without the SSE2 paths
+static void check_klib() {
+    static unsigned char a[1024], b[1024], ref[1024];
+    static const int sizes[] = { 0, 1, 3, 4, 5, 15, 16, 17, 63, 64, 127, 128, 129, 200, 511, 700 };
+    int sse2 = klib_sse2;
+    for (int mode = 0; mode < 2; mode++) {
+        klib_sse2 = mode && sse2;
+        for (unsigned int k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+            int n = sizes[k];
+            for (int da = 0; da < 8; da++) {
+                for (int sa = 0; sa < 8; sa += 3) {
+                    for (int i = 0; i < 1024; i++) a[i] = (unsigned char)(i * 7 + 1), b[i] = ref[i] = 0;
+                    memcpy(b + da, a + sa, n);
+                    for (int i = 0; i < n; i++) ref[da + i] = a[sa + i];
+                    CHECK(memcmp(b, ref, sizeof(b)) == 0);
+                    if (n) {
+                        b[da + n - 1] ^= 1;
+                        CHECK(memcmp(b + da, a + sa, n) != 0);
+                        CHECK((memcmp(b + da, a + sa, n) < 0) == (b[da + n - 1] < a[sa + n - 1]));
+                    }
+
+                    memset(b + da, 0xA5, n);
+                    CHECK(b[da + n] == ref[da + n] && (da == 0 || b[da - 1] == 0));
+                    int filled = 1;
+                    for (int i = 0; i < n; i++) filled &= b[da + i] == 0xA5;
+                    CHECK(filled);
+
+                    // Overlapping both ways
+                    for (int i = 0; i < 1024; i++) b[i] = ref[i] = (unsigned char)i;
+                    memmove(b + 100 + da, b + 100 + sa, n);
+                    for (int i = 0; i < n; i++) {
+                        int from = sa > da ? i : n - 1 - i;
+                        ref[100 + da + from] = (unsigned char)(100 + sa + from);
+                    }
+                    CHECK(memcmp(b, ref, sizeof(b)) == 0);
+                    for (int i = 0; i < 1024; i++) b[i] = (unsigned char)i;
+                    memmove(b + 100 + sa + 9, b + 100 + da, n);
+                    int moved = 1;
+                    for (int i = 0; i < n; i++) moved &= b[100 + sa + 9 + i] == (unsigned char)(100 + da + i);
+                    CHECK(moved);
+                }
+            }
+            for (int i = 0; i < 1024; i++) a[i] = 'x';
+            for (int s0 = 0; s0 < 16; s0++) {
+                a[s0 + n] = 0;
+                CHECK(strlen((const char*)a + s0) == (size_t)n);
+                a[s0 + n] = 'x';
+            }
+        }
+        unsigned short cells[9] = { 0 };
+        memsetw(cells + 1, 0x0741, 7);
+        CHECK(cells[0] == 0 && cells[1] == 0x0741 && cells[7] == 0x0741 && cells[8] == 0);
+    }
+    klib_sse2 = sse2;
+}
+
+// Every CRC32C path against the standard check values and each other, at
+// every alignment and across chained calls
+static void check_crc32c() {
+    static unsigned char buf[600];
+    CHECK(crc32c(0, "123456789", 9) == 0xE3069283);
+    CHECK(crc32c_byte(0, "123456789", 9) == 0xE3069283);
+    CHECK(crc32c_sw(0, "123456789", 9) == 0xE3069283);
+    memset(buf, 0, 32);
+    CHECK(crc32c_sw(0, buf, 32) == 0x8A9136AA);
+    for (int i = 0; i < (int)sizeof(buf); i++) buf[i] = (unsigned char)(i * 37 + (i >> 3));
+    int agree = 1;
+    for (int off = 0; off < 8; off++) {
+        for (int len = 0; len < 80; len += 7) {
+            unsigned int want = crc32c_byte(0, buf + off, len);
+            agree &= crc32c_sw(0, buf + off, len) == want;
+            if (crc32c_has_hw) agree &= crc32c_hw(0, buf + off, len) == want;
+        }
+    }
+    CHECK(agree);
+    unsigned int whole = crc32c(0, buf, sizeof(buf));
+    CHECK(crc32c(crc32c(0, buf, 123), buf + 123, sizeof(buf) - 123) == whole);
+    CHECK(crc32c_byte(0, buf, sizeof(buf)) == whole);
+    buf[300] ^= 0x10;
+    CHECK(crc32c(0, buf, sizeof(buf)) != whole);
+}
+
+static void check_vfs() {
+    char buf[MAX_FILE_SIZE];
+    char out[MAX_FILE_SIZE];
+    reset_kernel_state();
+
+    CHECK(vfs_open_file("missing") == -1);
+    int ino = vfs_create_file("a.txt");
+    CHECK(ino >= 0);
+    CHECK(vfs.files == 1);
+
+    int fd = vfs_open_file("a.txt");
+    CHECK(fd >= 0);
+    for (int i = 0; i < MAX_FILE_SIZE; i++) buf[i] = (char)(i * 7);
+    CHECK(vfs_write_file(fd, buf, 100) == 100);
+    CHECK(vfs_write_file(fd, buf + 100, MAX_FILE_SIZE) == MAX_FILE_SIZE - 100);
+    CHECK(vfs.inodes[ino].size == MAX_FILE_SIZE);
+    vfs_close_file(fd);
+    CHECK(!fds[fd].used);
+
+    fd = vfs_open_file("a.txt");
+    CHECK(vfs_read_file(fd, out, 10) == 10);
+    CHECK(vfs_read_file(fd, out + 10, MAX_FILE_SIZE) == MAX_FILE_SIZE - 10);
+    CHECK(vfs_read_file(fd, out, 1) == 0);
+    int same = 1;
+    for (int i = 0; i < MAX_FILE_SIZE; i++) if (out[i] != buf[i]) same = 0;
+    CHECK(same);
+    CHECK(vfs_delete_file("a.txt") == -1); // still open
+    vfs_close_file(fd);
+    CHECK(vfs_read_file(fd, out, 1) == -1);
+    CHECK(vfs_delete_file("a.txt") == 0);
+    CHECK(vfs.files == 0);
+
+    CHECK(vfs.blocks_free == VFS_BLOCKS);
+
+    // Fill the inode table through a directory
+    CHECK(vfs_mkdir("/big") > 0);
+    CHECK(vfs_mkdir("/big/sub") > 0);
+    CHECK(vfs_mkdir("big") == -1);
+    CHECK(vfs_create_file("/none/x") == -1);
+    int made = 0;
+    char name[24];
+    while (1) {
+        snprintf(name, sizeof(name), "/big/f%d", made);
+        if (vfs_create_file(name) < 0) break;
+        made++;
+    }
+    CHECK(made == MAX_INODES - 3); // Root, big and sub
+    CHECK(vfs_create_file("overflow") == -1);
+
+    // Listings are complete, in creation order
+    Dirent ent;
+    int listed = 0;
+    fd = vfs_opendir("/big");
+    CHECK(vfs_readdir(fd, &ent) == 1 && strcmp(ent.name, "sub") == 0 && ent.type == VFS_DIR);
+    while (vfs_readdir(fd, &ent) == 1) listed++;
+    CHECK(listed == made && strcmp(ent.name, name) != 0);
+    CHECK(vfs_read_file(fd, out, 1) == -1);
+    vfs_close_file(fd);
+    fd = vfs_open_file("/proc/stat");
+    CHECK(vfs_readdir(fd, &ent) == -1);
+    vfs_close_file(fd);
+
+    // Lookups: hashed per component, repeats from the dentry cache
+    unsigned int hits = vfs_stats.dcache_hits;
+    CHECK(vfs_lookup("/big/f12345") == vfs_lookup("big/sub/../f12345"));
+    CHECK(vfs_lookup("/big/f12345") > 0 && vfs_stats.dcache_hits == hits + 1);
+    CHECK(vfs_lookup("/big/nope") == -1);
+    CHECK(vfs_lookup("/big/f1/x") == -1);
+    CHECK(vfs_lookup("/") == VFS_ROOT);
+
+    // A cursor survives removal of the entry under it
+    fd = vfs_opendir("/big");
+    vfs_readdir(fd, &ent);
+    CHECK(vfs_delete_file("/big/f0") == 0);
+    CHECK(vfs_readdir(fd, &ent) == 1 && strcmp(ent.name, "f1") == 0);
+    vfs_close_file(fd);
+
+    // getdents: open() on a directory, batches of whole records, 0 at the end
+    Dirent batch[7];
+    int calls = 0, n;
+    listed = 0;
+    fd = vfs_open_file("/big");
+    while ((n = vfs_getdents(fd, batch, 7)) > 0) {
+        listed += n;
+        calls++;
+    }
+    CHECK(n == 0 && listed == made && calls == (made + 6) / 7); // sub + f1.. after f0 went
+    CHECK(vfs_getdents(fd, batch, 7) == 0);
+
+    // stat by path and by descriptor agree; pipes and /proc have no inode
+    Stat st, fst;
+    CHECK(vfs_stat("/big", &st) == 0 && st.type == VFS_DIR && st.size == made && st.parent == VFS_ROOT);
+    CHECK(vfs_fstat(fd, &fst) == 0 && fst.inode == st.inode);
+    vfs_close_file(fd);
+    CHECK(vfs_stat("/big/nope", &st) == -1);
+    fd = vfs_open_file("/big/f1");
+    vfs_write_file(fd, buf, VFS_BLOCK_SIZE + 1);
+    CHECK(vfs_fstat(fd, &fst) == 0 && fst.size == VFS_BLOCK_SIZE + 1 && fst.blocks == 2);
+    CHECK(vfs_stat("/big/f1", &st) == 0 && st.inode == fst.inode && st.type == VFS_FILE);
+    vfs_close_file(fd);
+    fd = vfs_open_file("/proc/stat");
+    CHECK(vfs_fstat(fd, &fst) == -1 && vfs_getdents(fd, batch, 7) == -1);
+    vfs_close_file(fd);
+
+    // rmdir takes only empty directories; removal drops cached paths
+    CHECK(vfs_rmdir("/big") == -1);
+    CHECK(vfs_delete_file("/big/sub") == -1);
+    CHECK(vfs_lookup("/big/sub") > 0);
+    CHECK(vfs_rmdir("/big/sub") == 0);
+    CHECK(vfs_lookup("/big/sub") == -1);
+    CHECK(vfs_rmdir("/") == -1);
+
+    int opened = 0;
+    while (vfs_open_file("/big/f1") >= 0) opened++;
+    CHECK(opened == MAX_FILES);
+}
+
+// Journal device: writes after disk_fail_after are dropped, as if the
+// machine stopped there
+#define DISK_BLOCKS 64
+static unsigned char disk[DISK_BLOCKS][BLOCK_SIZE];
+static int disk_writes, disk_last, disk_fail_after = -1;
+
+static int disk_read(BlockDevice* dev, unsigned int block, void* buf) {
+    if (block >= dev->blocks) return -1;
+    memcpy(buf, disk[block], BLOCK_SIZE);
+    return 0;
+}
+
+static int disk_write(BlockDevice* dev, unsigned int block, const void* buf) {
+    if (block >= dev->blocks) return -1;
+    if (disk_fail_after >= 0 && disk_writes >= disk_fail_after) return 0;
+    disk_writes++;
+    disk_last = block;
+    memcpy(disk[block], buf, BLOCK_SIZE);
+    return 0;
+}
+
+static BlockDevice test_disk = { "disk0", DISK_BLOCKS, disk_read, disk_write, 0 };
+
+// Read a whole file into out; returns its size or -1
+static int slurp(const char* path, char* out) {
+    int fd = vfs_open_file(path);
+    if (fd < 0) return -1;
+    int n = vfs_read_file(fd, out, MAX_FILE_SIZE);
+    vfs_close_file(fd);
+    return n;
+}
+
+static void check_journal() {
+    char buf[MAX_FILE_SIZE], out[MAX_FILE_SIZE];
+    for (int i = 0; i < MAX_FILE_SIZE; i++) buf[i] = (char)(i * 13 + 1);
+    memset(disk, 0, sizeof(disk));
+    reset_kernel_state();
+
+    // Mounting a blank device formats it and snapshots what exists already
+    CHECK(vfs_create_file("pre") >= 0);
+    CHECK(vfs_mount(&test_disk) == 0 && journal_attached());
+    CHECK(strcmp(vfs.device, "disk0") == 0 && !vfs_dirty());
+
+    // Group commit: 100 small writes go out as one short sequential run
+    CHECK(vfs_mkdir("/d") > 0);
+    CHECK(vfs_create_file("/d/x") > 0);
+    int fd = vfs_open_file("/d/x");
+    for (int i = 0; i < 100; i++) CHECK(vfs_write_file(fd, buf + i * 10, 10) == 10);
+    vfs_close_file(fd);
+    CHECK(vfs_dirty());
+    unsigned int commits = journal_stats.commits;
+    int writes = disk_writes;
+    int blocks = vfs_sync();
+    CHECK(blocks > 0 && blocks <= 6 && disk_writes == writes + blocks);
+    CHECK(journal_stats.commits == commits + 1 && !vfs_dirty());
+
+    // Crash after the first block of a two-block commit: it is not replayed
+    CHECK(vfs_delete_file("pre") == 0);
+    fd = vfs_open_file("/d/x");
+    CHECK(vfs_write_file(fd, buf + 1000, 600) == 600);
+    vfs_close_file(fd);
+    disk_fail_after = disk_writes + 1;
+    CHECK(vfs_sync() == 2);
+    disk_fail_after = -1;
+    reset_kernel_state();
+    CHECK(!journal_attached() && vfs_lookup("/d/x") == -1);
+    CHECK(vfs_mount(&test_disk) == 0);
+    CHECK(vfs_lookup("pre") > 0 && slurp("/d/x", out) == 1000 && memcmp(out, buf, 1000) == 0);
+
+    // A corrupt block ends replay before its transaction
+    CHECK(vfs_create_file("/d/y") > 0);
+    CHECK(vfs_sync() == 1);
+    disk[disk_last][BLOCK_SIZE - 1] ^= 1;
+    reset_kernel_state();
+    CHECK(vfs_mount(&test_disk) == 0);
+    CHECK(vfs_lookup("/d/y") == -1 && vfs_lookup("/d/x") > 0);
+
+    // A malformed record with a good checksum is rejected with its whole
+    // transaction, and replay stops there: a create followed by a write at a
+    // negative offset, then a record with a negative path length
+    struct { short type, path_len; int offset, len; } rec; // vfs.c's JournalRecord
+    char raw[sizeof(rec) + 8 + 4];
+    int bad_offsets[] = { -512, 0 }, bad_paths[] = { 4, -1 };
+    for (int k = 0; k < 2; k++) {
+        unsigned int replayed = journal_stats.replayed;
+        rec.type = 1; // J_CREATE
+        rec.path_len = 4;
+        rec.offset = rec.len = 0;
+        memcpy(raw, &rec, sizeof(rec));
+        memcpy(raw + sizeof(rec), "/d/z", 4);
+        CHECK(journal_append(raw, sizeof(rec) + 4) == 0);
+        rec.type = 5; // J_WRITE
+        rec.path_len = bad_paths[k];
+        rec.offset = bad_offsets[k];
+        rec.len = 4;
+        memcpy(raw, &rec, sizeof(rec));
+        memcpy(raw + sizeof(rec), "/d/zdata", 8);
+        CHECK(journal_append(raw, sizeof(rec) + 8) == 0);
+        CHECK(vfs_sync() == 1);
+        CHECK(vfs_create_file("/d/w") > 0 && vfs_sync() == 1);
+        reset_kernel_state();
+        CHECK(vfs_mount(&test_disk) == 0 && journal_stats.replayed > replayed);
+        CHECK(vfs_lookup("/d/z") == -1 && vfs_lookup("/d/w") == -1 && vfs_lookup("/d/x") > 0);
+    }
+    CHECK(vfs_create_file("/d/v") > 0 && vfs_sync() == 1); // Overwrites the rejected one
+    reset_kernel_state();
+    CHECK(vfs_mount(&test_disk) == 0 && vfs_lookup("/d/v") > 0 && vfs_lookup("/d/x") > 0);
+    CHECK(vfs_delete_file("/d/v") == 0);
+
+    // A write starting past the end of its file is dropped, so replay never
+    // leaves a file with holes to read through
+    rec.type = 1; // J_CREATE
+    rec.path_len = 4;
+    rec.offset = rec.len = 0;
+    memcpy(raw, &rec, sizeof(rec));
+    memcpy(raw + sizeof(rec), "/d/h", 4);
+    CHECK(journal_append(raw, sizeof(rec) + 4) == 0);
+    rec.type = 5; // J_WRITE
+    rec.offset = 2048;
+    rec.len = 4;
+    memcpy(raw, &rec, sizeof(rec));
+    memcpy(raw + sizeof(rec), "/d/hdata", 8);
+    CHECK(journal_append(raw, sizeof(rec) + 8) == 0);
+    CHECK(vfs_sync() == 1);
+    reset_kernel_state();
+    CHECK(vfs_mount(&test_disk) == 0 && vfs_lookup("/d/h") > 0 && slurp("/d/h", out) == 0);
+    CHECK(vfs_delete_file("/d/h") == 0);
+
+    // Filling a region switches to a snapshot in the other one
+    unsigned int checkpoints = journal_stats.checkpoints;
+    for (int i = 0; i < 40; i++) {
+        fd = vfs_open_file("/d/x");
+        CHECK(vfs_write_file(fd, buf + i, 1000) == 1000);
+        vfs_close_file(fd);
+        CHECK(vfs_sync() > 0);
+    }
+    CHECK(journal_stats.checkpoints > checkpoints);
+    reset_kernel_state();
+    CHECK(vfs_mount(&test_disk) == 0);
+    CHECK(slurp("/d/x", out) == 1000 && memcmp(out, buf + 39, 1000) == 0);
+    CHECK(vfs_lookup("pre") > 0 && vfs.files == 2);
+
+    // Filling it between syncs leaves the snapshot to the next sync
+    checkpoints = journal_stats.checkpoints;
+    for (int i = 0; i < 200; i++) {
+        fd = vfs_open_file("/d/x");
+        CHECK(vfs_write_file(fd, buf + i, 1000) == 1000);
+        vfs_close_file(fd);
+    }
+    CHECK(journal_stats.checkpoints == checkpoints && vfs_dirty());
+    CHECK(vfs_sync() > 0 && journal_stats.checkpoints == checkpoints + 1 && !vfs_dirty());
+    reset_kernel_state();
+    CHECK(vfs_mount(&test_disk) == 0);
+    CHECK(slurp("/d/x", out) == 1000 && memcmp(out, buf + 199, 1000) == 0);
+
+    // A registered RAM disk mounts by name and keeps the tree across remounts
+    static char ram[256 * BLOCK_SIZE];
+    static RamDisk rd;
+    ramdisk_init(&rd, "ram0", ram, 256);
+    CHECK(block_register(&rd.dev) >= 0 && block_register(&rd.dev) == -1);
+    CHECK(block_find("ram0") == &rd.dev && block_find("ram1") == 0);
+    CHECK(vfs_mount(block_find("ram0")) == -1); // disk0 is still mounted
+    CHECK(vfs_unmount() == 0 && !journal_attached() && vfs_unmount() == -1);
+    reset_kernel_state();
+    CHECK(vfs_mkdir("/tmp") > 0 && vfs_create_file("/tmp/t") > 0);
+    CHECK(vfs_mount(&rd.dev) == 0 && strcmp(vfs.device, "ram0") == 0);
+    fd = vfs_open_file("/tmp/t");
+    CHECK(vfs_write_file(fd, buf, 700) == 700);
+    vfs_close_file(fd);
+    CHECK(vfs_unmount() == 0 && rd.dev.writes > 0);
+    reset_kernel_state();
+    CHECK(vfs_mount(&rd.dev) == 0 && rd.dev.reads > 0);
+    CHECK(slurp("/tmp/t", out) == 700 && memcmp(out, buf, 700) == 0);
+    fd = vfs_open_file("/proc/blocks");
+    int n = vfs_read_file(fd, out, sizeof(out) - 1);
+    vfs_close_file(fd);
+    out[n > 0 ? n : 0] = 0;
+    CHECK(strncmp(out, "ram0 253 ", 9) == 0); // 3 blocks hold the checksums
+
+    // Registered devices are checksummed: data changed behind the block
+    // layer fails its read
+    CHECK(rd.dev.sums && block_read(&rd.dev, 0, out) == 0);
+    ram[100] ^= 1;
+    CHECK(block_read(&rd.dev, 0, out) == BLOCK_BAD_SUM && rd.dev.sum_errors == 1);
+    ram[100] ^= 1;
+    CHECK(block_write(&rd.dev, 0, out) == 0 && block_read(&rd.dev, 0, out) == 0);
+
+    // The sums are kept on the device: attached again, as after a reboot, it
+    // loads them rather than trusting its contents, so a block changed while
+    // it was away fails its read
+    static unsigned int sums[256];
+    static RamDisk again;
+    ram[100] ^= 1;
+    ramdisk_init(&again, "again", ram, 256);
+    CHECK(block_enable_sums(&again.dev, sums) == 0 && again.dev.blocks == 253);
+    CHECK(block_read(&again.dev, 0, out) == BLOCK_BAD_SUM && block_read(&again.dev, 1, out) == 0);
+    ram[100] ^= 1;
+    CHECK(block_read(&again.dev, 0, out) == 0);
+
+    // A corrupt checksum block is remade from the data and counted; a device
+    // whose sums do not fit in the pool is not registered at all
+    ram[253 * BLOCK_SIZE + 20] ^= 1;
+    ramdisk_init(&again, "again", ram, 256);
+    CHECK(block_enable_sums(&again.dev, sums) == 0 && again.dev.sum_errors == 1);
+    CHECK(block_read(&again.dev, 0, out) == 0);
+    ramdisk_init(&again, "big", ram, BLOCK_SUM_POOL * 2);
+    CHECK(block_register(&again.dev) == -1 && block_find("big") == 0);
+    reset_kernel_state();
+}
+
+// Write a file in chunks of n bytes, as a program saving it would
+static void put_file(const char* path, const char* data, int len, int n) {
+    int fd = vfs_open_file(path);
+    for (int off = 0; off < len; off += n) vfs_write_file(fd, data + off, len - off < n ? len - off : n);
+    vfs_close_file(fd);
+}
+
+static void check_compress() {
+    static char text[MAX_FILE_SIZE], noise[MAX_FILE_SIZE], out[MAX_FILE_SIZE];
+    Stat st;
+    for (int i = 0; i < MAX_FILE_SIZE; i++) text[i] = "compressible text "[i % 18];
+    for (unsigned int i = 0, x = 1; i < MAX_FILE_SIZE; i++) noise[i] = (char)((x = x * 1103515245u + 12345) >> 24);
+    memset(disk, 0, sizeof(disk));
+    reset_kernel_state();
+
+    // Text stored compressed takes fewer blocks and reads back the same
+    int free_before = vfs.blocks_free;
+    CHECK(vfs_create_file("t") > 0 && vfs_compress("t", 1) == 0);
+    put_file("t", text, MAX_FILE_SIZE, 100);
+    CHECK(vfs_stat("t", &st) == 0 && st.size == MAX_FILE_SIZE && st.blocks == 1);
+    CHECK(vfs.blocks_free == free_before - 1);
+    CHECK(slurp("t", out) == MAX_FILE_SIZE && memcmp(out, text, MAX_FILE_SIZE) == 0);
+
+    // Data LZ4 cannot shrink stays raw; switching back restores the layout
+    CHECK(vfs_create_file("n") > 0 && vfs_compress("n", 1) == 0);
+    put_file("n", noise, 3000, 512);
+    CHECK(vfs_stat("n", &st) == 0 && st.blocks == 6);
+    CHECK(slurp("n", out) == 3000 && memcmp(out, noise, 3000) == 0);
+    CHECK(vfs_compress("t", 0) == 0 && vfs_stat("t", &st) == 0 && st.blocks == FILE_BLOCKS);
+    CHECK(slurp("t", out) == MAX_FILE_SIZE && memcmp(out, text, MAX_FILE_SIZE) == 0);
+    CHECK(vfs_compress("t", 1) == 0 && vfs_stat("t", &st) == 0 && st.blocks == 1);
+    CHECK(vfs_compress("/", 1) == -1 && vfs_compress("missing", 1) == -1);
+
+    // More files in use than cache slots: each is written back on eviction
+    char name[] = "z0";
+    for (int f = 0; f < 8; f++) {
+        name[1] = '0' + f;
+        CHECK(vfs_create_file(name) > 0 && vfs_compress(name, 1) == 0);
+    }
+    int fds_open[8];
+    for (int f = 0; f < 8; f++) {
+        name[1] = '0' + f;
+        fds_open[f] = vfs_open_file(name);
+    }
+    for (int round = 0; round < 4; round++) {
+        for (int f = 0; f < 8; f++) CHECK(vfs_write_file(fds_open[f], text + f, 1000) == 1000);
+    }
+    for (int f = 0; f < 8; f++) vfs_close_file(fds_open[f]);
+    for (int f = 0; f < 8; f++) {
+        name[1] = '0' + f;
+        CHECK(slurp(name, out) == 4000 && memcmp(out, text + f, 1000) == 0 && memcmp(out + 3000, text + f, 1000) == 0);
+        CHECK(vfs_stat(name, &st) == 0 && st.blocks == 1);
+    }
+    CHECK(vfs_stats.zcache_misses > 8 && vfs_stats.zcache_writebacks > 8);
+
+    // Deleting frees the compressed blocks; mode and data survive a remount
+    for (int f = 0; f < 8; f++) {
+        name[1] = '0' + f;
+        int free_now = vfs.blocks_free;
+        if (f != 3) CHECK(vfs_delete_file(name) == 0 && vfs.blocks_free == free_now + 1);
+    }
+    CHECK(vfs_mount(&test_disk) == 0 && vfs_sync() >= 0);
+    reset_kernel_state();
+    CHECK(vfs_mount(&test_disk) == 0);
+    CHECK(vfs_stat("t", &st) == 0 && st.blocks == 1 && vfs_stat("n", &st) == 0 && st.blocks == 6);
+    CHECK(slurp("t", out) == MAX_FILE_SIZE && memcmp(out, text, MAX_FILE_SIZE) == 0);
+    CHECK(slurp("z3", out) == 4000 && memcmp(out + 2000, text + 3, 1000) == 0);
+
+    // Truncation frees the blocks past the new end, raw or compressed, and
+    // is replayed on a remount. An open file cannot be cut, nor grown.
+    CHECK(vfs_create_file("r") > 0);
+    put_file("r", text, 3000, 512);
+    int free_now = vfs.blocks_free;
+    CHECK(vfs_truncate("r", 700) == 0 && vfs.blocks_free == free_now + 4);
+    CHECK(vfs_stat("r", &st) == 0 && st.size == 700 && st.blocks == 2);
+    CHECK(vfs_truncate("z3", 1500) == 0 && slurp("z3", out) == 1500 && memcmp(out, text + 3, 1000) == 0);
+    int fd = vfs_open_file("r");
+    CHECK(vfs_truncate("r", 0) == -1);
+    vfs_close_file(fd);
+    CHECK(vfs_truncate("r", 701) == -1 && vfs_truncate("/", 0) == -1 && vfs_truncate("missing", 0) == -1);
+    CHECK(vfs_sync() >= 0);
+    reset_kernel_state();
+    CHECK(vfs_mount(&test_disk) == 0);
+    CHECK(slurp("r", out) == 700 && memcmp(out, text, 700) == 0);
+    CHECK(slurp("z3", out) == 1500 && memcmp(out + 1000, text + 3, 500) == 0);
+    CHECK(vfs_stat("z3", &st) == 0 && st.blocks == 1);
+    reset_kernel_state();
+}
+
+static int shell_ran;
+
+static void shell_fn(int argc, char** argv) {
+    shell_ran = argc;
+}
+
+// Command table and argv splitting
+static void check_shell() {
+    static ShellCommand cmds[SHELL_COMMANDS + 1];
+    static char names[SHELL_COMMANDS + 1][8];
+    shell_init();
+    for (int i = 0; i <= SHELL_COMMANDS; i++) {
+        sprintf(names[i], "cmd%d", i);
+        cmds[i].name = names[i];
+        cmds[i].fn = shell_fn;
+    }
+    int added = 0;
+    for (int i = 0; i <= SHELL_COMMANDS; i++) added += shell_register(&cmds[i]) == 0;
+    CHECK(added == SHELL_COMMANDS && shell_find("cmd32") == 0); // Full
+    int found = 1;
+    for (int i = 0; i < SHELL_COMMANDS; i++) found &= shell_find(names[i]) == &cmds[i];
+    CHECK(found && shell_find("cmd") == 0 && shell_find("") == 0);
+    CHECK(shell_command(0) == &cmds[0] && shell_command(SHELL_COMMANDS) == 0);
+    shell_init();
+    CHECK(shell_register(&cmds[5]) == 0 && shell_register(&cmds[5]) == -1 && shell_find("cmd4") == 0);
+
+    char line[SHELL_LINE_MAX];
+    char* argv[SHELL_ARGS];
+    strcpy(line, "  sched 3  edf 2 10 ");
+    CHECK(shell_parse(line, argv, SHELL_ARGS) == 5);
+    CHECK(strcmp(argv[0], "sched") == 0 && strcmp(argv[2], "edf") == 0 && strcmp(argv[4], "10") == 0);
+    strcpy(line, "echo \"a b\" c\"d e\"f \"\"");
+    CHECK(shell_parse(line, argv, SHELL_ARGS) == 4);
+    CHECK(strcmp(argv[1], "a b") == 0 && strcmp(argv[2], "cd ef") == 0 && argv[3][0] == 0);
+    strcpy(line, "   ");
+    CHECK(shell_parse(line, argv, SHELL_ARGS) == 0);
+    strcpy(line, "a \"b c");
+    CHECK(shell_parse(line, argv, SHELL_ARGS) == -1);
+    strcpy(line, "1 2 3 4 5 6 7 8 9");
+    CHECK(shell_parse(line, argv, SHELL_ARGS) == -1);
+    strcpy(line, "cmd5 x y");
+    int argc = shell_parse(line, argv, SHELL_ARGS);
+    shell_find(argv[0])->fn(argc, argv);
+    CHECK(shell_ran == 3);
+}
+
+// History ring: recall order, wrap-around, and the saved text format
+static void check_history() {
+    static char buf[SHELL_HISTORY * SHELL_LINE_MAX];
+    char line[16];
+    shell_init();
+    CHECK(shell_history_count() == 0 && shell_history(0) == 0);
+    shell_history_add("ls");
+    shell_history_add("ls"); // Repeat of the newest: kept once
+    shell_history_add("");
+    shell_history_add("ps");
+    CHECK(shell_history_count() == 2 && shell_history_total() == 2);
+    CHECK(strcmp(shell_history(0), "ps") == 0 && strcmp(shell_history(1), "ls") == 0 && shell_history(2) == 0);
+    CHECK(shell_history_save(buf, sizeof(buf)) == 6 && memcmp(buf, "ls\nps\n", 6) == 0);
+
+    for (int i = 0; i < SHELL_HISTORY + 5; i++) {
+        sprintf(line, "echo %d", i);
+        shell_history_add(line);
+    }
+    CHECK(shell_history_count() == SHELL_HISTORY && shell_history_total() == SHELL_HISTORY + 7);
+    sprintf(line, "echo %d", SHELL_HISTORY + 4);
+    CHECK(strcmp(shell_history(0), line) == 0 && strcmp(shell_history(SHELL_HISTORY - 1), "echo 5") == 0);
+    CHECK(shell_history(SHELL_HISTORY) == 0);
+    CHECK(shell_history_save(buf, 17) == 16 && memcmp(buf, "echo 35\necho 36\n", 16) == 0); // Newest that fit
+
+    // Loaded lines go in before the session's own
+    shell_init();
+    shell_history_add("mount ram0");
+    shell_history_load("cat a\ncat b\n", 12);
+    CHECK(shell_history_count() == 3 && strcmp(shell_history(0), "mount ram0") == 0);
+    CHECK(strcmp(shell_history(1), "cat b") == 0 && strcmp(shell_history(2), "cat a") == 0);
+    int len = shell_history_save(buf, sizeof(buf));
+    shell_init();
+    shell_history_load(buf, len);
+    CHECK(shell_history_count() == 3 && strcmp(shell_history(2), "cat a") == 0);
+    shell_init();
+}
+
+static void check_sched() {
+    reset_kernel_state();
+    CHECK(create_process(idle_task, 5, 0) == 0);
+    CHECK(create_process(idle_task, 3, 0) == 1);
+    CHECK(create_process(idle_task, 2, 3) == 2);
+    CHECK(processes[2].page_dir != kernel_page_dir);
+    processes[0].state = 1;
+
+    // The running task yields to the best other ready task each tick
+    schedule();
+    CHECK(current_process == 1);
+    CHECK(processes[0].state == 0);
+    schedule();
+    CHECK(current_process == 0);
+
+    kill_process(1);
+    CHECK(schedule_flag == 1);
+    CHECK(processes[0].pid == 0);
+    schedule();
+    CHECK(current_process == 1);
+    CHECK(processes[1].state == 1);
+    CHECK(processes[0].state == 2); // killed task must not become ready again
+    schedule();
+    CHECK(current_process == 2);
+    CHECK(processes[0].state == 2);
+
+    CHECK(create_process(idle_task, 9, 0) == 0);
+    schedule();
+    CHECK(current_process == 0);
+
+    for (int i = 3; i < MAX_PROCESSES; i++) CHECK(create_process(idle_task, 1, 0) == i);
+    CHECK(create_process(idle_task, 1, 0) == -1);
+
+    // Nothing runnable: fall back to the idle loop until a task appears
+    for (int i = 0; i < MAX_PROCESSES; i++) kill_process(processes[i].pid);
+    schedule();
+    CHECK(current_process == IDLE_PROCESS);
+    schedule();
+    CHECK(current_process == IDLE_PROCESS);
+    CHECK(create_process(idle_task, 4, 0) == 0);
+    schedule();
+    CHECK(current_process == 0);
+    CHECK(processes[0].state == 1);
+}
+
+static void check_accounting() {
+    reset_kernel_state();
+    int a = create_process(idle_task, 5, 0);
+    int b = create_process(idle_task, 3, 0);
+    current_process = IDLE_PROCESS;
+
+    // Preemption is involuntary, blocking voluntary; every dispatch is one
+    // timeslice and one wait sample
+    schedule();
+    CHECK(current_process == a && processes[a].slices == 1);
+    schedule();
+    CHECK(current_process == b && processes[a].involuntary == 1);
+    sleep_on(b, &b);
+    schedule();
+    CHECK(current_process == a && processes[b].voluntary == 1);
+    CHECK(processes[b].runtime > 0 && processes[a].slices == 2);
+    wake_up(&b);
+    schedule();
+    int samples = 0;
+    for (int i = 0; i < WAIT_BUCKETS; i++) samples += processes[b].wait_hist[i];
+    CHECK(samples == (int)processes[b].slices && samples == 2);
+    CHECK(processes[a].involuntary == 2 && processes[a].voluntary == 0);
+
+    CHECK(wait_bucket(0) == 0);
+    CHECK(wait_bucket((1ULL << WAIT_BUCKET_SHIFT) - 1) == 0);
+    CHECK(wait_bucket(1ULL << WAIT_BUCKET_SHIFT) == 1);
+    CHECK(wait_bucket(1ULL << (WAIT_BUCKET_SHIFT + 2)) == 2);
+    CHECK(wait_bucket(~0ULL) == WAIT_BUCKETS - 1);
+}
+
+static void check_fair() {
+    reset_kernel_state();
+    int a = create_process(idle_task, 5, 0);
+    int b = create_process(idle_task, 5, 0);
+    int c = create_process(idle_task, 3, 0);
+    CHECK(sched_setpolicy(a, SCHED_FAIR) == 0 && sched_setpolicy(b, SCHED_FAIR) == 0);
+    CHECK(sched_setpolicy(a, 7) == -1);
+    current_process = IDLE_PROCESS;
+
+    // Strict priority tasks run first, whatever their priority
+    schedule();
+    CHECK(current_process == c);
+    sleep_on(c, &c);
+
+    // Then the least vruntime; the runner is charged before comparing
+    schedule();
+    CHECK(current_process == a);
+    schedule();
+    CHECK(current_process == b && processes[a].vruntime > 0);
+    sleep_on(b, &b);
+    schedule();
+    CHECK(current_process == a);
+    unsigned long long floor = processes[a].vruntime;
+    schedule();
+    CHECK(current_process == a && processes[a].state == 1);
+
+    // A waking strict task preempts; sleepers and newcomers start no lower
+    // than the last task dispatched
+    wake_up(&c);
+    schedule();
+    CHECK(current_process == c && processes[a].state == 0);
+    wake_up(&b);
+    CHECK(processes[b].vruntime >= floor);
+    int d = create_process(idle_task, 5, 0);
+    CHECK(sched_setpolicy(d, SCHED_FAIR) == 0 && processes[d].vruntime >= floor);
+
+    // Weight: 1024 at priority 5, heavier tasks age slower
+    CHECK(fair_delta(1 << 20, 5) == 1 << 20);
+    CHECK(fair_delta(1 << 20, 10) < fair_delta(1 << 20, 5));
+    CHECK(fair_delta(1 << 20, 1) > fair_delta(1 << 20, 5));
+
+    // A restored snapshot puts the run queue back with the tasks: both fair
+    // tasks run again after being dispatched and blocked past the snapshot
+    static SchedSnapshot snap;
+    reset_kernel_state();
+    a = create_process(idle_task, 5, 0);
+    b = create_process(idle_task, 5, 0);
+    sched_setpolicy(a, SCHED_FAIR);
+    sched_setpolicy(b, SCHED_FAIR);
+    current_process = IDLE_PROCESS;
+    sched_snapshot(&snap);
+    for (int i = 0; i < 2; i++) {
+        schedule();
+        sleep_on(current_process, &snap);
+    }
+    schedule();
+    CHECK(current_process == IDLE_PROCESS);
+    sched_restore(&snap);
+    CHECK(current_process == IDLE_PROCESS && processes[a].state == 0 && processes[b].state == 0);
+    schedule();
+    int first = current_process;
+    CHECK(first == a || first == b);
+    sleep_on(first, &snap);
+    schedule();
+    CHECK(current_process == (first == a ? b : a));
+}
+
+// Run the scheduler for ticks timer ticks. An EDF task needs work[slot]
+// ticks of CPU per job and then ends it; other tasks just spin.
+static void run_ticks(int ticks, const int* work) {
+    static int left[MAX_PROCESSES];
+    for (int i = 0; i < MAX_PROCESSES; i++) left[i] = work[i];
+    for (int t = 0; t < ticks; t++) {
+        int cur = current_process;
+        if (cur != IDLE_PROCESS && processes[cur].policy == SCHED_EDF && --left[cur] == 0) {
+            sleep_on(cur, edf_job_done(cur));
+            left[cur] = work[cur];
+        }
+        sched_tick();
+        schedule();
+    }
+}
+
+static void check_edf() {
+    reset_kernel_state();
+    int work[MAX_PROCESSES] = { 0 };
+    int hog1 = create_process(idle_task, 10, 0);  // task1/task2-style CPU hogs,
+    int hog2 = create_process(idle_task, 5, 0);   // one of each other class
+    sched_setpolicy(hog2, SCHED_FAIR);
+    int a = create_process(idle_task, 1, 0);
+    int b = create_process(idle_task, 1, 0);
+    int c = create_process(idle_task, 1, 0);
+
+    // Admission control: 0.2 + 0.25 + 0.4 fits, another 0.1 does not
+    CHECK(sched_setedf(a, 2, 10, 10) == 0);
+    CHECK(sched_setedf(b, 3, 15, 12) == 0);
+    CHECK(sched_setedf(c, 4, 10, 10) == 0);
+    CHECK(sched_setedf(hog1, 1, 10, 10) == -1);
+    CHECK(sched_setedf(hog1, 3, 2, 2) == -1);
+    CHECK(processes[hog1].policy == SCHED_PRIO);
+    work[a] = 2;
+    work[b] = 3;
+    work[c] = 4;
+    current_process = IDLE_PROCESS;
+    run_ticks(3000, work);
+
+    // Admitted tasks meet every deadline despite the hogs, which still run
+    CHECK(processes[a].dl_jobs >= 299 && processes[a].dl_misses == 0);
+    CHECK(processes[b].dl_jobs >= 199 && processes[b].dl_misses == 0);
+    CHECK(processes[c].dl_misses == 0);
+    CHECK(processes[hog1].ticks > 0);
+
+    // A task that needs more than its budget is throttled. Each overrun job
+    // finishes in the next period, so half miss; the others are unaffected
+    sched_setpolicy(c, SCHED_PRIO);
+    CHECK(processes[c].state != 3);
+    CHECK(sched_setedf(c, 2, 10, 10) == 0);
+    work[c] = 3;
+    run_ticks(1000, work);
+    CHECK(processes[c].dl_jobs >= 99 && processes[c].dl_misses * 2 + 2 >= processes[c].dl_jobs);
+    CHECK(processes[c].runtime > 0 && processes[a].dl_misses == 0 && processes[b].dl_misses == 0);
+}
+
+static void check_wait() {
+    int code = 0;
+    reset_kernel_state();
+    int parent = create_process(idle_task, 5, 3);
+    int child = create_process(idle_task, 5, 3);
+    int grandchild = create_process(idle_task, 5, 3);
+    processes[child].parent = processes[parent].pid;
+    processes[grandchild].parent = processes[child].pid;
+    int child_pid = processes[child].pid;
+
+    CHECK(reap_child(parent, -1, &code) == 0);        // Child still running
+    CHECK(reap_child(parent, child_pid + 1, &code) == -1); // Not its child
+    CHECK(reap_child(grandchild, -1, &code) == -1);   // No children at all
+
+    // A blocked parent wakes when the child exits; the child stays a zombie
+    sleep_on(parent, &processes[parent]);
+    exit_process(child, 7);
+    CHECK(processes[child].state == 4);
+    CHECK(processes[child].pid == child_pid);
+    CHECK(processes[parent].state == 0);
+    CHECK(processes[grandchild].parent == 0);         // Orphaned
+    kill_process(child_pid);                          // Zombies cannot be killed again
+    CHECK(processes[child].state == 4);
+    CHECK(create_process(idle_task, 1, 0) == 3);      // Zombie slot still taken
+
+    CHECK(reap_child(parent, -1, &code) == child_pid);
+    CHECK(code == 7);
+    CHECK(processes[child].pid == 0);
+    CHECK(reap_child(parent, -1, &code) == -1);
+
+    // Orphans are released as soon as they exit
+    exit_process(grandchild, 0);
+    CHECK(processes[grandchild].pid == 0);
+    CHECK(processes[grandchild].state == 2);
+
+    // A parent exiting releases its zombie children
+    child = create_process(idle_task, 5, 3);
+    processes[child].parent = processes[parent].pid;
+    exit_process(child, 1);
+    CHECK(processes[child].state == 4);
+    exit_process(parent, 0);
+    CHECK(processes[child].pid == 0);
+    CHECK(processes[parent].pid == 0);
+}
+
+static void check_pipe() {
+    char buf[PIPE_SIZE * 2];
+    char out[PIPE_SIZE * 2];
+    int r, w;
+    reset_kernel_state();
+    for (int i = 0; i < PIPE_SIZE * 2; i++) buf[i] = (char)(i * 13);
+
+    CHECK(vfs_pipe(&r, &w) == 0);
+    CHECK(vfs_read_file(r, out, 1) == PIPE_AGAIN);    // Empty, writer open
+    CHECK(vfs_write_file(r, buf, 1) == -1);           // Wrong end
+    CHECK(vfs_read_file(w, out, 1) == -1);
+
+    // Fill to capacity, wrapping the ring, then drain in order
+    CHECK(vfs_write_file(w, buf, 100) == 100);
+    CHECK(vfs_read_file(r, out, 60) == 60);
+    CHECK(vfs_write_file(w, buf + 100, PIPE_SIZE) == PIPE_SIZE - 40);
+    CHECK(vfs_write_file(w, buf, 1) == PIPE_AGAIN);   // Full, reader open
+    CHECK(vfs_read_file(r, out + 60, PIPE_SIZE * 2) == PIPE_SIZE);
+    int same = 1;
+    for (int i = 0; i < PIPE_SIZE + 60; i++) if (out[i] != buf[i]) same = 0;
+    CHECK(same);
+
+    // Sleepers on the pipe wake on data, room and closes
+    int reader = create_process(idle_task, 5, 3);
+    sleep_on(reader, vfs_wait_channel(r));
+    CHECK(processes[reader].state == 3);
+    CHECK(vfs_write_file(w, "x", 1) == 1);
+    CHECK(processes[reader].state == 0);
+
+    // Futex-style wakes are bounded
+    int other = create_process(idle_task, 5, 3);
+    sleep_on(reader, &buf[0]);
+    sleep_on(other, &buf[0]);
+    CHECK(wake_up_nr(&buf[0], 1) == 1);
+    CHECK(processes[reader].state == 0 && processes[other].state == 3);
+    CHECK(wake_up_nr(&buf[0], 5) == 1);
+    CHECK(wake_up_nr(&buf[0], 5) == 0);
+    kill_process(processes[other].pid);
+
+    // fork-style sharing: the write end stays open until its last close
+    CHECK(vfs_dup(w) == w);
+    vfs_close_file(w);
+    CHECK(vfs_read_file(r, out, 8) == 1);
+    CHECK(vfs_read_file(r, out, 8) == PIPE_AGAIN);
+    sleep_on(reader, vfs_wait_channel(r));
+    vfs_close_file(w);
+    CHECK(processes[reader].state == 0);
+    CHECK(vfs_read_file(r, out, 8) == 0);             // End of file
+
+    // Writers see a broken pipe once no reader is left
+    int r2, w2;
+    CHECK(vfs_pipe(&r2, &w2) == 0);
+    vfs_close_file(r2);
+    CHECK(vfs_write_file(w2, buf, 1) == -1);
+    vfs_close_file(w2);
+    vfs_close_file(r);
+
+    // Exiting closes a process's descriptors
+    CHECK(vfs_pipe(&r, &w) == 0);
+    int writer = create_process(idle_task, 5, 3);
+    CHECK(fd_install(writer, w) == 0);
+    CHECK(fd_install(writer, vfs_dup(r)) == 1);
+    exit_process(writer, 0);
+    CHECK(vfs_read_file(r, out, 1) == 0);
+    vfs_close_file(r);
+    CHECK(!fds[r].used && !fds[w].used);
+
+    for (int i = 0; i < MAX_PIPES; i++) CHECK(vfs_pipe(&r, &w) == 0);
+    CHECK(vfs_pipe(&r, &w) == -1);                    // Out of pipes
+}
+
+static void check_threads() {
+    reset_kernel_state();
+    int leader = create_process(idle_task, 5, 3);
+    int t1 = create_process(idle_task, 5, 3);
+    int t2 = create_process(idle_task, 5, 3);
+    int other = create_process(idle_task, 5, 3);
+    processes[t1].group = processes[t2].group = processes[leader].pid;
+    processes[t1].parent = processes[t2].parent = processes[leader].pid;
+
+    // Threads share the leader's descriptor table
+    int r, w;
+    CHECK(vfs_pipe(&r, &w) == 0);
+    CHECK(fd_install(t1, r) == 0);
+    CHECK(proc_files(t2)[0] == r);
+    CHECK(proc_files(leader) == processes[leader].files);
+    CHECK(processes[t1].files[0] == -1);
+
+    // A thread exiting alone stays joinable; the process keeps running
+    exit_process(t2, 3);
+    CHECK(processes[t2].state == 4);
+    int code = 0;
+    CHECK(reap_child(leader, processes[t2].pid, &code) == t2 + 1 && code == 3);
+    CHECK(fds[r].used);
+
+    // Killing any thread ends the group and closes the shared table
+    kill_process(processes[t1].pid);
+    CHECK(processes[t1].pid == 0 && processes[leader].pid == 0);
+    CHECK(!fds[r].used);
+    CHECK(processes[other].pid == other + 1);
+    vfs_close_file(w);
+}
+
+static int read_proc(const char* name, char* buf, int cap) {
+    int fd = vfs_open_file(name);
+    if (fd < 0) return -1;
+    int len = 0, n;
+    while (len < cap - 1 && (n = vfs_read_file(fd, buf + len, cap - 1 - len)) > 0) len += n;
+    buf[len] = 0;
+    vfs_close_file(fd);
+    return len;
+}
+
+static void check_procfs() {
+    reset_kernel_state();
+    char buf[PROC_FILE_MAX];
+    int a = create_process(idle_task, 5, 3);
+    processes[a].ticks = 7;
+    processes[a].slices = 2;
+    irq_counts[0x21] = 3;
+
+    CHECK(read_proc("/proc/stat", buf, sizeof(buf)) > 0);
+    CHECK(strstr(buf, "switches ") && strstr(buf, "tasks 1\n"));
+    CHECK(read_proc("/proc/1", buf, sizeof(buf)) > 0);
+    CHECK(strstr(buf, "pid 1\n") && strstr(buf, "ticks 7\n") && strstr(buf, "slices 2\n"));
+    CHECK(read_proc("/proc/interrupts", buf, sizeof(buf)) > 0 && strstr(buf, "33 3\n"));
+    // x86-64 hosts always have SSE2, enabled by their OS
+    CHECK(cpu_has(CPU_FPU) && cpu_has(CPU_SSE2) && cpu_info.vendor[0]);
+    CHECK(read_proc("/proc/cpuinfo", buf, sizeof(buf)) > 0);
+    CHECK(strstr(buf, " sse2") && strstr(buf, "sse_enabled 1\n") && strstr(buf, "fpu_traps 0\n"));
+
+    // Counters are sampled at read time
+    int fd = vfs_open_file("/proc/vfs");
+    CHECK(fd >= 0 && vfs_write_file(fd, "x", 1) == -1);
+    vfs_close_file(fd);
+    CHECK(read_proc("/proc/vfs", buf, sizeof(buf)) > 0 && strstr(buf, "open_fds 1\n"));
+
+    // Unknown names fail; an exited process reads as empty
+    CHECK(vfs_open_file("/proc/nope") == -1);
+    CHECK(vfs_open_file("/proc/99") == -1);
+    kill_process(processes[a].pid);
+    CHECK(read_proc("/proc/1", buf, sizeof(buf)) == 0);
+    irq_counts[0x21] = 0;
+}
+
+static void check_locks() {
+    Spinlock spin = SPINLOCK_INIT;
+    Mutex m = MUTEX_INIT;
+    reset_kernel_state();
+
+    unsigned int flags = spin_lock_irqsave(&spin);
+    CHECK(spin.locked == 1);
+    spin_unlock_irqrestore(&spin, flags);
+    CHECK(spin.locked == 0);
+
+    int a = create_process(idle_task, 5, 0);
+    int b = create_process(idle_task, 5, 0);
+    int c = create_process(idle_task, 5, 0);
+    current_process = a;
+    mutex_lock(&m);
+    CHECK(m.locked && m.owner == a);
+    current_process = b;
+    CHECK(!mutex_trylock(&m));
+    // Two tasks asleep on the held mutex: unlock hands it to one of them
+    sleep_on(b, &m);
+    sleep_on(c, &m);
+    current_process = a;
+    mutex_unlock(&m);
+    CHECK(!m.locked);
+    CHECK(processes[b].state == 0 && processes[c].state == 3);
+    current_process = b;
+    CHECK(mutex_trylock(&m));
+    CHECK(m.owner == b);
+    mutex_unlock(&m);
+    CHECK(processes[c].state == 0);
+}
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void report(const char* name, int size, long ops, unsigned long long cycles, double ns) {
+    printf("bench name=%s size=%d iters=%ld min=0 avg=%llu max=0 ns_per_op=%.1f\n",
+           name, size, ops, cycles / (unsigned long long)ops, ns / ops);
+}
+
+static void stress(long ops) {
+    static const int sizes[] = { 16, 256, 1024, MAX_FILE_SIZE };
+    static char buf[MAX_FILE_SIZE];
+    reset_kernel_state();
+    vfs_create_file("stress.dat");
+
+    for (unsigned int k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        int size = sizes[k];
+        long n = ops / (size / 16 + 1) + 1;
+        double t0 = now_ns();
+        unsigned long long c0 = rdtsc();
+        for (long i = 0; i < n; i++) {
+            int fd = vfs_open_file("stress.dat");
+            vfs_write_file(fd, buf, size);
+            vfs_close_file(fd);
+            fd = vfs_open_file("stress.dat");
+            vfs_read_file(fd, buf, size);
+            vfs_close_file(fd);
+        }
+        report("host_vfs_rw", size, n, rdtsc() - c0, now_ns() - t0);
+    }
+
+    for (int i = 0; i < MAX_PROCESSES; i++) create_process(idle_task, 1 + i % 10, i & 1 ? 3 : 0);
+    processes[0].state = 1;
+    double t0 = now_ns();
+    unsigned long long c0 = rdtsc();
+    for (long i = 0; i < ops; i++) {
+        // Rotate priorities so every call takes the switch path
+        processes[i % MAX_PROCESSES].priority = 1 + (int)(i % 10);
+        schedule();
+    }
+    report("host_schedule", 0, ops, rdtsc() - c0, now_ns() - t0);
+
+    t0 = now_ns();
+    c0 = rdtsc();
+    for (long i = 0; i < ops; i++) {
+        int slot = (int)(i % MAX_PROCESSES);
+        kill_process(processes[slot].pid);
+        create_process(idle_task, 1 + slot, 0);
+    }
+    report("host_create_kill", 0, ops, rdtsc() - c0, now_ns() - t0);
+}
+
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "all";
+    long ops = argc > 2 ? atol(argv[2]) : 1000000;
+    int all = mode[0] == 'a';
+
+    cpu_init();
+    klib_init();
+    crc32c_init();
+    shell_init();
+    if (all || mode[0] == 'c') {
+        check_klib();
+        check_crc32c();
+        check_vfs();
+        check_journal();
+        check_compress();
+        check_shell();
+        check_history();
+        check_sched();
+        check_accounting();
+        check_fair();
+        check_edf();
+        check_wait();
+        check_pipe();
+        check_locks();
+        check_threads();
+        check_procfs();
+        printf("host-check failures=%d\n", failures);
+    }
+    if (all || mode[0] == 'b') {
+        reset_kernel_state();
+        for (int i = 0; i < 3; i++) create_process(idle_task, 5 - i, i == 2 ? 3 : 0);
+        processes[0].state = 1;
+        run_benchmarks();
+    }
+    if (all || mode[0] == 's') {
+        stress(ops);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,204 @@
+#include "journal.h"
+#include "crc32c.h"
+#include "klib.h"
+
+// Device layout: block 0 is the superblock, the rest two equal log regions.
+// Transactions are appended to the active region as consecutive log blocks,
+// the last one flagged commit. When a region fills, the log's user writes a
+// snapshot of its state into the other region and the superblock is switched
+// over, so a crash at any point leaves one complete, checksummed log.
+#define JOURNAL_MAGIC 0x4C4E524A    // "JRNL"
+#define SUPER_MAGIC   0x5355504A    // "JPUS"
+
+typedef struct {
+    unsigned int magic;
+    unsigned int region;            // Region holding the live log
+    unsigned int seq;               // Sequence number of its first block
+    unsigned int sum;
+} Superblock;
+
+JournalStats journal_stats;
+
+static BlockDevice* dev;
+static unsigned int region_blocks;  // Blocks per region
+static unsigned int active;         // Region the superblock names
+static unsigned int target;         // Region being appended to; differs while checkpointing
+static unsigned int head;           // Next block to write
+static unsigned int seq;            // Sequence number for it
+static unsigned int region_seq;     // First sequence number in target
+static int snapshot_failed;         // A snapshot commit did not fit or failed
+
+// The transaction being built, and the one being replayed
+static char pending[JOURNAL_TXN_MAX];
+static int pending_len;
+static char txn[JOURNAL_TXN_MAX];
+static unsigned char block[BLOCK_SIZE];
+
+static unsigned int region_start(unsigned int r) {
+    return 1 + r * region_blocks;
+}
+
+// CRC32C over the block with its sum field read as zero
+static unsigned int block_sum(const unsigned char* p, int sum_at) {
+    static const unsigned char zero[4];
+    unsigned int crc = crc32c(0, p, sum_at);
+    crc = crc32c(crc, zero, sizeof(zero));
+    return crc32c(crc, p + sum_at + 4, BLOCK_SIZE - sum_at - 4);
+}
+
+static int write_super(unsigned int region, unsigned int first_seq) {
+    memset(block, 0, BLOCK_SIZE);
+    Superblock* sb = (Superblock*)block;
+    sb->magic = SUPER_MAGIC;
+    sb->region = region;
+    sb->seq = first_seq;
+    sb->sum = block_sum(block, __builtin_offsetof(Superblock, sum));
+    journal_stats.blocks_written++;
+    return block_write(dev, 0, block);
+}
+
+// Apply every committed transaction in the active region, stopping at the
+// first block that is missing, stale (wrong sequence) or corrupt, or at a
+// transaction apply rejects. Leaves head and seq just past the last commit
+// applied: an unfinished or rejected transaction is overwritten by the next.
+static void replay(int (*apply)(const char* txn, int len)) {
+    unsigned int b = region_start(active), end = b + region_blocks;
+    unsigned int expect = seq;
+    int len = 0;
+    head = b;
+    LogHeader* h = (LogHeader*)block;
+    while (b < end && block_read(dev, b, block) == 0) {
+        if (h->magic != JOURNAL_MAGIC || h->seq != expect || h->used > LOG_PAYLOAD ||
+            h->sum != block_sum(block, __builtin_offsetof(LogHeader, sum)) ||
+            len + h->used > JOURNAL_TXN_MAX) {
+            break;
+        }
+        memcpy(txn + len, block + sizeof(LogHeader), h->used);
+        len += h->used;
+        b++;
+        expect++;
+        if (h->commit) {
+            if (apply && apply(txn, len) < 0) break;
+            journal_stats.replayed++;
+            len = 0;
+            head = b;
+            seq = expect;
+        }
+    }
+}
+
+// Attach the log on dev and replay it through apply. A device without a
+// superblock is formatted with an empty log. Returns 0, or -1 if dev is too
+// small or fails.
+int journal_open(BlockDevice* d, int (*apply)(const char* txn, int len)) {
+    // A superblock failing the block layer's check (a crash between writing
+    // it and its checksum) is still judged by its own sum below
+    if (d->blocks < JOURNAL_MIN_BLOCKS || block_read(d, 0, block) == -1) return -1;
+    dev = d;
+    region_blocks = (d->blocks - 1) / 2;
+    pending_len = 0;
+    Superblock* sb = (Superblock*)block;
+    if (sb->magic == SUPER_MAGIC && sb->region < 2 &&
+        sb->sum == block_sum(block, __builtin_offsetof(Superblock, sum))) {
+        active = sb->region;
+        seq = sb->seq;
+    } else {
+        active = 0;
+        seq = 1;
+        if (write_super(active, seq) < 0) {
+            dev = 0;
+            return -1;
+        }
+    }
+    replay(apply);
+    target = active;
+    region_seq = seq;
+    return 0;
+}
+
+// Detach; uncommitted records are dropped
+void journal_close() {
+    dev = 0;
+    pending_len = 0;
+}
+
+int journal_attached() {
+    return dev != 0;
+}
+
+// Bytes buffered for the next commit
+int journal_pending() {
+    return pending_len;
+}
+
+// Buffer a record for the next commit, committing first if it would not
+// fit. Returns 0, JOURNAL_FULL or -1.
+int journal_append(const void* rec, int len) {
+    if (!dev) return 0;
+    if (len > JOURNAL_TXN_MAX || snapshot_failed) return -1;
+    if (pending_len + len > JOURNAL_TXN_MAX) {
+        int r = journal_commit();
+        if (r < 0) return r;
+    }
+    memcpy(pending + pending_len, rec, len);
+    pending_len += len;
+    journal_stats.appends++;
+    return 0;
+}
+
+// Group commit: everything buffered goes out as one transaction of
+// sequential block writes. Returns the blocks written, JOURNAL_FULL (nothing
+// written, records kept) or -1 on a device error.
+int journal_commit() {
+    if (!dev || !pending_len) return 0;
+    int n = (pending_len + LOG_PAYLOAD - 1) / LOG_PAYLOAD;
+    if (head + n > region_start(target) + region_blocks) {
+        if (target != active) snapshot_failed = 1;
+        return JOURNAL_FULL;
+    }
+    LogHeader* h = (LogHeader*)block;
+    for (int k = 0; k < n; k++) {
+        int used = pending_len - k * LOG_PAYLOAD;
+        if (used > LOG_PAYLOAD) used = LOG_PAYLOAD;
+        h->magic = JOURNAL_MAGIC;
+        h->seq = seq + k;
+        h->used = used;
+        h->commit = k == n - 1;
+        memcpy(block + sizeof(LogHeader), pending + k * LOG_PAYLOAD, used);
+        memset(block + sizeof(LogHeader) + used, 0, LOG_PAYLOAD - used);
+        h->sum = block_sum(block, __builtin_offsetof(LogHeader, sum));
+        if (block_write(dev, head + k, block) < 0) {
+            if (target != active) snapshot_failed = 1;
+            return -1;
+        }
+    }
+    head += n;
+    seq += n;
+    pending_len = 0;
+    journal_stats.commits++;
+    journal_stats.blocks_written += n;
+    return n;
+}
+
+// Start a snapshot in the inactive region. Buffered records are dropped:
+// the snapshot the caller appends next supersedes them.
+void journal_checkpoint_begin() {
+    target = 1 - active;
+    head = region_start(target);
+    region_seq = seq;
+    pending_len = 0;
+    snapshot_failed = 0;
+}
+
+// Commit the snapshot and switch the superblock to it. If it did not fit, or
+// a write failed, the journal detaches and returns -1: the old log stays
+// live on the device, but nothing after it will be durable.
+int journal_checkpoint_end() {
+    if (snapshot_failed || journal_commit() < 0 || write_super(target, region_seq) < 0) {
+        journal_close();
+        return -1;
+    }
+    active = target;
+    journal_stats.checkpoints++;
+    return 0;
+}
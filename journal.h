@@ -0,0 +1,44 @@
+// Log-structured persistence: an append-only log of committed transactions
+// on a block device. The log's users decide what a transaction's bytes mean;
+// the journal only guarantees that replay sees whole transactions, in order.
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "block.h"
+
+#define JOURNAL_MIN_BLOCKS 8      // Superblock and two log regions
+#define JOURNAL_TXN_BLOCKS 16     // Largest transaction, in log blocks
+#define JOURNAL_FULL -2           // The active region has no room for the commit
+
+// On-disk log block: header, then up to LOG_PAYLOAD bytes of the transaction
+typedef struct {
+    unsigned int magic;
+    unsigned int seq;             // Consecutive across the region's blocks
+    unsigned short used;          // Payload bytes
+    unsigned short commit;        // 1 on a transaction's last block
+    unsigned int sum;             // Over the header (sum zeroed) and payload
+} LogHeader;
+
+#define LOG_PAYLOAD (BLOCK_SIZE - (int)sizeof(LogHeader))
+#define JOURNAL_TXN_MAX (JOURNAL_TXN_BLOCKS * LOG_PAYLOAD)
+
+typedef struct {
+    unsigned int commits;         // Transactions written
+    unsigned int appends;         // Records buffered for them
+    unsigned int blocks_written;  // Log and superblock writes
+    unsigned int checkpoints;     // Region switches
+    unsigned int replayed;        // Transactions applied at open
+} JournalStats;
+
+extern JournalStats journal_stats;
+
+int journal_open(BlockDevice* dev, int (*apply)(const char* txn, int len));
+void journal_close(void);
+int journal_attached(void);
+int journal_pending(void);
+int journal_append(const void* rec, int len);
+int journal_commit(void);
+void journal_checkpoint_begin(void);
+int journal_checkpoint_end(void);
+
+#endif
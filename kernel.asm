@@ -1,77 +1,186 @@
-[bits 32]
-[extern kmain]
-[extern default_handler]
-[extern timer_handler]
-[extern keyboard_handler]
-[extern double_fault_handler]
-[extern syscall_handler]
-[global _start]
-[global default_handler_wrapper]
-[global timer_handler_wrapper]
-[global keyboard_handler_wrapper]
-[global double_fault_handler_wrapper]
-[global syscall_handler_wrapper]
-
-
-section .text
-_start:
-    call kmain
-    cli
-    hlt
-
-default_handler_wrapper:
-    pusha
-    call default_handler
-    mov al, 0x20
-    out 0x20, al
-    popa
-    iret
-
-timer_handler_wrapper:
-    pusha
-    call timer_handler
-    mov al, 0x20
-    out 0x20, al
-    popa
-    iret
-
-keyboard_handler_wrapper:
-    pusha
-    call keyboard_handler
-    mov al, 0x20
-    out 0x20, al
-    popa
-    iret
-
-double_fault_handler_wrapper:
-    pusha
-    call double_fault_handler
-    popa
-    iret
-
-syscall_handler_wrapper:
-    pusha
-    call syscall_handler
-    popa
-    iret
-
-.clear_pde:
-    mov [edi + esi], eax
-    add esi, 4
-    loop .clear_pde
-    mov edi, 0x200000
-    mov eax, 0x3
-    mov ecx, 1024
-
-.fill_pte:
-    mov [edi], eax
-    add eax, 0x1000
-    add edi, 4
-    loop .fill_pte
-    mov eax, 0x100000
-    mov cr3, eax
-    mov eax, cr0
-    or eax, 0x80000000
-    mov cr0, eax
-    ret
-    
\ No newline at end of file
+[bits 32]
+[extern kmain]
+[extern default_handler]
+[extern timer_handler]
+[extern keyboard_handler]
+[extern double_fault_handler]
+[extern syscall_handler]
+[extern fault_handler]
+[extern task_switch]
+[global _start]
+[global default_handler_wrapper]
+[global timer_handler_wrapper]
+[global keyboard_handler_wrapper]
+[global double_fault_handler_wrapper]
+[global syscall_handler_wrapper]
+[global divide_error_wrapper]
+[global invalid_opcode_wrapper]
+[global device_not_available_wrapper]
+[global general_protection_wrapper]
+[global page_fault_wrapper]
+[global fpu_error_wrapper]
+[global simd_error_wrapper]
+
+; Multiboot header: GRUB loads kernel.elf at its link address (1 MiB)
+MB_MAGIC     equ 0x1BADB002
+MB_FLAGS     equ 0x00000003      ; Page-align modules, provide memory info/map
+MB_CHECKSUM  equ -(MB_MAGIC + MB_FLAGS)
+KERNEL_STACK_SIZE equ 16384
+
+section .multiboot
+align 4
+    dd MB_MAGIC
+    dd MB_FLAGS
+    dd MB_CHECKSUM
+
+section .text
+; Entry from GRUB: eax = multiboot magic, ebx = multiboot info, flat 32-bit
+; protected mode, paging off. The GDT is ours to provide; init_gdt replaces
+; this boot GDT with one carrying the user segments and the TSS.
+_start:
+    cli
+    mov esp, kernel_stack_top
+    lgdt [gdt_descriptor]
+    jmp 0x08:.reload_segments
+.reload_segments:
+    mov cx, 0x10
+    mov ds, cx
+    mov es, cx
+    mov fs, cx
+    mov gs, cx
+    mov ss, cx
+    push ebx                ; kmain(magic, mbi)
+    push eax
+    call kmain
+.hang:
+    cli
+    hlt
+    jmp .hang
+
+; Every stub below leaves a TrapFrame (hal.h) on the stack: error code (a
+; dummy 0 where the CPU pushes none), ds/es/fs/gs and the pusha block, with
+; kernel data segments loaded. Stubs that may reschedule pass the frame to
+; task_switch and resume whichever frame it returns.
+%macro ISR_ENTER 0
+    push ds
+    push es
+    push fs
+    push gs
+    pusha
+    cld                     ; C code expects DF clear; user code may have set it
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+%endmacro
+
+%macro ISR_LEAVE 0
+    popa
+    pop gs
+    pop fs
+    pop es
+    pop ds
+    add esp, 4              ; Error code
+    iret
+%endmacro
+
+%macro ISR_SWITCH 0
+    push esp
+    call task_switch        ; eax = frame to resume
+    mov esp, eax
+%endmacro
+
+; CPU exception: fault_handler(vector, frame) kills a faulting user task
+%macro FAULT_STUB 3         ; vector, name, CPU pushes an error code
+%2:
+%if %3 == 0
+    push 0
+%endif
+    ISR_ENTER
+    push esp
+    push %1
+    call fault_handler
+    add esp, 8
+    ISR_SWITCH
+    ISR_LEAVE
+%endmacro
+
+default_handler_wrapper:
+    push 0
+    ISR_ENTER
+    call default_handler
+    mov al, 0x20
+    out 0x20, al
+    ISR_LEAVE
+
+timer_handler_wrapper:
+    push 0
+    ISR_ENTER
+    call timer_handler
+    mov al, 0x20
+    out 0x20, al
+    ISR_SWITCH
+    ISR_LEAVE
+
+keyboard_handler_wrapper:
+    push 0
+    ISR_ENTER
+    call keyboard_handler
+    mov al, 0x20
+    out 0x20, al
+    ISR_SWITCH
+    ISR_LEAVE
+
+double_fault_handler_wrapper:
+    ISR_ENTER               ; Error code (always 0) pushed by the CPU
+    call double_fault_handler
+    ISR_LEAVE
+
+syscall_handler_wrapper:
+    push 0
+    ISR_ENTER
+    push esp                ; TrapFrame* for syscall_handler
+    call syscall_handler
+    add esp, 4
+    ISR_SWITCH
+    ISR_LEAVE               ; Saved eax carries the result back
+
+FAULT_STUB 0, divide_error_wrapper, 0
+FAULT_STUB 6, invalid_opcode_wrapper, 0
+FAULT_STUB 7, device_not_available_wrapper, 0 ; Lazy FPU switch (fpu_trap)
+FAULT_STUB 13, general_protection_wrapper, 1
+FAULT_STUB 14, page_fault_wrapper, 1
+FAULT_STUB 16, fpu_error_wrapper, 0
+FAULT_STUB 19, simd_error_wrapper, 0
+
+section .data
+; GDT (Global Descriptor Table): flat 4 GiB kernel code and data
+align 8
+gdt_start:
+    dq 0x0 ; Null descriptor
+gdt_code:
+    dw 0xFFFF
+    dw 0x0
+    db 0x0
+    db 10011010b
+    db 11001111b
+    db 0x0
+gdt_data:
+    dw 0xFFFF
+    dw 0x0
+    db 0x0
+    db 10010010b
+    db 11001111b
+    db 0x0
+gdt_end:
+
+gdt_descriptor:
+    dw gdt_end - gdt_start - 1
+    dd gdt_start
+
+section .bss
+align 16
+kernel_stack:
+    resb KERNEL_STACK_SIZE
+kernel_stack_top:
@@ -1,1688 +1,2100 @@
-// Global Definitions and Structures
-#define VGA_WIDTH 80
-#define VGA_HEIGHT 25
-#define VGA_BUFFER 0xB8000
-#define PAGE_SIZE 4096
-#define MAX_PROCESSES 8
-#define MAX_FILES 32 // Reduced from 32 to 16 to test memory constraints
-#define MAX_INODES 8
-#define KERNEL_BASE 0xC0000000
-#define USER_BASE 0x100000
-#define FILE_WRITE_MAX 4096
-#define MAX_FILE_SIZE 4096
-
-// System call numbers
-#define SYS_WRITE 1
-#define SYS_OPEN  2
-#define SYS_EXIT  3
-#define SYS_PS    4
-#define SYS_KILL  5
-#define SYS_READ  6
-#define SYS_CLOSE 7
-#define SYS_CREATE 8
-#define SYS_LS    9
-
-// Diary Global Variables
-static char diary_buffer[256];
-static int diary_index = 0;
-static int diary_active = 0;
-
-// File Write Buffer
-static char file_write_buffer[FILE_WRITE_MAX];
-static int file_write_index = 0;
-static int file_write_active = 0;
-static int current_file_fd = -1;
-
-
-
-// Process structure for task management
-typedef struct {
-    void (*task)();           // Task function pointer
-    int state;                // 0: ready, 1: running, 2: terminated
-    int esp;                  // Stack pointer
-    int pid;                  // Process ID
-    int priority;             // Process priority (1-10)
-    unsigned int user_stack;  // User stack address
-    unsigned int code_segment;// Code segment
-    int privilege;            // 0: kernel, 3: user
-    unsigned int page_dir;    // Page directory address
-} Process;
-
-// Inode structure for file system
-// Update your Inode definition:
-typedef struct {
-    int id;
-    char name[32];
-    int size;
-    int used;
-    char data[MAX_FILE_SIZE];  // UPDATED
-} Inode;
-
-// Virtual File System mount structure
-typedef struct {
-    char device[16];          // Device name
-    char mount_point[16];     // Mount point path
-    char fs_type[16];         // Filesystem type
-    int inodes_used;          // Number of used inodes
-    int files;                // Number of files
-    Inode inodes[MAX_INODES]; // Inode table
-} VFS_Mount;
-
-// File descriptor structure
-typedef struct {
-    int inode_id;             // Associated inode
-    int used;                 // 1: in use, 0: free
-    int offset;               // Current file offset
-} FileDescriptor;
-
-// Global Variables
-Process processes[MAX_PROCESSES]; // Array of processes
-int current_process = 0;          // Index of currently running process
-char keyboard_buffer[256];         // Buffer for keyboard input
-int buffer_index = 0;             // Current index in keyboard buffer
-char shell_buffer[256];           // Buffer for shell commands
-int shell_index = 0;              // Current index in shell buffer
-char command_log[512];            // Buffer for command history
-int log_index = 0;                // Current index in command log
-volatile int schedule_flag = 0;   // Flag to trigger scheduling
-int menu_active = 0;              // Menu state: 0 (off), 1 (on)
-int shell_active = 0;             // Shell state: 0 (off), 1 (on)
-VFS_Mount vfs;                    // Single VFS mount
-FileDescriptor fds[MAX_FILES];    // File descriptor table
-unsigned int* kernel_page_dir;    // Kernel page directory
-int vfs_initialized = 0;          // Flag to track VFS initialization
-
-// Function Prototypes
-void DiaryNote(void);
-void FileWrite(const char* filename);
-void display_shell_prompt(void);
-
-// String manipulation functions
-void custom_strcpy(char* dest, const char* src) {
-    while (*src) {
-        *dest++ = *src++;
-    }
-    *dest = 0;
-}
-
-int strcmp(const char* s1, const char* s2) {
-    while (*s1 && *s2 && *s1 == *s2) {
-        s1++;
-        s2++;
-    }
-    return *s1 - *s2;
-}
-
-int strncmp(const char* s1, const char* s2, int n) {
-    while (n > 0 && *s1 && *s2 && *s1 == *s2) {
-        s1++;
-        s2++;
-        n--;
-    }
-    if (n == 0) return 0;
-    return *s1 - *s2;
-}
-
-// VGA Display Functions
-void clear_screen() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    for (int i = 0; i < VGA_WIDTH * VGA_HEIGHT; i++) {
-        vga[i] = 0x0700; // White on black
-    }
-}
-
-void print_string(const char* str, int row, int col) {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    int index = row * VGA_WIDTH + col;
-    while (*str && index < VGA_WIDTH * VGA_HEIGHT) {
-        vga[index] = 0x0700 | (*str & 0xFF); // Ensure ASCII
-        str++;
-        index++;
-    }
-}
-
-void print_string_with_attr(const char* str, int row, int col, unsigned char attr) {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    int index = row * VGA_WIDTH + col;
-    while (*str && index < VGA_WIDTH * VGA_HEIGHT) {
-        vga[index] = (attr << 8) | (*str & 0xFF);
-        str++;
-        index++;
-    }
-}
-
-void print_hex_byte(unsigned char value, int row, int col) {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    const char hex[] = "0123456789ABCDEF";
-    if (row * VGA_WIDTH + col + 1 < VGA_WIDTH * VGA_HEIGHT) {
-        vga[row * VGA_WIDTH + col] = 0x4F00 | hex[(value >> 4) & 0xF];
-        vga[row * VGA_WIDTH + col + 1] = 0x4F00 | hex[value & 0xF];
-    }
-}
-
-void print_number(int value, int row, int col) {
-    char buf[16];
-    int i = 0, temp = value;
-    if (temp == 0) {
-        buf[i++] = '0';
-    } else {
-        while (temp) {
-            buf[i++] = (temp % 10) + '0';
-            temp /= 10;
-        }
-    }
-    buf[i] = 0;
-    for (int j = 0; j < i / 2; j++) {
-        char t = buf[j];
-        buf[j] = buf[i - j - 1];
-        buf[i - j - 1] = t;
-    }
-    print_string(buf, row, col);
-}
-
-void redraw_write_buffer(int text_row_start, int text_col, int rect_width, int rect_height) {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    const int visible_rows = rect_height - 6;
-    const int visible_cols = rect_width - 4;
-
-    int start_pos = file_write_index - (visible_rows * visible_cols);
-    if (start_pos < 0) start_pos = 0;
-
-    for (int i = 0; i < visible_rows * visible_cols; i++) {
-        int buffer_pos = start_pos + i;
-        int r = i / visible_cols;
-        int c = i % visible_cols;
-        char ch = (buffer_pos < file_write_index) ? file_write_buffer[buffer_pos] : ' ';
-        vga[(text_row_start + r) * VGA_WIDTH + text_col + c] = 0x2F00 | ch;
-    }
-}
-
-// Virtual Memory Management
-void init_paging() {
-    print_string("Initializing paging...", 1, 0);
-    kernel_page_dir = (unsigned int*)0x100000; // Page directory at 1MB
-    for (int i = 0; i < 1024; i++) {
-        kernel_page_dir[i] = 0;
-    }
-    unsigned int* page_table = (unsigned int*)0x101000; // First page table
-    for (int i = 0; i < 1024; i++) {
-        page_table[i] = (i * PAGE_SIZE) | 0x3; // Present, R/W, Supervisor
-    }
-    kernel_page_dir[0] = (unsigned int)page_table | 0x3;
-    kernel_page_dir[768] = (unsigned int)page_table | 0x3;
-    unsigned int vga_addr = 0xB8000;
-    int pt_index = vga_addr / PAGE_SIZE;
-    page_table[pt_index] = vga_addr | 0x3;
-    //print_string("Page directory set up", 2, 0);
-    asm volatile(
-        "mov %0, %%cr3\n\t"
-        "mov %%cr0, %%eax\n\t"
-        "or $0x80000000, %%eax\n\t"
-        "mov %%eax, %%cr0"
-        : : "r"(kernel_page_dir) : "eax"
-    );
-    print_string("Paging enabled", 2, 0);
-}
-
-unsigned int* create_user_page_dir() {
-    unsigned int* page_dir = (unsigned int*)0x200000;
-    for (int i = 0; i < 1024; i++) {
-        page_dir[i] = 0;
-    }
-    unsigned int* page_table = (unsigned int*)0x201000;
-    for (int i = 0; i < 1024; i++) {
-        page_table[i] = (i * PAGE_SIZE + USER_BASE) | 0x7; // Present, R/W, User
-    }
-    page_dir[0] = (unsigned int)page_table | 0x7;
-    page_dir[768] = kernel_page_dir[768];
-    return page_dir;
-}
-
-// Virtual File System
-void init_vfs() {
-    print_string("Initializing VFS...", 3, 0);
-    
-    // Debug: Step 1
-    //print_string("Step 1: Setting device", 4, 0);
-    custom_strcpy(vfs.device, "hda");
-    
-    // Debug: Step 2
-    //print_string("Step 2: Setting mount point", 5, 0);
-    custom_strcpy(vfs.mount_point, "/");
-    
-    // Debug: Step 3
-    //print_string("Step 3: Setting fs type", 6, 0);
-    custom_strcpy(vfs.fs_type, "ext2");
-    
-    // Debug: Step 4
-    //print_string("Step 4: Initializing counters", 7, 0);
-    vfs.inodes_used = 0;
-    vfs.files = 0;
-    
-    // Debug: Step 5
-    //print_string("Step 5: Initializing inodes", 8, 0);
-    for (int i = 0; i < MAX_INODES; i++) {
-        vfs.inodes[i].used = 0;
-        vfs.inodes[i].id = 0;
-        vfs.inodes[i].size = 0;
-        for (int j = 0; j < 32; j++) {
-            vfs.inodes[i].name[j] = 0;
-        }
-        for (int j = 0; j < 128; j++) {
-            vfs.inodes[i].data[j] = 0;
-        }
-    }
-    
-    // Debug: Step 6
-    //print_string("Step 6: Initializing file descriptors", 9, 0);
-    for (int i = 0; i < MAX_FILES; i++) {
-        fds[i].used = 0;
-        fds[i].inode_id = -1;
-        fds[i].offset = 0;
-    }
-    
-    // Debug: Step 7
-    //print_string("Step 7: Setting VFS flag", 10, 0);
-    vfs_initialized = 1;
-    
-    // Final confirmation
-    print_string("VFS initialized", 4, 0);
-}
-
-int vfs_create_file(const char* name) {
-    if (!vfs_initialized) {
-        print_string("VFS not initialized in create", 16, 0);
-        return -1;
-    }
-    if (vfs.inodes_used >= MAX_INODES) {
-        print_string("No free inodes", 16, 0);
-        return -1;
-    }
-    for (int i = 0; i < MAX_INODES; i++) {
-        if (!vfs.inodes[i].used) {
-            vfs.inodes[i].used = 1;
-            vfs.inodes[i].id = i;
-            int j = 0;
-            while (name[j] && j < 31) {
-                vfs.inodes[i].name[j] = name[j];
-                j++;
-            }
-            vfs.inodes[i].name[j] = 0;
-            vfs.inodes[i].size = 0;
-            vfs.inodes_used++;
-            vfs.files++;
-            print_string("Created inode: ", 16, 0);
-            print_number(i, 16, 15);
-            return i;
-        }
-    }
-    print_string("No free inodes found", 16, 0);
-    return -1;
-}
-
-int vfs_open_file(const char* name) {
-    if (!vfs_initialized) {
-        print_string("VFS not initialized in open", 16, 0);
-        return -1;
-    }
-    for (int i = 0; i < MAX_INODES; i++) {
-        if (vfs.inodes[i].used && strcmp(vfs.inodes[i].name, name) == 0) {
-            for (int j = 0; j < MAX_FILES; j++) {
-                if (!fds[j].used) {
-                    fds[j].used = 1;
-                    fds[j].inode_id = i;
-                    fds[j].offset = 0;
-                    print_string("Opened fd: ", 16, 0);
-                    print_number(j, 16, 11);
-                    return j;
-                }
-            }
-            print_string("No free file descriptors", 16, 0);
-            return -1;
-        }
-    }
-    print_string("File not found: ", 16, 0);
-    print_string(name, 16, 16);
-    return -1;
-}
-
-// Fix vfs_read_file to allow full reads:
-int vfs_read_file(int fd, char* buf, int len) {
-    if (!vfs_initialized) {
-        print_string("VFS not initialized in read", 17, 0);
-        return -1;
-    }
-    if (fd < 0 || fd >= MAX_FILES || !fds[fd].used) {
-        print_string("Invalid file descriptor: ", 17, 0);
-        print_number(fd, 17, 25);
-        return -1;
-    }
-    Inode* inode = &vfs.inodes[fds[fd].inode_id];
-    if (!inode->used) {
-        print_string("Inode not used: ", 17, 0);
-        print_number(fds[fd].inode_id, 17, 16);
-        return -1;
-    }
-    if (inode->size == 0 || fds[fd].offset >= inode->size) {
-        print_string("File empty or offset beyond size", 17, 0);
-        return 0;
-    }
-    int bytes = 0;
-    while (bytes < len && fds[fd].offset < inode->size) {  // REMOVED 128 cap
-        buf[bytes] = inode->data[fds[fd].offset];
-        bytes++;
-        fds[fd].offset++;
-    }
-    print_string("Read bytes: ", 17, 0);
-    print_number(bytes, 17, 12);
-    return bytes;
-}
-
-// Fix vfs_write_file to match new MAX_FILE_SIZE
-int vfs_write_file(int fd, const char* buf, int len) {
-    if (!vfs_initialized) {
-        print_string("VFS not initialized in write", 18, 0);
-        return -1;
-    }
-    if (fd < 0 || fd >= MAX_FILES || !fds[fd].used) {
-        print_string("Invalid file descriptor in write: ", 18, 0);
-        print_number(fd, 18, 34);
-        return -1;
-    }
-    Inode* inode = &vfs.inodes[fds[fd].inode_id];
-    if (!inode->used) {
-        print_string("Inode not used in write: ", 18, 0);
-        print_number(fds[fd].inode_id, 18, 25);
-        return -1;
-    }
-    int bytes = 0;
-    while (bytes < len && fds[fd].offset < MAX_FILE_SIZE) {  // UPDATED
-        inode->data[fds[fd].offset] = buf[bytes];
-        bytes++;
-        fds[fd].offset++;
-    }
-    if (fds[fd].offset > inode->size) {
-        inode->size = fds[fd].offset;
-    }
-    print_string("Wrote bytes: ", 18, 0);
-    print_number(bytes, 18, 13);
-    return bytes;
-}
-
-void vfs_close_file(int fd) {
-    if (!vfs_initialized) {
-        print_string("VFS not initialized in close", 19, 0);
-        return;
-    }
-    if (fd >= 0 && fd < MAX_FILES && fds[fd].used) {
-        fds[fd].used = 0;
-        fds[fd].inode_id = -1;
-        fds[fd].offset = 0;
-        print_string("Closed fd: ", 19, 0);
-        print_number(fd, 19, 11);
-    }
-}
-
-void vfs_list_files(char* buf, int* len) {
-    if (!vfs_initialized) {
-        print_string("VFS not initialized in ls", 16, 0);
-        *len = 0;
-        buf[0] = 0;
-        return;
-    }
-    int pos = 0;
-    for (int i = 0; i < MAX_INODES; i++) {
-        if (vfs.inodes[i].used) {
-            int j = 0;
-            while (vfs.inodes[i].name[j] && j < 31 && pos < 255) {
-                char c = vfs.inodes[i].name[j];
-                if (c >= 32 && c <= 126) {
-                    buf[pos++] = c;
-                }
-                j++;
-            }
-            if (pos < 255) {
-                buf[pos++] = ' ';
-            }
-        }
-    }
-    buf[pos] = 0;
-    *len = pos;
-}
-
-// File Write Interface
-void FileWrite(const char* filename) {
-    if (!vfs_initialized) {
-        clear_screen();
-        print_string("VFS not initialized. File operations disabled.", 12, 10);
-        for (volatile int i = 0; i < 1000000; i++);
-        clear_screen();
-        display_shell_prompt();
-        shell_active = 1;
-        return;
-    }
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    const int rect_width = 60;
-    const int rect_height = 15;
-    const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
-    const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
-    const int rect_end_row = rect_start_row + rect_height - 1;
-    const int rect_end_col = rect_start_col + rect_width - 1;
-
-    clear_screen();
-
-    for (int row = rect_start_row; row <= rect_end_row; row++) {
-        for (int col = rect_start_col; col <= rect_end_col; col++) {
-            vga[row * VGA_WIDTH + col] = 0x2F00 | ' ';
-        }
-    }
-
-    for (int col = rect_start_col; col <= rect_end_col; col++) {
-        vga[rect_start_row * VGA_WIDTH + col] = 0x2F00 | '-';
-        vga[rect_end_row * VGA_WIDTH + col] = 0x2F00 | '-';
-    }
-    for (int row = rect_start_row + 1; row < rect_end_row; row++) {
-        vga[row * VGA_WIDTH + rect_start_col] = 0x2F00 | '|';
-        vga[row * VGA_WIDTH + rect_end_col] = 0x2F00 | '|';
-    }
-    vga[rect_start_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
-    vga[rect_start_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
-    vga[rect_end_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
-    vga[rect_end_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
-
-    int text_row = rect_start_row + 1;
-    int text_col = rect_start_col + 2;
-    print_string_with_attr("Write to File", text_row++, text_col, 0x2F);
-    print_string_with_attr("File: ", text_row, text_col, 0x2F);
-    print_string_with_attr(filename, text_row++, text_col + 6, 0x2F);
-    print_string_with_attr("Press Enter to save, Esc to cancel.", text_row++, text_col, 0x2F);
-    print_string_with_attr("----------------------", text_row++, text_col, 0x2F);
-    //print_string_with_attr("Enter text:", text_row++, text_col, 0x2F);
-
-    for (int i = 0; i < 128; i++) {
-        file_write_buffer[i] = 0;
-    }
-    file_write_index = 0;
-    file_write_active = 1;
-}
-
-// Shell Display Functions
-void clear_shell_input() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    for (int i = 0; i < VGA_WIDTH; i++) {
-        vga[23 * VGA_WIDTH + i] = 0x0700;
-    }
-    shell_index = 0;
-    for (int i = 0; i < 256; i++) {
-        shell_buffer[i] = 0;
-    }
-}
-
-void clear_shell_output() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    for (int i = 0; i < VGA_WIDTH; i++) {
-        vga[15 * VGA_WIDTH + i] = 0x0700;
-        vga[22 * VGA_WIDTH + i] = 0x0700;
-    }
-}
-
-void clear_shell_command_prompt() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    for (int i = 0; i < VGA_WIDTH; i++) {
-        vga[20 * VGA_WIDTH + i] = 0x0700;
-    }
-}
-
-void clear_shell() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    for (int i = 15; i <= 23; i++) {
-        for (int j = 0; j < VGA_WIDTH; j++) {
-            vga[i * VGA_WIDTH + j] = 0x0700;
-        }
-    }
-    shell_index = 0;
-    for (int i = 0; i < 256; i++) {
-        shell_buffer[i] = 0;
-    }
-}
-
-void display_shell_prompt() {
-    clear_shell_input();
-    print_string_with_attr("SHELL>> ", 23, 0, 0x2F);
-}
-
-// Menu Functions
-void display_menu() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    for (int i = 0; i < VGA_WIDTH * 2; i++) {
-        vga[(VGA_HEIGHT - 2) * VGA_WIDTH + i] = 0x0700;
-    }
-    print_string("Menu: ", 24, 0);
-    print_string_with_attr("1", 24, 6, 0x0F);
-    print_string(".Show/Hide ", 24, 7);
-    print_string_with_attr("2", 24, 18, 0x0F);
-    print_string(".Exit ", 24, 19);
-    print_string_with_attr("3", 24, 25, 0x0F);
-    print_string(".Crash (BSOD) ", 24, 26);
-    print_string_with_attr("S", 24, 40, 0x0F);
-    print_string(".Shell ", 24, 41);
-    print_string_with_attr("V", 24, 48, 0x0F);
-    print_string(".Virtual Memory ", 24, 49);
-}
-
-void hide_menu() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    for (int i = 0; i < VGA_WIDTH * 2; i++) {
-        vga[(VGA_HEIGHT - 2) * VGA_WIDTH + i] = 0x0700;
-    }
-}
-
-// System Control Functions
-void halt_system() {
-    clear_screen();
-    print_string("System halted.", 12, 33);
-    asm volatile("hlt");
-    while (1);
-}
-
-void display_bsod() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    for (int i = 0; i < VGA_WIDTH * VGA_HEIGHT; i++) {
-        vga[i] = 0x2F00;
-    }
-    print_string_with_attr("*** A fatal error has occurred ***", 5, 24, 0x2F);
-    print_string_with_attr("Sebria OS has encountered a critical error and must halt.", 7, 12, 0x2F);
-    print_string_with_attr("Error Code: 0xDEADBEEF", 9, 29, 0x2F);
-    asm volatile("hlt");
-    while (1);
-}
-
-// Screen Dump Function
-void dump_screen() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    char screen_buffer[VGA_HEIGHT * (VGA_WIDTH + 1)];
-    int buffer_pos = 0;
-
-    for (int row = 0; row < VGA_HEIGHT; row++) {
-        for (int col = 0; col < VGA_WIDTH; col++) {
-            char c = (char)(vga[row * VGA_WIDTH + col] & 0xFF);
-            if (c == 0) c = ' ';
-            if (buffer_pos < VGA_HEIGHT * (VGA_WIDTH + 1) - 1) {
-                screen_buffer[buffer_pos++] = c;
-            }
-        }
-        if (buffer_pos < VGA_HEIGHT * (VGA_WIDTH + 1) - 1) {
-            screen_buffer[buffer_pos++] = '\n';
-        }
-    }
-    screen_buffer[buffer_pos ? buffer_pos - 1 : 0] = 0;
-
-    clear_shell_output();
-    print_string("Dumping screen contents...", 18, 0);
-    for (volatile int i = 0; i < 100000; i++);
-
-    const int rect_width = 60;
-    const int rect_height = 15;
-    const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
-    const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
-    const int rect_end_row = rect_start_row + rect_height - 1;
-    const int rect_end_col = rect_start_col + rect_width - 1;
-
-    clear_screen();
-
-    for (int col = rect_start_col; col <= rect_end_col; col++) {
-        vga[rect_start_row * VGA_WIDTH + col] = 0x2F00 | '-';
-        vga[rect_end_row * VGA_WIDTH + col] = 0x2F00 | '-';
-    }
-    for (int row = rect_start_row + 1; row < rect_end_row; row++) {
-        vga[row * VGA_WIDTH + rect_start_col] = 0x2F00 | '|';
-        vga[row * VGA_WIDTH + rect_end_col] = 0x2F00 | '|';
-    }
-    vga[rect_start_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
-    vga[rect_start_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
-    vga[rect_end_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
-    vga[rect_end_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
-
-    int display_row = rect_start_row + 1;
-    int display_col = rect_start_col + 1;
-    int scrollAddr = 0;
-
-    for (int row = scrollAddr; row < scrollAddr + (rect_height - 2) && row < VGA_HEIGHT; row++) {
-        for (int col = 0; col < rect_width - 2 && col < VGA_WIDTH; col++) {
-            int buf_index = row * (VGA_WIDTH + 1) + col;
-            char c = (buf_index < buffer_pos) ? screen_buffer[buf_index] : ' ';
-            if (c == '\n' || c == 0) c = ' ';
-            vga[display_row * VGA_WIDTH + display_col + col] = 0x2F00 | c;
-        }
-        display_row++;
-    }
-
-    print_string_with_attr("Press S to return to shell, Q to exit.", 21, 10, 0x2F);
-
-    while (1) {
-        unsigned char status, scancode;
-        asm volatile("inb $0x64, %0" : "=a"(status));
-        if (status & 0x01) {
-            asm volatile("inb $0x60, %0" : "=a"(scancode));
-            if (!(scancode & 0x80)) {
-                if (scancode == 0x1F) {
-                    shell_index = 0;
-                    for (int i = 0; i < 256; i++) {
-                        shell_buffer[i] = 0;
-                    }
-                    clear_screen();
-                    clear_shell();
-                    display_shell_prompt();
-                    shell_active = 1;
-                    return;
-                }
-                if (scancode == 0x10) {
-                    halt_system();
-                    return;
-                }
-            }
-        }
-        for (volatile int i = 0; i < 10000; i++);
-    }
-}
-
-// Diary Note Function
-void DiaryNote() {
-    if (!vfs_initialized) {
-        clear_screen();
-        print_string("VFS not initialized. Diary feature disabled.", 12, 10);
-        for (volatile int i = 0; i < 1000000; i++);
-        clear_screen();
-        display_shell_prompt();
-        shell_active = 1;
-        return;
-    }
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    const int rect_width = 60;
-    const int rect_height = 15;
-    const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
-    const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
-    const int rect_end_row = rect_start_row + rect_height - 1;
-    const int rect_end_col = rect_start_col + rect_width - 1;
-
-    clear_screen();
-
-    for (int row = rect_start_row; row <= rect_end_row; row++) {
-        for (int col = rect_start_col; col <= rect_end_col; col++) {
-            vga[row * VGA_WIDTH + col] = 0x2F00 | ' ';
-        }
-    }
-
-    for (int col = rect_start_col; col <= rect_end_col; col++) {
-        vga[rect_start_row * VGA_WIDTH + col] = 0x2F00 | '-';
-        vga[rect_end_row * VGA_WIDTH + col] = 0x2F00 | '-';
-    }
-    for (int row = rect_start_row + 1; row < rect_end_row; row++) {
-        vga[row * VGA_WIDTH + rect_start_col] = 0x2F00 | '|';
-        vga[row * VGA_WIDTH + rect_end_col] = 0x2F00 | '|';
-    }
-    vga[rect_start_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
-    vga[rect_start_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
-    vga[rect_end_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
-    vga[rect_end_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
-
-    int text_row = rect_start_row + 1;
-    int text_col = rect_start_col + 2;
-    print_string_with_attr("Diary Note", text_row++, text_col, 0x2F);
-    print_string_with_attr("Press Enter to save, Esc to cancel.", text_row++, text_col, 0x2F);
-    print_string_with_attr("----------------------", text_row++, text_col, 0x2F);
-    print_string_with_attr("Tell me about your day?", text_row++, text_col, 0x2F);
-
-    for (int i = 0; i < 256; i++) {
-        diary_buffer[i] = 0;
-    }
-    diary_index = 0;
-    diary_active = 1;
-}
-
-// Virtual Memory Information Display
-void display_vm_info() {
-    clear_screen();
-    print_string_with_attr("Sebria OS Virtual Memory Management", 2, 20, 0x0F);
-    print_string("Virtual Memory Status:", 4, 5);
-    print_string("Paging: Disabled", 6, 5);
-    print_string("Virtual File System (VFS):", 10, 5);
-    print_string("Status: Not initialized", 12, 5);
-    print_string("Files: ", 13, 5);
-    print_number(vfs.files, 13, 21);
-    print_string("Inodes Used: ", 14, 5);
-    print_number(vfs.inodes_used, 14, 21);
-    print_string("User-Space Processes:", 16, 5);
-    print_string("PID   Name      State     Priority", 18, 5);
-    int row = 19;
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (processes[i].pid) {
-            char buf[64];
-            int pos = 0;
-            print_number(processes[i].pid, row, 5);
-            buf[pos++] = ' ';
-            buf[pos++] = ' ';
-            buf[pos++] = ' ';
-            buf[pos++] = ' ';
-            const char* name = processes[i].privilege == 0 ? "kernel" : "user";
-            for (int j = 0; name[j]; j++) {
-                buf[pos++] = name[j];
-            }
-            while (pos < 16) buf[pos++] = ' ';
-            const char* state = processes[i].state == 1 ? "Running" : processes[i].state == 0 ? "Ready" : "Terminated";
-            for (int j = 0; state[j]; j++) {
-                buf[pos++] = state[j];
-            }
-            while (pos < 24) buf[pos++] = ' ';
-            print_number(processes[i].priority, row, 24);
-            buf[pos] = 0;
-            print_string(buf, row++, 8);
-        }
-    }
-    print_string("Press any key to return to menu...", 22, 20);
-
-    unsigned char status, scancode;
-    while (1) {
-        asm volatile("inb $0x64, %0" : "=a"(status));
-        if (status & 0x01) {
-            asm volatile("inb $0x60, %0" : "=a"(scancode));
-            if (!(scancode & 0x80)) {
-                asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-                break;
-            }
-        }
-    }
-    clear_screen();
-}
-
-void append_to_log(const char* command) {
-    if (command[0] == 0) return;
-    int i = 0;
-    while (command[i] && log_index < 511) {
-        command_log[log_index++] = command[i++];
-    }
-    if (log_index < 511) {
-        command_log[log_index++] = '\n';
-    }
-}
-
-// Process Management
-int create_process(void (*task)(), int priority, int privilege) {
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (!processes[i].pid) {
-            processes[i].task = task;
-            processes[i].state = 0;
-            processes[i].pid = i + 1;
-            processes[i].priority = priority;
-            processes[i].privilege = privilege;
-            processes[i].user_stack = privilege == 3 ? USER_BASE + PAGE_SIZE * 2 : 0;
-            processes[i].page_dir = privilege == 3 ? (unsigned int)create_user_page_dir() : (unsigned int)kernel_page_dir;
-            return i;
-        }
-    }
-    return -1;
-}
-
-void kill_process(int pid) {
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (processes[i].pid == pid) {
-            processes[i].state = 2;
-            processes[i].pid = 0;
-            if (i == current_process) {
-                schedule_flag = 1;
-            }
-            break;
-        }
-    }
-}
-
-void schedule() {
-    int next = -1;
-    int max_priority = -1;
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (processes[i].state == 0 && processes[i].priority > max_priority) {
-            max_priority = processes[i].priority;
-            next = i;
-        }
-    }
-    if (next != -1 && next != current_process) {
-        processes[current_process].state = 0;
-        current_process = next;
-        processes[current_process].state = 1;
-        // Skip page directory switch since paging is disabled
-        // asm volatile("mov %0, %%cr3" : : "r"(processes[current_process].page_dir) : "memory");
-    }
-}
-
-// System Call Handler
-void syscall_handler() {
-    unsigned int syscall_num, arg1, arg2, arg3;
-    asm volatile(
-        "mov %%eax, %0\n\t"
-        "mov %%ebx, %1\n\t"
-        "mov %%ecx, %2\n\t"
-        "mov %%edx, %3"
-        : "=r"(syscall_num), "=r"(arg1), "=r"(arg2), "=r"(arg3)
-    );
-    int result = 0;
-    switch (syscall_num) {
-        case SYS_WRITE:
-            print_string((const char*)arg1, 15, 0);
-            break;
-        case SYS_OPEN:
-            result = vfs_open_file((const char*)arg1);
-            break;
-        case SYS_READ:
-            result = vfs_read_file(arg1, (char*)arg2, arg3);
-            break;
-        case SYS_CLOSE:
-            vfs_close_file(arg1);
-            break;
-        case SYS_CREATE:
-            result = vfs_create_file((const char*)arg1);
-            break;
-        case SYS_LS:
-            vfs_list_files((char*)arg1, (int*)arg2);
-            break;
-        case SYS_PS:
-            result = 0;
-            for (int i = 0; i < MAX_PROCESSES; i++) {
-                if (processes[i].pid) result++;
-            }
-            break;
-        case SYS_KILL:
-            kill_process(arg1);
-            break;
-        case SYS_EXIT:
-            kill_process(processes[current_process].pid);
-            break;
-        default:
-            print_string("Unknown syscall", 15, 0);
-    }
-    asm volatile("mov %0, %%eax" : : "r"(result) : "eax");
-    asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-}
-
-// Interrupt Handlers
-void default_handler() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    vga[2] = 0x4F44; // 'D'
-    while (1);
-}
-
-void double_fault_handler() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    vga[4] = 0x4F46; // 'F'
-    while (1);
-}
-
-void timer_handler() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    vga[6] = 0x4F54; // 'T'
-    schedule_flag = 1;
-    asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-}
-
-void keyboard_handler() {
-    static const char scancode_to_ascii[] = {
-        0, 0, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', 0,
-        0, 'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p', '[', ']', '\n',
-        0, 'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', ';', '\'', '`', 0,
-        '\\', 'z', 'x', 'c', 'v', 'b', 'n', 'm', ',', '.', '/', 0, 0, 0,
-        ' ', 0
-    };
-
-    unsigned char scancode;
-    asm volatile("inb $0x60, %0" : "=a"(scancode));
-
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    vga[0] = 0x4F4B; // 'K'
-
-    if (scancode & 0x80) { // Key release
-        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-        return;
-    }
-
-    print_hex_byte(scancode, 0, 2);
-
-    char c = (scancode < sizeof(scancode_to_ascii) && scancode_to_ascii[scancode]) ? scancode_to_ascii[scancode] : 0;
-
-   if (file_write_active) {
-    const int rect_width = 60;
-    const int rect_height = 15;
-    const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
-    const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
-    const int text_row_start = rect_start_row + 5;
-    const int text_col = rect_start_col + 2;
-
-    if (scancode == 0x0E && file_write_index > 0) {  // Backspace
-        file_write_index--;
-        file_write_buffer[file_write_index] = 0;
-        redraw_write_buffer(text_row_start, text_col, rect_width, rect_height);
-    } else if (scancode == 0x1C) {  // Enter - Save
-        file_write_buffer[file_write_index] = 0;
-        if (file_write_index > 0 && current_file_fd >= 0) {
-            int bytes_written = vfs_write_file(current_file_fd, file_write_buffer, file_write_index);
-            print_string("Bytes written: ", 18, 0);
-            print_number(bytes_written, 18, 15);
-            vfs_close_file(current_file_fd);
-            current_file_fd = -1;
-        } else {
-            print_string("No data or invalid fd", 18, 0);
-            if (current_file_fd >= 0) {
-                vfs_close_file(current_file_fd);
-                current_file_fd = -1;
-            }
-        }
-        file_write_active = 0;
-        clear_screen();
-        clear_shell();
-        display_shell_prompt();
-        shell_active = 1;
-    } else if (scancode == 0x01) {  // Esc - Cancel
-        if (current_file_fd >= 0) {
-            vfs_close_file(current_file_fd);
-            current_file_fd = -1;
-        }
-        file_write_active = 0;
-        clear_screen();
-        clear_shell();
-        display_shell_prompt();
-        shell_active = 1;
-    } else if (c && c >= 32 && c <= 126 && file_write_index < FILE_WRITE_MAX - 1) {
-        file_write_buffer[file_write_index++] = c;
-        file_write_buffer[file_write_index] = 0;
-        redraw_write_buffer(text_row_start, text_col, rect_width, rect_height);
-    }
-
-    asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-    return;
-}
-
-  // Handle diary input
-    if (diary_active) {
-        const int rect_width = 60;
-        const int rect_height = 15;
-        const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
-        const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
-        const int text_row_start = rect_start_row + 5;
-        const int text_col = rect_start_col + 2;
-        static int current_row = 0;
-        static int current_col = 0;
-        int text_row = text_row_start + current_row;
-
-        if (scancode == 0x0E && diary_index > 0) { // Backspace
-            diary_index--;
-            if (current_col > 0) {
-                current_col--;
-            } else if (current_row > 0) {
-                current_row--;
-                current_col = rect_width - 4 - 1;
-            }
-            vga[(text_row_start + current_row) * VGA_WIDTH + text_col + current_col] = 0x2F00 | ' ';
-            diary_buffer[diary_index] = 0;
-        } else if (scancode == 0x1C) { // Enter
-            diary_buffer[diary_index] = 0;
-            if (diary_index > 0) {
-                append_to_log(diary_buffer);
-                int fd = vfs_open_file("diary.txt");
-                if (fd < 0) {
-                    fd = vfs_create_file("diary.txt");
-                }
-                if (fd >= 0) {
-                    vfs_write_file(fd, diary_buffer, diary_index);
-                    vfs_close_file(fd);
-                }
-            }
-            diary_active = 0;
-            current_row = 0;
-            current_col = 0;
-            clear_screen();
-            clear_shell();
-            display_shell_prompt();
-            shell_active = 1;
-        } else if (scancode == 0x01) { // Escape
-            diary_active = 0;
-            current_row = 0;
-            current_col = 0;
-            clear_screen();
-            clear_shell();
-            display_shell_prompt();
-            shell_active = 1;
-        } else if (c && current_row < rect_height - 6) {
-            if (current_col >= rect_width - 4) {
-                current_row++;
-                current_col = 0;
-                text_row = text_row_start + current_row;
-            }
-            if (current_row < rect_height - 6) {
-                diary_buffer[diary_index] = c;
-                vga[text_row * VGA_WIDTH + text_col + current_col] = 0x2F00 | c;
-                diary_index++;
-                current_col++;
-                diary_buffer[diary_index] = 0;
-            }
-        }
-        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-        return;
-    }
-
-
-
-    if (c == '1') {
-        if (!menu_active && !shell_active) {
-            menu_active = 1;
-            display_menu();
-        } else if (menu_active && !shell_active) {
-            menu_active = 0;
-            hide_menu();
-        }
-        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-        return;
-    }
-
-    if (c == '2' && !shell_active) {
-        halt_system();
-        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-        return;
-    }
-
-    if (c == '3' && menu_active && !shell_active) {
-        display_bsod();
-        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-        return;
-    }
-
-    if (menu_active && !shell_active) {
-        if (c == 'S' || c == 's') {
-            shell_active = 1;
-            display_shell_prompt();
-        } else if (c == 'V' || c == 'v') {
-            display_vm_info();
-        }
-        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-        return;
-    }
-
-    if (shell_active) {
-        if (shell_index == 0) {
-            clear_shell_input();
-            display_shell_prompt();
-            for (int i = 0; i < 256; i++) {
-                shell_buffer[i] = 0;
-            }
-        }
-
-        if (scancode == 0x0E && shell_index > 0) {
-            shell_index--;
-            shell_buffer[shell_index] = 0;
-            for (int i = 8; i < VGA_WIDTH; i++) {
-                vga[23 * VGA_WIDTH + i] = 0x0700;
-            }
-            print_string_with_attr("SHELL>> ", 23, 0, 0x2F);
-            for (int i = 0; i < shell_index; i++) {
-                vga[23 * VGA_WIDTH + 8 + i] = 0x2F00 | shell_buffer[i];
-            }
-            asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-            return;
-        }
-
-        if (scancode == 0x1C) {
-            shell_buffer[shell_index] = 0;
-            clear_shell_command_prompt();
-            clear_shell_output();
-
-            for (int i = 0; i < shell_index; i++) {
-                if (shell_buffer[i] < 32 || shell_buffer[i] > 126) {
-                    shell_buffer[i] = ' ';
-                }
-            }
-            shell_buffer[shell_index] = 0;
-
-            if (strcmp(shell_buffer, "print") == 0) {
-                append_to_log(shell_buffer);
-                print_string("Print command executed!", 15, 0);
-                clear_shell_command_prompt();
-                print_string("Command: ", 20, 0);
-                print_string(shell_buffer, 20, 9);
-                display_shell_prompt();
-            } else if (strcmp(shell_buffer, "halt") == 0) {
-                append_to_log(shell_buffer);
-                halt_system();
-            } else if (strcmp(shell_buffer, "dump") == 0) {
-                append_to_log(shell_buffer);
-                dump_screen();
-            } else if (strcmp(shell_buffer, "virtual") == 0) {
-                append_to_log(shell_buffer);
-                display_vm_info();
-            } else if (strcmp(shell_buffer, "ls") == 0) {
-                append_to_log(shell_buffer);
-                if (!vfs_initialized) {
-                    print_string("VFS not initialized. ls command disabled.", 15, 0);
-                } else {
-                    char buf[256] = {0};
-                    int len;
-                    vfs_list_files(buf, &len);
-                    if (len > 0) {
-                        for (int i = 0; i < len && i < 255; i++) {
-                            if (buf[i] < 32 || buf[i] > 126) {
-                                buf[i] = ' ';
-                            }
-                        }
-                        buf[len] = 0;
-                        print_string(buf, 15, 0);
-                    } else {
-                        print_string("No files found or VFS not initialized.", 15, 0);
-                    }
-                }
-                clear_shell_command_prompt();
-                print_string("Command: ", 20, 0);
-                print_string(shell_buffer, 20, 9);
-                display_shell_prompt();
-            } else if (strcmp(shell_buffer, "ps") == 0) {
-                append_to_log(shell_buffer);
-                char buf[64];
-                int row = 15;
-                for (int i = 0; i < MAX_PROCESSES; i++) {
-                    if (processes[i].pid) {
-                        int pos = 0;
-                        print_number(processes[i].pid, row, 0);
-                        pos += 4;
-                        const char* name = processes[i].privilege == 0 ? "kernel" : "user";
-                        for (int j = 0; name[j]; j++) {
-                            buf[pos++] = name[j];
-                        }
-                        while (pos < 16) buf[pos++] = ' ';
-                        const char* state = processes[i].state == 1 ? "Running" : processes[i].state == 0 ? "Ready" : "Terminated";
-                        for (int j = 0; state[j]; j++) {
-                            buf[pos++] = state[j];
-                        }
-                        buf[pos] = 0;
-                        print_string(buf, row++, 4);
-                    }
-                }
-                clear_shell_command_prompt();
-                print_string("Command: ", 20, 0);
-                print_string(shell_buffer, 20, 9);
-                display_shell_prompt();
-            } else if (strcmp(shell_buffer, "clear") == 0) {
-                append_to_log(shell_buffer);
-                clear_shell();
-                display_shell_prompt();
-            } else if (strcmp(shell_buffer, "diary") == 0) {
-                append_to_log(shell_buffer);
-                DiaryNote();
-            } else if (strncmp(shell_buffer, "touch ", 6) == 0) {
-                append_to_log(shell_buffer);
-                if (!vfs_initialized) {
-                    print_string("VFS not initialized. touch command disabled.", 15, 0);
-                    clear_shell_command_prompt();
-                    print_string("Command: ", 20, 0);
-                    print_string(shell_buffer, 20, 9);
-                    display_shell_prompt();
-                } else {
-                    const char* filename = shell_buffer + 6;
-                    int inode = vfs_create_file(filename);
-                    if (inode >= 0) {
-                        current_file_fd = vfs_open_file(filename);
-                        if (current_file_fd >= 0) {
-                            print_string("File created: ", 15, 0);
-                            print_string(filename, 15, 14);
-                            FileWrite(filename);
-                        } else {
-                            print_string("Failed to open file for writing", 15, 0);
-                            clear_shell_command_prompt();
-                            print_string("Command: ", 20, 0);
-                            print_string(shell_buffer, 20, 9);
-                            display_shell_prompt();
-                        }
-                    } else {
-                        print_string("Failed to create file", 15, 0);
-                        clear_shell_command_prompt();
-                        print_string("Command: ", 20, 0);
-                        print_string(shell_buffer, 20, 9);
-                        display_shell_prompt();
-                    }
-                }
-            } else if (strncmp(shell_buffer, "cat ", 4) == 0) {
-    append_to_log(shell_buffer);
-    if (!vfs_initialized) {
-        print_string("VFS not initialized. cat command disabled.", 1, 0);
-    } else {
-        const char* filename = shell_buffer + 4;
-        int fd = vfs_open_file(filename);
-        if (fd >= 0) {
-            clear_screen();
-            char buf[1024] = {0};
-            int total_read = 0;
-            int bytes_read = vfs_read_file(fd, buf, sizeof(buf) - 1);
-
-            vfs_close_file(fd);
-
-            if (bytes_read <= 0) {
-                print_string("File is empty or read error.", 1, 0);
-            } else {
-                int row = 1, col = 0;
-                for (int i = 0; i < bytes_read; i++) {
-                    char c = buf[i];
-                    if (c < 32 || c > 126) c = ' ';
-
-                    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-                    vga[row * VGA_WIDTH + col] = 0x0700 | c;
-                    col++;
-                    if (col >= VGA_WIDTH) {
-                        col = 0;
-                        row++;
-                        if (row > 21) {
-                            // Show prompt to continue
-                            print_string("-- More -- Press Space to continue --", 22, 20);
-
-                            // Wait for keypress
-                            unsigned char status, scancode;
-                            while (1) {
-                                asm volatile("inb $0x64, %0" : "=a"(status));
-                                if (status & 0x01) {
-                                    asm volatile("inb $0x60, %0" : "=a"(scancode));
-                                    if (!(scancode & 0x80)) {
-                                        break;
-                                    }
-                                }
-                            }
-
-                            clear_screen();
-                            row = 1;
-                            col = 0;
-                        }
-                    }
-                }
-                // If end of file doesn't end with full screen, just wait for key
-                print_string("-- End of File -- Press any key --", 22, 20);
-                unsigned char status, scancode;
-                while (1) {
-                    asm volatile("inb $0x64, %0" : "=a"(status));
-                    if (status & 0x01) {
-                        asm volatile("inb $0x60, %0" : "=a"(scancode));
-                        if (!(scancode & 0x80)) break;
-                    }
-                }
-                clear_screen();
-            }
-        } else {
-            print_string("File not found.", 1, 0);
-        }
-    }
-
-    // Reset shell
-    clear_shell_command_prompt();
-    print_string("Command: ", 20, 0);
-    print_string(shell_buffer, 20, 9);
-    display_shell_prompt();
-} else if (strncmp(shell_buffer, "kill ", 5) == 0) {
-                append_to_log(shell_buffer);
-                int pid = 0;
-                for (int i = 5; shell_buffer[i] >= '0' && shell_buffer[i] <= '9'; i++) {
-                    pid = pid * 10 + (shell_buffer[i] - '0');
-                }
-                int found = 0;
-                for (int i = 0; i < MAX_PROCESSES; i++) {
-                    if (processes[i].pid == pid) {
-                        kill_process(pid);
-                        print_string("Process killed: ", 15, 0);
-                        print_number(pid, 15, 16);
-                        found = 1;
-                        break;
-                    }
-                }
-                if (!found) {
-                    print_string("Process not found", 15, 0);
-                }
-                clear_shell_command_prompt();
-                print_string("Command: ", 20, 0);
-                print_string(shell_buffer, 20, 9);
-                display_shell_prompt();
-            } else {
-                if (shell_buffer[0] != 0) {
-                    append_to_log(shell_buffer);
-                    print_string("Unknown command.", 22, 0);
-                    clear_shell_command_prompt();
-                    print_string("Command: ", 20, 0);
-                    print_string(shell_buffer, 20, 9);
-                }
-                display_shell_prompt();
-            }
-
-            shell_index = 0;
-            for (int i = 0; i < 256; i++) {
-                shell_buffer[i] = 0;
-            }
-            asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-            return;
-        }
-
-        if (c && c >= 32 && c <= 126 && shell_index < VGA_WIDTH - 9) {
-            shell_buffer[shell_index] = c;
-            for (int i = 8; i < VGA_WIDTH; i++) {
-                vga[23 * VGA_WIDTH + i] = 0x0700;
-            }
-            print_string_with_attr("SHELL>> ", 23, 0, 0x2F);
-            for (int i = 0; i < shell_index + 1; i++) {
-                vga[23 * VGA_WIDTH + 8 + i] = 0x2F00 | shell_buffer[i];
-            }
-            shell_index++;
-            shell_buffer[shell_index] = 0;
-        }
-        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-        return;
-    }
-
-    if (scancode == 0x0E && buffer_index > 0) {
-        buffer_index--;
-        vga[15 * VGA_WIDTH + buffer_index] = 0x0700;
-        keyboard_buffer[buffer_index] = 0;
-        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-        return;
-    }
-
-    if (scancode == 0x1C) {
-        buffer_index = 0;
-        for (int i = 0; i < VGA_WIDTH; i++) {
-            vga[15 * VGA_WIDTH + i] = 0x0700;
-        }
-        for (int i = 0; i < 256; i++) {
-            keyboard_buffer[i] = 0;
-        }
-        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-        return;
-    }
-
-    if (c && c >= 32 && c <= 126 && buffer_index < VGA_WIDTH - 1) {
-        keyboard_buffer[buffer_index] = c;
-        vga[15 * VGA_WIDTH + buffer_index] = 0x0700 | c;
-        buffer_index++;
-        keyboard_buffer[buffer_index] = 0;
-    }
-    asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
-}
-
-// Keyboard Initialization
-void wait_kbc_input_buffer() {
-    unsigned char status;
-    do {
-        asm volatile("inb $0x64, %0" : "=a"(status));
-    } while (status & 0x02);
-}
-
-void wait_kbc_output_buffer() {
-    unsigned char status;
-    do {
-        asm volatile("inb $0x64, %0" : "=a"(status));
-    } while (!(status & 0x01));
-}
-
-void init_keyboard() {
-    unsigned char status;
-    wait_kbc_input_buffer();
-    asm volatile("mov $0xAD, %%al\n\tout %%al, $0x64" : : : "eax");
-    wait_kbc_input_buffer();
-    asm volatile("mov $0xA7, %%al\n\tout %%al, $0x64" : : : "eax");
-    asm volatile("inb $0x60, %0" : "=a"(status) : : "memory");
-    wait_kbc_input_buffer();
-    asm volatile("mov $0xAE, %%al\n\tout %%al, $0x64" : : : "eax");
-    wait_kbc_input_buffer();
-    asm volatile("mov $0x20, %%al\n\tout %%al, $0x64" : : : "eax");
-    wait_kbc_output_buffer();
-    asm volatile("inb $0x60, %0" : "=a"(status) : : "memory");
-    status |= 0x01;
-    status &= ~0x02;
-    wait_kbc_input_buffer();
-    asm volatile("mov $0x60, %%al\n\tout %%al, $0x64" : : : "eax");
-    wait_kbc_input_buffer();
-    asm volatile("mov %0, %%al\n\tout %%al, $0x60" : : "r"(status) : "eax", "memory");
-    wait_kbc_input_buffer();
-    asm volatile("mov $0xFF, %%al\n\tout %%al, $0x60" : : : "eax", "memory");
-    wait_kbc_output_buffer();
-    asm volatile("inb $0x60, %0" : "=a"(status) : : "memory");
-    if (status != 0xFA) {
-        print_string("KBD RESET FAIL", 1, 0);
-    }
-}
-
-// Interrupt Descriptor Table Setup
-void setup_idt() {
-    unsigned int* idt = (unsigned int*)0x10000;
-    extern void default_handler_wrapper();
-    extern void timer_handler_wrapper();
-    extern void keyboard_handler_wrapper();
-    extern void double_fault_handler_wrapper();
-    extern void syscall_handler_wrapper();
-    for (int i = 0; i < 256; i++) {
-        unsigned int handler = (unsigned int)default_handler_wrapper;
-        idt[i * 2] = (handler & 0xFFFF) | (0x08 << 16);
-        idt[i * 2 + 1] = (handler & 0xFFFF0000) | 0x8E00;
-    }
-    unsigned int df_addr = (unsigned int)double_fault_handler_wrapper;
-    idt[0x08 * 2] = (df_addr & 0xFFFF) | (0x08 << 16);
-    idt[0x08 * 2 + 1] = (df_addr & 0xFFFF0000) | 0x8E00;
-    unsigned int timer_addr = (unsigned int)timer_handler_wrapper;
-    idt[0x20 * 2] = (timer_addr & 0xFFFF) | (0x08 << 16);
-    idt[0x20 * 2 + 1] = (timer_addr & 0xFFFF0000) | 0x8E00;
-    unsigned int kb_addr = (unsigned int)keyboard_handler_wrapper;
-    idt[0x21 * 2] = (kb_addr & 0xFFFF) | (0x08 << 16);
-    idt[0x21 * 2 + 1] = (kb_addr & 0xFFFF0000) | 0x8E00;
-    unsigned int syscall_addr = (unsigned int)syscall_handler_wrapper;
-    idt[0x80 * 2] = (syscall_addr & 0xFFFF) | (0x08 << 16);
-    idt[0x80 * 2 + 1] = (syscall_addr & 0xFFFF0000) | 0xEE00;
-    struct {
-        unsigned short limit;
-        unsigned int base;
-    } __attribute__((packed)) idtr = { 256 * 8 - 1, (unsigned int)idt };
-    asm volatile("lidt %0" : : "m"(idtr));
-    asm volatile(
-        "mov $0x11, %%al\n\t"
-        "out %%al, $0x20\n\t"
-        "out %%al, $0xA0\n\t"
-        "mov $0x20, %%al\n\t"
-        "out %%al, $0x21\n\t"
-        "mov $0x28, %%al\n\t"
-        "out %%al, $0xA1\n\t"
-        "mov $0x04, %%al\n\t"
-        "out %%al, $0x21\n\t"
-        "mov $0x02, %%al\n\t"
-        "out %%al, $0xA1\n\t"
-        "mov $0x01, %%al\n\t"
-        "out %%al, $0x21\n\t"
-        "out %%al, $0xA1\n\t"
-        "mov $0xFC, %%al\n\t"
-        "out %%al, $0x21\n\t"
-        "mov $0x7F, %%al\n\t"
-        "out %%al, $0xA1\n\t"
-        : : : "eax"
-    );
-    for (volatile int i = 0; i < 10000; i++);
-}
-
-// Sample User Process
-void user_task() {
-    char msg[] = "Hello from user space!";
-    asm volatile(
-        "mov %0, %%ebx\n\t"
-        "mov $1, %%eax\n\t"
-        "int $0x80"
-        : : "r"(msg) : "eax", "ebx"
-    );
-    asm volatile("mov $3, %%eax\n\tint $0x80" : : : "eax");
-}
-
-// Sample Kernel Tasks
-void task1() {
-    int counter = 0;
-    while (1) {
-        char buf[10];
-        int i = 0, temp = counter;
-        do {
-            buf[i++] = (temp % 10) + '0';
-            temp /= 10;
-        } while (temp);
-        buf[i] = 0;
-        for (int j = 0; j < i / 2; j++) {
-            char t = buf[j];
-            buf[j] = buf[i - j - 1];
-            buf[i - j - 1] = t;
-        }
-        print_string(buf, 10, 10);
-        counter++;
-        for (volatile int j = 0; j < 100000; j++);
-        schedule_flag = 1;
-    }
-}
-
-void task2() {
-    while (1) {
-        for (volatile int j = 0; j < 100000; j++);
-        schedule_flag = 1;
-    }
-}
-
-// Startup and Animation
-void startup_animation() {
-    const char* welcome_msg = "Sebria OS!";
-    int msg_len = 0;
-    while (welcome_msg[msg_len]) msg_len++;
-    int msg_row = 12;
-    int msg_col = 35;
-    int bar_row = 13;
-    int bar_col = 30;
-    int bar_width = 20;
-    char bar[22];
-    bar[0] = '[';
-    bar[bar_width + 1] = ']';
-    bar[bar_width + 2] = 0;
-    for (int i = 1; i <= bar_width; i++) {
-        bar[i] = ' ';
-    }
-    print_string(bar, bar_row, bar_col);
-    for (int i = 0; i < bar_width; i++) {
-        bar[i + 1] = '*';
-        print_string_with_attr(bar, bar_row, bar_col, 0x09);
-        for (int j = 0; j < 10; j++) {
-            while (!schedule_flag);
-            schedule_flag = 0;
-        }
-    }
-    for (int i = 0; i < 10; i++) {
-        while (!schedule_flag);
-        schedule_flag = 0;
-    }
-    for (int i = 0; i < msg_len; i++) {
-        unsigned short* vga = (unsigned short*)VGA_BUFFER;
-        vga[msg_row * VGA_WIDTH + msg_col + i] = 0x0700 | welcome_msg[i];
-        for (int j = 0; j < 5; j++) {
-            while (!schedule_flag);
-            schedule_flag = 0;
-        }
-    }
-    for (int i = 0; i < 20; i++) {
-        while (!schedule_flag);
-        schedule_flag = 0;
-    }
-    clear_screen();
-}
-
-void display_instructions() {
-    unsigned short* vga = (unsigned short*)VGA_BUFFER;
-    const int rect_width = 60;
-    const int rect_height = 15;
-    const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
-    const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
-    const int rect_end_row = rect_start_row + rect_height - 1;
-    const int rect_end_col = rect_start_col + rect_width - 1;
-    clear_screen();
-    for (int row = rect_start_row; row <= rect_end_row; row++) {
-        for (int col = rect_start_col; col <= rect_end_col; col++) {
-            vga[row * VGA_WIDTH + col] = 0x2F00 | ' ';
-        }
-    }
-    for (int col = rect_start_col; col <= rect_end_col; col++) {
-        vga[rect_start_row * VGA_WIDTH + col] = 0x2F00 | '-';
-        vga[rect_end_row * VGA_WIDTH + col] = 0x2F00 | '-';
-    }
-    for (int row = rect_start_row + 1; row < rect_end_row; row++) {
-        vga[row * VGA_WIDTH + rect_start_col] = 0x2F00 | '|';
-        vga[row * VGA_WIDTH + rect_end_col] = 0x2F00 | '|';
-    }
-    vga[rect_start_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
-    vga[rect_start_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
-    vga[rect_end_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
-    vga[rect_end_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
-    int text_row = rect_start_row + 1;
-    int text_col = rect_start_col + 2;
-    print_string_with_attr("Sebria OS Instructions", text_row++, text_col, 0x2F);
-    print_string_with_attr("----------------------", text_row++, text_col, 0x2F);
-    print_string_with_attr("1. Press '1' to show/hide the menu.", text_row++, text_col, 0x2F);
-    print_string_with_attr("2. Press 'S' in menu to enter shell.", text_row++, text_col, 0x2F);
-    print_string_with_attr("3. Shell commands: ls, ps, touch, cat, kill, clear, diary", text_row++, text_col, 0x2F);
-    print_string_with_attr("4. Use 'touch ' to create and write to a file.", text_row++, text_col, 0x2F);
-    print_string_with_attr("5. Use 'cat ' to read a file.", text_row++, text_col, 0x2F);
-    print_string_with_attr("6. Press 'V' in menu to view virtual memory info.", text_row++, text_col, 0x2F);
-    print_string_with_attr("7. Press '2' to halt the system.", text_row++, text_col, 0x2F);
-    print_string_with_attr("8. Press '3' in menu to simulate a crash (BSOD).", text_row++, text_col, 0x2F);
-    print_string_with_attr("----------------------", text_row++, text_col, 0x2F);
-    print_string_with_attr("Press any key to continue...", text_row, text_col, 0x2F);
-
-while (1) {
-    unsigned char status, scancode;
-    asm volatile("inb $0x64, %0" : "=a"(status));
-if (status & 0x01) {
-    asm volatile("inb $0x60, %0" : "=a"(scancode));
-if (!(scancode & 0x80)) {
-    clear_screen();
-break;
-}
-}
-}
-}
-
-// Kernel Main Function
-void kmain() {
-clear_screen();
-//print_string("Starting Sebria OS...", 1, 0);
-
-// Initialize subsystems
-init_paging();
-
-init_vfs(); // Ensure VFS is initialized
-
-setup_idt();
-init_keyboard();
-asm volatile("sti");
-
-// Initialize processes
-for (int i = 0; i < MAX_PROCESSES; i++) {
-processes[i].pid = 0;
-processes[i].state = 2;
-}
-
-// Create sample processes
-create_process(task1, 5, 0);
-create_process(task2, 3, 0);
-create_process(user_task, 2, 3);
-processes[0].state = 1; // Set first process as running
-
-
-
-// Run startup animation
-startup_animation();
-
-// Display instructions
-display_instructions();
-
-
-// Main kernel loop
-while (1) {
-if (schedule_flag) {
-schedule_flag = 0;
-schedule();
-}
-for (volatile int i = 0; i < 1000; i++);
-}
+// Kernel: shell, UI, interrupt handlers and kmain
+#include "hal.h"
+#include "klib.h"
+#include "console.h"
+#include "serial.h"
+#include "paging.h"
+#include "vfs.h"
+#include "sched.h"
+#include "syscall.h"
+#include "bench.h"
+#include "multiboot.h"
+#include "gdt.h"
+#include "pmm.h"
+#include "proc.h"
+#include "pipe.h"
+#include "shm.h"
+#include "lock.h"
+#include "procfs.h"
+#include "ramdisk.h"
+#include "cpu.h"
+#include "crc32c.h"
+#include "shell.h"
+
+#define FILE_WRITE_MAX 4096
+
+// Diary Global Variables
+static char diary_buffer[256];
+static int diary_index = 0;
+static volatile int diary_active = 0;
+
+// top Screen
+static volatile int top_active = 0;
+
+// File Write Buffer
+static char file_write_buffer[FILE_WRITE_MAX];
+static int file_write_index = 0;
+static volatile int file_write_active = 0;
+static int current_file_fd = -1;
+
+// Global Variables
+char keyboard_buffer[256];         // Buffer for keyboard input
+int buffer_index = 0;             // Current index in keyboard buffer
+char shell_buffer[256];           // Buffer for shell commands
+int shell_index = 0;              // Current index in shell buffer
+volatile int menu_active = 0;     // Menu state: 0 (off), 1 (on)
+volatile int shell_active = 0;    // Shell state: 0 (off), 1 (on)
+
+// Function Prototypes
+void DiaryNote(void);
+void FileWrite(const char* filename);
+void display_shell_prompt(void);
+void display_top(void);
+
+void redraw_write_buffer(int text_row_start, int text_col, int rect_width, int rect_height) {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    const int visible_rows = rect_height - 6;
+    const int visible_cols = rect_width - 4;
+
+    int start_pos = file_write_index - (visible_rows * visible_cols);
+    if (start_pos < 0) start_pos = 0;
+
+    for (int i = 0; i < visible_rows * visible_cols; i++) {
+        int buffer_pos = start_pos + i;
+        int r = i / visible_cols;
+        int c = i % visible_cols;
+        char ch = (buffer_pos < file_write_index) ? file_write_buffer[buffer_pos] : ' ';
+        vga[(text_row_start + r) * VGA_WIDTH + text_col + c] = 0x2F00 | ch;
+    }
+}
+
+// File Write Interface
+void FileWrite(const char* filename) {
+    if (!vfs_initialized) {
+        clear_screen();
+        print_string("VFS not initialized. File operations disabled.", 12, 10);
+        for (volatile int i = 0; i < 1000000; i++);
+        clear_screen();
+        display_shell_prompt();
+        shell_active = 1;
+        return;
+    }
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    const int rect_width = 60;
+    const int rect_height = 15;
+    const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
+    const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
+    const int rect_end_row = rect_start_row + rect_height - 1;
+    const int rect_end_col = rect_start_col + rect_width - 1;
+
+    clear_screen();
+
+    for (int row = rect_start_row; row <= rect_end_row; row++) {
+        memsetw(&vga[row * VGA_WIDTH + rect_start_col], 0x2F00 | ' ', rect_width);
+    }
+
+    memsetw(&vga[rect_start_row * VGA_WIDTH + rect_start_col], 0x2F00 | '-', rect_width);
+    memsetw(&vga[rect_end_row * VGA_WIDTH + rect_start_col], 0x2F00 | '-', rect_width);
+    for (int row = rect_start_row + 1; row < rect_end_row; row++) {
+        vga[row * VGA_WIDTH + rect_start_col] = 0x2F00 | '|';
+        vga[row * VGA_WIDTH + rect_end_col] = 0x2F00 | '|';
+    }
+    vga[rect_start_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
+    vga[rect_start_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
+    vga[rect_end_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
+    vga[rect_end_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
+
+    int text_row = rect_start_row + 1;
+    int text_col = rect_start_col + 2;
+    print_string_with_attr("Write to File", text_row++, text_col, 0x2F);
+    print_string_with_attr("File: ", text_row, text_col, 0x2F);
+    print_string_with_attr(filename, text_row++, text_col + 6, 0x2F);
+    print_string_with_attr("Press Enter to save, Esc to cancel.", text_row++, text_col, 0x2F);
+    print_string_with_attr("----------------------", text_row++, text_col, 0x2F);
+    //print_string_with_attr("Enter text:", text_row++, text_col, 0x2F);
+
+    memset(file_write_buffer, 0, sizeof(file_write_buffer));
+    file_write_index = 0;
+    file_write_active = 1;
+}
+
+// Shell Display Functions
+void clear_shell_input() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    memsetw(&vga[23 * VGA_WIDTH], 0x0700, VGA_WIDTH);
+    shell_index = 0;
+    memset(shell_buffer, 0, sizeof(shell_buffer));
+}
+
+void clear_shell_output() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    memsetw(&vga[15 * VGA_WIDTH], 0x0700, VGA_WIDTH);
+    memsetw(&vga[22 * VGA_WIDTH], 0x0700, VGA_WIDTH);
+}
+
+void clear_shell_command_prompt() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    memsetw(&vga[20 * VGA_WIDTH], 0x0700, VGA_WIDTH);
+}
+
+void clear_shell() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    memsetw(&vga[15 * VGA_WIDTH], 0x0700, 9 * VGA_WIDTH); // Rows 15-23
+    shell_index = 0;
+    memset(shell_buffer, 0, sizeof(shell_buffer));
+}
+
+void display_shell_prompt() {
+    clear_shell_input();
+    print_string_with_attr("SHELL>> ", 23, 0, 0x2F);
+}
+
+// The prompt and the line typed so far
+void draw_shell_input() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    memsetw(&vga[23 * VGA_WIDTH + 8], 0x0700, VGA_WIDTH - 8);
+    print_string_with_attr("SHELL>> ", 23, 0, 0x2F);
+    for (int i = 0; i < shell_index; i++) {
+        vga[23 * VGA_WIDTH + 8 + i] = 0x2F00 | shell_buffer[i];
+    }
+}
+
+// Up and Down step through the history into the input line; stepping down
+// past the newest line leaves it empty
+static int history_pos = -1;      // Line recalled (0: the newest), -1 for a new line
+
+void history_recall(int step) {
+    int pos = history_pos + step;
+    if (pos < -1 || pos >= shell_history_count()) return;
+    history_pos = pos;
+    const char* line = pos >= 0 ? shell_history(pos) : "";
+    shell_index = 0;
+    while (line[shell_index] && shell_index < VGA_WIDTH - 9) {
+        shell_buffer[shell_index] = line[shell_index];
+        shell_index++;
+    }
+    shell_buffer[shell_index] = 0;
+    draw_shell_input();
+}
+
+// Menu Functions
+void display_menu() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    memsetw(&vga[(VGA_HEIGHT - 2) * VGA_WIDTH], 0x0700, VGA_WIDTH * 2);
+    print_string("Menu: ", 24, 0);
+    print_string_with_attr("1", 24, 6, 0x0F);
+    print_string(".Show/Hide ", 24, 7);
+    print_string_with_attr("2", 24, 18, 0x0F);
+    print_string(".Exit ", 24, 19);
+    print_string_with_attr("3", 24, 25, 0x0F);
+    print_string(".Crash (BSOD) ", 24, 26);
+    print_string_with_attr("S", 24, 40, 0x0F);
+    print_string(".Shell ", 24, 41);
+    print_string_with_attr("V", 24, 48, 0x0F);
+    print_string(".Virtual Memory ", 24, 49);
+}
+
+void hide_menu() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    memsetw(&vga[(VGA_HEIGHT - 2) * VGA_WIDTH], 0x0700, VGA_WIDTH * 2);
+}
+
+// System Control Functions
+void halt_system() {
+    clear_screen();
+    print_string("System halted.", 12, 33);
+    asm volatile("hlt");
+    while (1);
+}
+
+void display_bsod() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    memsetw(vga, 0x2F00, VGA_WIDTH * VGA_HEIGHT);
+    print_string_with_attr("*** A fatal error has occurred ***", 5, 24, 0x2F);
+    print_string_with_attr("Sebria OS has encountered a critical error and must halt.", 7, 12, 0x2F);
+    print_string_with_attr("Error Code: 0xDEADBEEF", 9, 29, 0x2F);
+    asm volatile("hlt");
+    while (1);
+}
+
+// Screen Dump Function
+void dump_screen() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    char screen_buffer[VGA_HEIGHT * (VGA_WIDTH + 1)];
+    int buffer_pos = 0;
+
+    for (int row = 0; row < VGA_HEIGHT; row++) {
+        for (int col = 0; col < VGA_WIDTH; col++) {
+            char c = (char)(vga[row * VGA_WIDTH + col] & 0xFF);
+            if (c == 0) c = ' ';
+            if (buffer_pos < VGA_HEIGHT * (VGA_WIDTH + 1) - 1) {
+                screen_buffer[buffer_pos++] = c;
+            }
+        }
+        if (buffer_pos < VGA_HEIGHT * (VGA_WIDTH + 1) - 1) {
+            screen_buffer[buffer_pos++] = '\n';
+        }
+    }
+    screen_buffer[buffer_pos ? buffer_pos - 1 : 0] = 0;
+
+    clear_shell_output();
+    print_string("Dumping screen contents...", 18, 0);
+    for (volatile int i = 0; i < 100000; i++);
+
+    const int rect_width = 60;
+    const int rect_height = 15;
+    const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
+    const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
+    const int rect_end_row = rect_start_row + rect_height - 1;
+    const int rect_end_col = rect_start_col + rect_width - 1;
+
+    clear_screen();
+
+    memsetw(&vga[rect_start_row * VGA_WIDTH + rect_start_col], 0x2F00 | '-', rect_width);
+    memsetw(&vga[rect_end_row * VGA_WIDTH + rect_start_col], 0x2F00 | '-', rect_width);
+    for (int row = rect_start_row + 1; row < rect_end_row; row++) {
+        vga[row * VGA_WIDTH + rect_start_col] = 0x2F00 | '|';
+        vga[row * VGA_WIDTH + rect_end_col] = 0x2F00 | '|';
+    }
+    vga[rect_start_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
+    vga[rect_start_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
+    vga[rect_end_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
+    vga[rect_end_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
+
+    int display_row = rect_start_row + 1;
+    int display_col = rect_start_col + 1;
+    int scrollAddr = 0;
+
+    for (int row = scrollAddr; row < scrollAddr + (rect_height - 2) && row < VGA_HEIGHT; row++) {
+        for (int col = 0; col < rect_width - 2 && col < VGA_WIDTH; col++) {
+            int buf_index = row * (VGA_WIDTH + 1) + col;
+            char c = (buf_index < buffer_pos) ? screen_buffer[buf_index] : ' ';
+            if (c == '\n' || c == 0) c = ' ';
+            vga[display_row * VGA_WIDTH + display_col + col] = 0x2F00 | c;
+        }
+        display_row++;
+    }
+
+    print_string_with_attr("Press S to return to shell, Q to exit.", 21, 10, 0x2F);
+
+    while (1) {
+        unsigned char status, scancode;
+        asm volatile("inb $0x64, %0" : "=a"(status));
+        if (status & 0x01) {
+            asm volatile("inb $0x60, %0" : "=a"(scancode));
+            if (!(scancode & 0x80)) {
+                if (scancode == 0x1F) {
+                    shell_index = 0;
+                    memset(shell_buffer, 0, sizeof(shell_buffer));
+                    clear_screen();
+                    clear_shell();
+                    display_shell_prompt();
+                    shell_active = 1;
+                    return;
+                }
+                if (scancode == 0x10) {
+                    halt_system();
+                    return;
+                }
+            }
+        }
+        for (volatile int i = 0; i < 10000; i++);
+    }
+}
+
+// Diary Note Function
+void DiaryNote() {
+    if (!vfs_initialized) {
+        clear_screen();
+        print_string("VFS not initialized. Diary feature disabled.", 12, 10);
+        for (volatile int i = 0; i < 1000000; i++);
+        clear_screen();
+        display_shell_prompt();
+        shell_active = 1;
+        return;
+    }
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    const int rect_width = 60;
+    const int rect_height = 15;
+    const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
+    const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
+    const int rect_end_row = rect_start_row + rect_height - 1;
+    const int rect_end_col = rect_start_col + rect_width - 1;
+
+    clear_screen();
+
+    for (int row = rect_start_row; row <= rect_end_row; row++) {
+        memsetw(&vga[row * VGA_WIDTH + rect_start_col], 0x2F00 | ' ', rect_width);
+    }
+
+    memsetw(&vga[rect_start_row * VGA_WIDTH + rect_start_col], 0x2F00 | '-', rect_width);
+    memsetw(&vga[rect_end_row * VGA_WIDTH + rect_start_col], 0x2F00 | '-', rect_width);
+    for (int row = rect_start_row + 1; row < rect_end_row; row++) {
+        vga[row * VGA_WIDTH + rect_start_col] = 0x2F00 | '|';
+        vga[row * VGA_WIDTH + rect_end_col] = 0x2F00 | '|';
+    }
+    vga[rect_start_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
+    vga[rect_start_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
+    vga[rect_end_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
+    vga[rect_end_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
+
+    int text_row = rect_start_row + 1;
+    int text_col = rect_start_col + 2;
+    print_string_with_attr("Diary Note", text_row++, text_col, 0x2F);
+    print_string_with_attr("Press Enter to save, Esc to cancel.", text_row++, text_col, 0x2F);
+    print_string_with_attr("----------------------", text_row++, text_col, 0x2F);
+    print_string_with_attr("Tell me about your day?", text_row++, text_col, 0x2F);
+
+    memset(diary_buffer, 0, sizeof(diary_buffer));
+    diary_index = 0;
+    diary_active = 1;
+}
+
+// Virtual Memory Information Display
+void display_vm_info() {
+    clear_screen();
+    print_string_with_attr("Sebria OS Virtual Memory Management", 2, 20, 0x0F);
+    print_string("Virtual Memory Status:", 4, 5);
+    print_string("Paging: Enabled, free frames:", 6, 5);
+    print_number(frames_free, 6, 35);
+    print_string("Usable RAM (KiB): ", 7, 5);
+    print_number(mem_total_kb, 7, 23);
+    print_string("Memory regions: ", 8, 5);
+    print_number(mem_region_count, 8, 23);
+    print_string("Virtual File System (VFS):", 10, 5);
+    print_string("Device: ", 11, 5);
+    print_string(vfs.device, 11, 21);
+    print_string(vfs.fs_type, 11, 38);
+    print_string(vfs_initialized ? "Status: Initialized" : "Status: Not initialized", 12, 5);
+    print_string("Files: ", 13, 5);
+    print_number(vfs.files, 13, 21);
+    print_string("Inodes Used: ", 14, 5);
+    print_number(vfs.inodes_used, 14, 21);
+    print_string("User-Space Processes:", 16, 5);
+    print_string("PID   Name      State     Priority", 18, 5);
+    int row = 19;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processes[i].pid) {
+            char buf[64];
+            int pos = 0;
+            print_number(processes[i].pid, row, 5);
+            buf[pos++] = ' ';
+            buf[pos++] = ' ';
+            buf[pos++] = ' ';
+            buf[pos++] = ' ';
+            const char* name = processes[i].privilege == 0 ? "kernel" : "user";
+            for (int j = 0; name[j]; j++) {
+                buf[pos++] = name[j];
+            }
+            while (pos < 16) buf[pos++] = ' ';
+            const char* state = process_state_name(processes[i].state);
+            for (int j = 0; state[j]; j++) {
+                buf[pos++] = state[j];
+            }
+            while (pos < 24) buf[pos++] = ' ';
+            print_number(processes[i].priority, row, 24);
+            buf[pos] = 0;
+            print_string(buf, row++, 8);
+        }
+    }
+    print_string("Press any key to return to menu...", 22, 20);
+
+    unsigned char status, scancode;
+    while (1) {
+        asm volatile("inb $0x64, %0" : "=a"(status));
+        if (status & 0x01) {
+            asm volatile("inb $0x60, %0" : "=a"(scancode));
+            if (!(scancode & 0x80)) {
+                asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+                break;
+            }
+        }
+    }
+    clear_screen();
+}
+
+// System Call Handler
+// Arguments come from the registers saved in the stub's TrapFrame; the
+// result is stored back into the saved eax so popa returns it to the caller.
+// Pointers from ring 3 must lie in the caller's user pages.
+static int user_ok(TrapFrame* frame, unsigned int addr, unsigned int len, int write) {
+    if ((frame->cs & 3) != 3) return 1;
+    return paging_user_range(processes[current_process].page_dir, addr, len, write);
+}
+
+static int user_string_ok(TrapFrame* frame, unsigned int addr) {
+    if ((frame->cs & 3) != 3) return 1;
+    return paging_user_string(processes[current_process].page_dir, addr);
+}
+
+// Tasks name files by per-process descriptor; kmain's idle context (boot
+// code, benchmarks) uses VFS fds directly
+static int fd_lookup(unsigned int fd) {
+    if (current_process == IDLE_PROCESS) return (int)fd;
+    return fd < MAX_PROC_FDS ? proc_files(current_process)[fd] : -1;
+}
+
+static int fd_new(int file) {
+    return current_process == IDLE_PROCESS ? file : fd_install(current_process, file);
+}
+
+static int fd_close(unsigned int fd) {
+    int file = fd_lookup(fd);
+    if (file < 0) return -1;
+    if (current_process != IDLE_PROCESS) proc_files(current_process)[fd] = -1;
+    vfs_close_file(file);
+    return 0;
+}
+
+// A pipe read or write that would block parks the caller on the pipe and
+// runs the int 0x80 again once it is woken; the idle context cannot sleep
+static int pipe_block(TrapFrame* frame, int file, unsigned int syscall_num) {
+    if (current_process == IDLE_PROCESS) return PIPE_AGAIN;
+    sleep_on(current_process, vfs_wait_channel(file));
+    frame->eip -= 2;
+    return syscall_num;
+}
+
+// Futexes are keyed by physical address, so processes mapping the same
+// shared memory page at any address meet on one key. Kernel callers run on
+// the identity map. Returns 0 for a bad or unaligned user pointer.
+static unsigned int futex_key(TrapFrame* frame, unsigned int addr) {
+    if (addr & 3) return 0;
+    if ((frame->cs & 3) != 3) return addr;
+    if (!user_ok(frame, addr, sizeof(int), 0)) return 0;
+    return (paging_lookup(processes[current_process].page_dir, addr) & ~0xFFF) | (addr & 0xFFF);
+}
+
+void syscall_handler(TrapFrame* frame) {
+    irq_counts[0x80]++;
+    Registers* regs = &frame->regs;
+    unsigned int syscall_num = regs->eax;
+    unsigned int arg1 = regs->ebx;
+    unsigned int arg2 = regs->ecx;
+    unsigned int arg3 = regs->edx;
+    int result = 0;
+    switch (syscall_num) {
+        case SYS_WRITE:
+            if (!user_string_ok(frame, arg1)) { result = -1; break; }
+            print_string((const char*)arg1, 15, 0);
+            break;
+        case SYS_OPEN:
+            if (!user_string_ok(frame, arg1)) { result = -1; break; }
+            result = fd_new(vfs_open_file((const char*)arg1));
+            break;
+        case SYS_READ: {
+            int file = fd_lookup(arg1);
+            if (!user_ok(frame, arg2, arg3, 1)) { result = -1; break; }
+            result = vfs_read_file(file, (char*)arg2, arg3);
+            if (result == PIPE_AGAIN) result = pipe_block(frame, file, syscall_num);
+            break;
+        }
+        case SYS_FWRITE: {
+            // Short writes are returned as such; only a full pipe blocks
+            int file = fd_lookup(arg1);
+            if (!user_ok(frame, arg2, arg3, 0)) { result = -1; break; }
+            result = vfs_write_file(file, (const char*)arg2, arg3);
+            if (result == PIPE_AGAIN) result = pipe_block(frame, file, syscall_num);
+            break;
+        }
+        case SYS_CLOSE:
+            result = fd_close(arg1);
+            break;
+        case SYS_PIPE: {
+            // arg1: int[2] receiving the read and write descriptors
+            int r, w;
+            if (!user_ok(frame, arg1, 2 * sizeof(int), 1) || vfs_pipe(&r, &w) < 0) { result = -1; break; }
+            r = fd_new(r);
+            w = fd_new(w);
+            if (r < 0 || w < 0) { // fd_install already closed the end that did not fit
+                if (r >= 0) fd_close(r);
+                if (w >= 0) fd_close(w);
+                result = -1;
+                break;
+            }
+            ((int*)arg1)[0] = r;
+            ((int*)arg1)[1] = w;
+            break;
+        }
+        case SYS_CREATE:
+            if (!user_string_ok(frame, arg1)) { result = -1; break; }
+            result = vfs_create_file((const char*)arg1);
+            break;
+        case SYS_GETDENTS:
+            // arg1: directory fd, arg2: buffer, arg3: its size in bytes. Whole
+            // Dirent records only; returns the bytes filled, 0 at the end.
+            if (!user_ok(frame, arg2, arg3, 1)) { result = -1; break; }
+            result = vfs_getdents(fd_lookup(arg1), (Dirent*)arg2, arg3 / sizeof(Dirent));
+            if (result > 0) result *= sizeof(Dirent);
+            break;
+        case SYS_STAT:
+            if (!user_string_ok(frame, arg1) || !user_ok(frame, arg2, sizeof(Stat), 1)) { result = -1; break; }
+            result = vfs_stat((const char*)arg1, (Stat*)arg2);
+            break;
+        case SYS_FSTAT:
+            if (!user_ok(frame, arg2, sizeof(Stat), 1)) { result = -1; break; }
+            result = vfs_fstat(fd_lookup(arg1), (Stat*)arg2);
+            break;
+        case SYS_PS:
+            result = 0;
+            for (int i = 0; i < MAX_PROCESSES; i++) {
+                if (processes[i].pid) result++;
+            }
+            break;
+        case SYS_KILL:
+            kill_process(arg1);
+            break;
+        case SYS_EXIT:
+            if (current_process != IDLE_PROCESS) exit_group(current_process, (int)arg1);
+            break;
+        case SYS_THREAD_CREATE:
+            // arg1: entry, arg2: top of the thread's stack, arg3: argument for the entry
+            result = proc_thread_create(frame, arg1, arg2, arg3);
+            break;
+        case SYS_SCHED_SET:
+            // arg1: policy, for the calling thread; SCHED_EDF: arg2 runtime,
+            // arg3 period (= deadline), in timer ticks
+            if (current_process == IDLE_PROCESS) break;
+            if (arg1 == SCHED_EDF) {
+                result = sched_setedf(current_process, arg2, arg3, arg3);
+            } else {
+                result = sched_setpolicy(current_process, (int)arg1);
+            }
+            break;
+        case SYS_SCHED_YIELD:
+            // An EDF job ends and sleeps until the next release; others yield
+            if (current_process != IDLE_PROCESS && processes[current_process].policy == SCHED_EDF) {
+                sleep_on(current_process, edf_job_done(current_process));
+            }
+            schedule_flag = 1;
+            result = 0;
+            break;
+        case SYS_THREAD_EXIT:
+            // The leader thread leaving takes the process with it
+            if (current_process == IDLE_PROCESS) break;
+            if (processes[current_process].group == processes[current_process].pid) {
+                exit_group(current_process, (int)arg1);
+            } else {
+                exit_process(current_process, (int)arg1);
+            }
+            break;
+        case SYS_FORK:
+            result = proc_fork(frame);
+            break;
+        case SYS_EXEC: {
+            // arg1: name of a GRUB module holding an ELF32 executable
+            unsigned int size;
+            const void* image = user_string_ok(frame, arg1) ? multiboot_find_module((const char*)arg1, &size) : 0;
+            result = image ? proc_exec(frame, image, size) : -1;
+            break;
+        }
+        case SYS_WAIT: {
+            // arg1: child pid or -1 for any, arg2: optional int* for its exit code
+            int code;
+            if (current_process == IDLE_PROCESS || (arg2 && !user_ok(frame, arg2, sizeof(int), 1))) {
+                result = -1;
+                break;
+            }
+            result = reap_child(current_process, (int)arg1, &code);
+            if (result > 0 && arg2) {
+                *(int*)arg2 = code;
+            } else if (result == 0) {
+                // Block until a child exits, then run the int 0x80 again
+                sleep_on(current_process, &processes[current_process]);
+                frame->eip -= 2;
+                result = syscall_num;
+            }
+            break;
+        }
+        case SYS_SHM_CREATE:
+            // arg1: key, arg2: size in bytes
+            result = shm_create(arg1, arg2);
+            break;
+        case SYS_SHM_MAP:
+            // arg1: region id; returns the address it is mapped at
+            if ((frame->cs & 3) != 3) { result = -1; break; }
+            result = shm_map(processes[current_process].page_dir, (int)arg1);
+            if (result == 0) result = -1;
+            break;
+        case SYS_FUTEX: {
+            // arg1: int* shared counter, arg2: FUTEX_WAIT or FUTEX_WAKE, arg3: value
+            unsigned int key = futex_key(frame, arg1);
+            if (!key) {
+                result = -1;
+            } else if (arg2 == FUTEX_WAKE) {
+                result = wake_up_nr((const void*)key, (int)arg3);
+            } else if (arg2 == FUTEX_WAIT && current_process != IDLE_PROCESS && *(volatile int*)arg1 == (int)arg3) {
+                // Checked and parked with interrupts off: a wake cannot slip
+                // in between. The caller resumes after the int 0x80 with 0.
+                sleep_on(current_process, (const void*)key);
+            } else {
+                result = -1; // Value already changed: no need to sleep
+            }
+            break;
+        }
+        default:
+            print_string("Unknown syscall", 15, 0);
+    }
+    regs->eax = result;
+    asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+}
+
+// Interrupt Handlers
+void default_handler() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    vga[2] = 0x4F44; // 'D'
+    while (1);
+}
+
+void double_fault_handler() {
+    irq_counts[0x08]++;
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    vga[4] = 0x4F46; // 'F'
+    while (1);
+}
+
+// CPU exceptions: writes to copy-on-write pages get their private copy and
+// a first FPU use after a switch gets the task's FPU state; otherwise a
+// faulting ring 3 task is killed and the stub switches away from it, and a
+// fault in kernel code is fatal
+void fault_handler(int vector, TrapFrame* frame) {
+    irq_counts[vector]++;
+    if (vector == 0x07 && fpu_trap()) return;
+    if (vector == 0x0E && (frame->err & 3) == 3 && current_process != IDLE_PROCESS) {
+        unsigned int addr;
+        asm volatile("mov %%cr2, %0" : "=r"(addr));
+        if (paging_cow_fault(processes[current_process].page_dir, addr) == 0) return;
+    }
+    if ((frame->cs & 3) == 3 && current_process != IDLE_PROCESS) {
+        print_string("User fault: vector    pid    killed", 15, 0);
+        print_number(vector, 15, 19);
+        print_number(processes[current_process].pid, 15, 26);
+        kill_process(processes[current_process].pid);
+        return;
+    }
+    display_bsod();
+}
+
+#define TOP_REFRESH_TICKS TIMER_HZ // Once a second
+#define SYNC_TICKS (TIMER_HZ / 20)  // Group commit window: 50 ms
+
+// VFS changes buffer in the journal; this task writes out whatever built up
+// over the last window as one transaction
+static char sync_chan;
+
+static void sync_task() {
+    while (1) {
+        unsigned int eflags = irq_save();
+        if (!vfs_dirty()) proc_sleep(&sync_chan);
+        irq_restore(eflags);
+        vfs_sync();
+    }
+}
+
+// Shell history persistence
+// The keyboard interrupt only adds lines to the ring (shell.c). This task
+// writes the ring to HISTORY_FILE once a second while it changes, so the
+// input path never waits on the VFS or the journal behind it.
+#define HISTORY_FILE "/.history"
+#define HISTORY_TICKS TIMER_HZ
+
+static char history_chan;
+static unsigned int history_saved; // shell_history_total() when last written
+
+static void history_task() {
+    static char buf[SHELL_HISTORY * SHELL_LINE_MAX];
+    int retry = 0;
+    while (1) {
+        unsigned int eflags = irq_save();
+        if (retry || shell_history_total() == history_saved) proc_sleep(&history_chan);
+        history_saved = shell_history_total();
+        int len = shell_history_save(buf, sizeof(buf)); // With the ring still
+        irq_restore(eflags);
+        // Overwrite in place, then cut off what is left of the old lines: a
+        // crash between the two keeps every line, never an empty file
+        if (vfs_lookup(HISTORY_FILE) < 0) vfs_create_file(HISTORY_FILE);
+        int fd = vfs_open_file(HISTORY_FILE);
+        int ok = fd >= 0 && vfs_write_file(fd, buf, len) == len;
+        if (fd >= 0) vfs_close_file(fd);
+        // Truncation fails while another descriptor has the file open (a
+        // cat): leave the ring dirty so the timer's next flush tries again
+        retry = !ok || vfs_truncate(HISTORY_FILE, len) < 0;
+        if (retry) history_saved--;
+    }
+}
+
+// Put the lines saved in HISTORY_FILE (after a mount) before this session's
+static void history_load() {
+    static char buf[SHELL_HISTORY * SHELL_LINE_MAX];
+    int fd = vfs_open_file(HISTORY_FILE);
+    if (fd < 0) return;
+    int len = vfs_read_file(fd, buf, sizeof(buf));
+    vfs_close_file(fd);
+    unsigned int eflags = irq_save();
+    shell_history_load(buf, len > 0 ? len : 0);
+    irq_restore(eflags);
+}
+
+void timer_handler() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    vga[6] = 0x4F54; // 'T'
+    irq_counts[0x20]++;
+    sched_tick();
+    if (top_active && sched_ticks % TOP_REFRESH_TICKS == 0) display_top();
+    if (sched_ticks % SYNC_TICKS == 0 && vfs_dirty()) wake_up(&sync_chan);
+    if (sched_ticks % HISTORY_TICKS == 0 && shell_history_total() != history_saved) wake_up(&history_chan);
+    schedule_flag = 1;
+    asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+}
+
+// Shell Pipelines
+// "cmd | cmd | ..." runs each stage as a kernel task, the stages connected by
+// pipes. A stage's ends sit in its descriptor table (0: input, 1: output), so
+// when it returns or is killed they are closed and its neighbours see end of
+// file or a broken pipe. The last stage prints to the shell output rows.
+#define MAX_STAGES 4
+#define STAGE_CMD_MAX 64
+#define STAGE_PRIORITY 7   // Ahead of the sample tasks, so pipelines finish promptly
+
+static char stage_cmds[MAX_PROCESSES][STAGE_CMD_MAX]; // Command of each stage, by slot
+static int stage_row = 15, stage_col = 0;             // Where the last stage prints
+static Mutex stage_output = MUTEX_INIT;               // Held by the last stage printing them
+
+static void stage_print(const char* buf, int len) {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    for (int i = 0; i < len && stage_row < 20; i++) {
+        char c = buf[i];
+        if (c == '\n' || stage_col >= VGA_WIDTH) {
+            stage_row++;
+            stage_col = 0;
+            if (c == '\n' || stage_row >= 20) continue;
+        }
+        if (c < 32 || c > 126) c = ' ';
+        vga[stage_row * VGA_WIDTH + stage_col++] = 0x0700 | c;
+    }
+}
+
+// Read from the stage's input, sleeping while the pipe is empty. The first
+// stage has no input and reads end of file.
+static int stage_read(char* buf, int len) {
+    int file = processes[current_process].files[0];
+    if (file < 0) return 0;
+    while (1) {
+        unsigned int eflags = irq_save();
+        int n = vfs_read_file(file, buf, len);
+        if (n == PIPE_AGAIN) proc_sleep(vfs_wait_channel(file));
+        irq_restore(eflags);
+        if (n != PIPE_AGAIN) return n;
+    }
+}
+
+// Write all of buf to the stage's output, sleeping while the pipe is full.
+// Returns -1 once the reader is gone.
+static int stage_write(const char* buf, int len) {
+    int file = processes[current_process].files[1];
+    if (file < 0) {
+        stage_print(buf, len);
+        return len;
+    }
+    int done = 0;
+    while (done < len) {
+        unsigned int eflags = irq_save();
+        int n = vfs_write_file(file, buf + done, len - done);
+        if (n == PIPE_AGAIN) proc_sleep(vfs_wait_channel(file));
+        irq_restore(eflags);
+        if (n == -1) return -1;
+        if (n > 0) done += n;
+    }
+    return done;
+}
+
+static int append_str(char* buf, int pos, const char* s) {
+    while (*s) buf[pos++] = *s++;
+    return pos;
+}
+
+static int append_num(char* buf, int pos, int n) {
+    char digits[12];
+    int count = 0;
+    do {
+        digits[count++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+    while (count) buf[pos++] = digits[--count];
+    return pos;
+}
+
+static int contains(const char* s, int len, const char* word) {
+    for (int i = 0; i < len; i++) {
+        int j = 0;
+        while (word[j] && i + j < len && s[i + j] == word[j]) j++;
+        if (!word[j]) return 1;
+    }
+    return 0;
+}
+
+static int stage_known(const char* cmd) {
+    return strcmp(cmd, "ls") == 0 || strncmp(cmd, "ls ", 3) == 0 || strcmp(cmd, "ps") == 0 ||
+           strcmp(cmd, "wc") == 0 || strcmp(cmd, "cat") == 0 || strncmp(cmd, "cat ", 4) == 0 ||
+           strncmp(cmd, "echo ", 5) == 0 || strncmp(cmd, "grep ", 5) == 0;
+}
+
+// What a stage does: ls [DIR], ps, echo TEXT and cat FILE produce output; cat
+// copies its input, grep WORD keeps the lines holding WORD and wc counts
+// lines, words and bytes
+static void run_stage(const char* cmd) {
+    char buf[128];
+    int n;
+    if (strcmp(cmd, "ls") == 0 || strncmp(cmd, "ls ", 3) == 0) {
+        int fd = fd_install(current_process, vfs_opendir(cmd[2] ? cmd + 3 : "/")); // Closed on exit
+        if (fd < 0) return;
+        Dirent ent;
+        while (vfs_readdir(processes[current_process].files[fd], &ent) == 1) {
+            int pos = append_str(buf, 0, ent.name);
+            if (ent.type == VFS_DIR) buf[pos++] = '/';
+            buf[pos++] = '\n';
+            if (stage_write(buf, pos) < 0) break;
+        }
+    } else if (strcmp(cmd, "ps") == 0) {
+        for (int i = 0; i < MAX_PROCESSES; i++) {
+            if (!processes[i].pid) continue;
+            int pos = append_num(buf, 0, processes[i].pid);
+            buf[pos++] = ' ';
+            pos = append_str(buf, pos, process_kind(i));
+            buf[pos++] = ' ';
+            pos = append_str(buf, pos, process_state_name(processes[i].state));
+            buf[pos++] = '\n';
+            if (stage_write(buf, pos) < 0) break;
+        }
+    } else if (strncmp(cmd, "echo ", 5) == 0) {
+        int pos = append_str(buf, 0, cmd + 5);
+        buf[pos++] = '\n';
+        stage_write(buf, pos);
+    } else if (strncmp(cmd, "cat ", 4) == 0) {
+        int fd = fd_install(current_process, vfs_open_file(cmd + 4)); // Closed on exit
+        if (fd < 0) return;
+        int file = processes[current_process].files[fd];
+        while ((n = vfs_read_file(file, buf, sizeof(buf))) > 0 && stage_write(buf, n) >= 0);
+    } else if (strcmp(cmd, "cat") == 0) {
+        while ((n = stage_read(buf, sizeof(buf))) > 0 && stage_write(buf, n) >= 0);
+    } else if (strncmp(cmd, "grep ", 5) == 0) {
+        char line[STAGE_CMD_MAX * 2];
+        int len = 0;
+        while ((n = stage_read(buf, sizeof(buf))) > 0) {
+            for (int i = 0; i < n; i++) {
+                if (len < (int)sizeof(line)) line[len++] = buf[i]; // Longer lines are cut
+                if (buf[i] != '\n') continue;
+                if (contains(line, len, cmd + 5) && stage_write(line, len) < 0) return;
+                len = 0;
+            }
+        }
+        if (len && contains(line, len, cmd + 5)) stage_write(line, len);
+    } else if (strcmp(cmd, "wc") == 0) {
+        int lines = 0, words = 0, bytes = 0, in_word = 0;
+        while ((n = stage_read(buf, sizeof(buf))) > 0) {
+            for (int i = 0; i < n; i++) {
+                int space = buf[i] == ' ' || buf[i] == '\n';
+                if (buf[i] == '\n') lines++;
+                if (!space && !in_word) words++;
+                in_word = !space;
+            }
+            bytes += n;
+        }
+        int pos = append_num(buf, 0, lines);
+        buf[pos++] = ' ';
+        pos = append_num(buf, pos, words);
+        buf[pos++] = ' ';
+        pos = append_num(buf, pos, bytes);
+        buf[pos++] = '\n';
+        stage_write(buf, pos);
+    }
+}
+
+// Body of every stage task
+static void shell_stage() {
+    int last = processes[current_process].files[1] < 0;
+    if (last) {
+        // The output rows belong to one pipeline at a time. A last stage
+        // killed while holding them blocks later pipelines' output.
+        mutex_lock(&stage_output);
+        stage_row = 15;
+        stage_col = 0;
+    }
+    run_stage(stage_cmds[current_process]);
+    if (last) mutex_unlock(&stage_output);
+}
+
+// Split the line at '|' and start one stage task per command. Runs in the
+// keyboard interrupt, so nothing is scheduled until every stage is wired up.
+// Returns the number of stages, or -1 (nothing started) for an unknown
+// command or when tasks or pipes run out.
+static int run_pipeline(const char* line) {
+    char cmds[MAX_STAGES][STAGE_CMD_MAX];
+    int count = 0;
+    while (1) {
+        while (*line == ' ') line++;
+        if (count == MAX_STAGES) return -1;
+        int len = 0;
+        while (*line && *line != '|' && len < STAGE_CMD_MAX - 1) cmds[count][len++] = *line++;
+        while (len > 0 && cmds[count][len - 1] == ' ') len--;
+        cmds[count][len] = 0;
+        if (!stage_known(cmds[count++])) return -1;
+        if (*line != '|') break;
+        line++;
+    }
+    if (*line) return -1; // Command too long
+
+    int slots[MAX_STAGES];
+    int in = -1;
+    for (int i = 0; i < count; i++) {
+        int r = -1, w = -1;
+        int slot = -1;
+        if (i == count - 1 || vfs_pipe(&r, &w) == 0) {
+            slot = create_process(shell_stage, STAGE_PRIORITY, 0);
+        }
+        if (slot < 0) {
+            if (r >= 0) vfs_close_file(r);
+            if (w >= 0) vfs_close_file(w);
+            if (in >= 0) vfs_close_file(in);
+            while (i-- > 0) kill_process(processes[slots[i]].pid); // Closes their ends
+            return -1;
+        }
+        custom_strcpy(stage_cmds[slot], cmds[i]);
+        processes[slot].files[0] = in;
+        processes[slot].files[1] = w;
+        slots[i] = slot;
+        in = r;
+    }
+    return count;
+}
+
+// top
+// Per-task CPU accounting, one row per process, redrawn in place by the
+// timer until a key is pressed. PRI ends in 'f' for SCHED_FAIR tasks and
+// 'e' for SCHED_EDF. Cycle counts are in millions; READY is how long a
+// runnable task has been waiting now, WAIT its dispatch-delay histogram, one
+// digit per wait_bucket() scaled to its share ('.': none).
+#define TOP_FIRST_ROW 5
+
+static void top_row(char* line, int row) {
+    line[VGA_WIDTH] = 0;
+    print_string(line, row, 0);
+    memset(line, ' ', VGA_WIDTH);
+}
+
+static int mcycles(unsigned long long cycles) {
+    return (int)udiv64(cycles, 1000000, 0);
+}
+
+void display_top() {
+    char line[VGA_WIDTH + 1];
+    memset(line, ' ', VGA_WIDTH);
+    int tasks = 0;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processes[i].pid) tasks++;
+    }
+    append_str(line, append_num(line, 0, tasks), " tasks");
+    append_str(line, append_num(line, 12, sched_ticks), " ticks");
+    append_str(line, append_num(line, 28, idle_ticks), " idle");
+    append_str(line, append_num(line, 42, sched_switches), " switches");
+    top_row(line, 2);
+
+    append_str(line, 0, "PID KIND   STATE      PRI TICKS  SLICES VOL   INVOL  RUN    READY    WAIT");
+    top_row(line, TOP_FIRST_ROW - 1);
+
+    unsigned long long now = rdtsc();
+    int row = TOP_FIRST_ROW;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        Process* p = &processes[i];
+        if (!p->pid) continue;
+        append_num(line, 0, p->pid);
+        append_str(line, 4, process_kind(i));
+        append_str(line, 11, process_state_name(p->state));
+        append_str(line, append_num(line, 22, p->priority), p->policy == SCHED_FAIR ? "f" : p->policy == SCHED_EDF ? "e" : "");
+        append_num(line, 26, p->ticks);
+        append_num(line, 33, p->slices);
+        append_num(line, 40, p->voluntary);
+        append_num(line, 46, p->involuntary);
+        append_num(line, 53, mcycles(p->runtime));
+        append_num(line, 60, p->state == 0 ? mcycles(now - p->ready_since) : 0);
+        int samples = 0;
+        for (int b = 0; b < WAIT_BUCKETS; b++) samples += p->wait_hist[b];
+        for (int b = 0; b < WAIT_BUCKETS; b++) {
+            unsigned int n = p->wait_hist[b];
+            line[69 + b] = n ? '1' + n * 8 / samples : '.';
+        }
+        top_row(line, row++);
+    }
+    while (row < TOP_FIRST_ROW + MAX_PROCESSES) top_row(line, row++); // Rows of exited tasks
+}
+
+static void display_top_screen() {
+    clear_screen();
+    print_string_with_attr("Sebria OS top - any key returns to the shell", 0, 0, 0x0F);
+    top_active = 1;
+    display_top();
+}
+
+// Shell Commands
+// The keyboard interrupt only splits a line into argv and looks its name up
+// in the command table (shell.c). The command then runs as a task of its
+// own, printing to the output rows 15-19 and the "Command:" row when done,
+// while the prompt already takes the next line. SHELL_INLINE commands take
+// over the keyboard or the whole screen, and still run in the interrupt.
+#define SHELL_PRIORITY STAGE_PRIORITY
+
+static struct {
+    const ShellCommand* cmd;
+    char line[SHELL_LINE_MAX];
+} shell_jobs[MAX_PROCESSES]; // Command of each command task, by slot
+
+void show_command(const char* line) {
+    clear_shell_command_prompt();
+    print_string("Command: ", 20, 0);
+    print_string(line, 20, 9);
+}
+
+// Unsigned decimal argument, -1 if s is not one
+static int parse_num(const char* s) {
+    int n = 0;
+    if (!*s) return -1;
+    for (; *s; s++) {
+        if (*s < '0' || *s > '9') return -1;
+        n = n * 10 + (*s - '0');
+    }
+    return n;
+}
+
+static void report(int ok, const char* failure) {
+    print_string(ok ? "Done" : failure, 15, 0);
+}
+
+static void cmd_print(int argc, char** argv) {
+    print_string("Print command executed!", 15, 0);
+}
+
+static void cmd_halt(int argc, char** argv) {
+    halt_system();
+}
+
+static void cmd_dump(int argc, char** argv) {
+    dump_screen();
+}
+
+static void cmd_virtual(int argc, char** argv) {
+    display_vm_info();
+}
+
+static void cmd_ls(int argc, char** argv) {
+    int fd = vfs_initialized ? vfs_opendir(argc > 1 ? argv[1] : "/") : -1;
+    if (fd < 0) {
+        print_string("No such directory or VFS not initialized.", 15, 0);
+        return;
+    }
+    // Names flow over rows 15-19; what does not fit is counted
+    Dirent ent;
+    int row = 15, col = 0, more = 0;
+    while (vfs_readdir(fd, &ent) == 1) {
+        int len = 0;
+        while (ent.name[len]) len++;
+        if (col + len + 1 > VGA_WIDTH) {
+            row++;
+            col = 0;
+        }
+        if (row > 19) {
+            more++;
+            continue;
+        }
+        print_string(ent.name, row, col);
+        if (ent.type == VFS_DIR) print_string("/", row, col + len);
+        col += len + 2;
+    }
+    vfs_close_file(fd);
+    if (more) {
+        print_string("... more:", 19, VGA_WIDTH - 16);
+        print_number(more, 19, VGA_WIDTH - 6);
+    }
+}
+
+static void cmd_mkdir(int argc, char** argv) {
+    report(vfs_mkdir(argv[1]) >= 0, "Failed (missing parent or exists)");
+}
+
+static void cmd_rmdir(int argc, char** argv) {
+    report(vfs_rmdir(argv[1]) == 0, "Failed (missing, not empty, or open)");
+}
+
+// "compress <file>" stores it LZ4-compressed, "compress -d <file>" raw again
+static void cmd_compress(int argc, char** argv) {
+    int on = strcmp(argv[1], "-d") != 0;
+    if (!on && argc < 3) {
+        print_string("Usage: compress [-d] <file>", 15, 0);
+        return;
+    }
+    report(vfs_compress(argv[on ? 1 : 2], on) == 0, "Failed (not a file, or no blocks to switch)");
+}
+
+// Block devices, one per row: name, size in blocks, I/O counts. With a
+// name, mount that device as the VFS's store.
+static void cmd_mount(int argc, char** argv) {
+    if (argc > 1) {
+        BlockDevice* dev = block_find(argv[1]);
+        int ok = dev && vfs_mount(dev) == 0;
+        if (ok) history_load(); // The device's history, if it has one
+        report(ok, "Failed (no such device, one mounted, or device full)");
+        return;
+    }
+    int row = 15;
+    for (int i = 0; i < MAX_BLOCK_DEVICES && row < 20; i++) {
+        BlockDevice* dev = block_device(i);
+        if (!dev) continue;
+        print_string(dev->name, row, 0);
+        print_string("blocks", row, 10);
+        print_number(dev->blocks, row, 17);
+        print_string("r", row, 27);
+        print_number(dev->reads, row, 29);
+        print_string("w", row, 40);
+        print_number(dev->writes, row, 42);
+        if (strcmp(dev->name, vfs.device) == 0) print_string("mounted on /", row, 54);
+        row++;
+    }
+}
+
+static void cmd_umount(int argc, char** argv) {
+    report(vfs_unmount() == 0, "Failed (none mounted, or device full)");
+}
+
+static void cmd_sync(int argc, char** argv) {
+    report(vfs_sync() >= 0, "Failed (none mounted, or device full)");
+}
+
+static void cmd_ps(int argc, char** argv) {
+    char buf[64];
+    int shown = 0;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processes[i].pid) {
+            int row = 15 + shown % 5, col = shown / 5 * 20; // Rows 15-19, columns of 20
+            int pos = 0;
+            print_number(processes[i].pid, row, col);
+            const char* name = process_kind(i);
+            for (int j = 0; name[j]; j++) {
+                buf[pos++] = name[j];
+            }
+            while (pos < 7) buf[pos++] = ' ';
+            const char* state = process_state_name(processes[i].state);
+            for (int j = 0; state[j]; j++) {
+                buf[pos++] = state[j];
+            }
+            buf[pos] = 0;
+            print_string(buf, row, col + 3);
+            shown++;
+        }
+    }
+}
+
+static void cmd_bench(int argc, char** argv) {
+    int cases = run_benchmarks();
+    clear_screen();
+    print_string("Benchmarks done: ", 15, 0);
+    print_number(cases, 15, 17);
+    print_string("cases, results on COM1", 15, 21);
+    draw_shell_input(); // Typing went on meanwhile
+}
+
+static void cmd_clear(int argc, char** argv) {
+    clear_shell();
+    display_shell_prompt();
+}
+
+static void cmd_top(int argc, char** argv) {
+    display_top_screen();
+}
+
+static void cmd_diary(int argc, char** argv) {
+    DiaryNote();
+}
+
+static void cmd_touch(int argc, char** argv) {
+    const char* filename = argv[1];
+    if (!vfs_initialized) {
+        print_string("VFS not initialized. touch command disabled.", 15, 0);
+    } else if (vfs_create_file(filename) < 0) {
+        print_string("Failed to create file", 15, 0);
+    } else if ((current_file_fd = vfs_open_file(filename)) < 0) {
+        print_string("Failed to open file for writing", 15, 0);
+    } else {
+        print_string("File created: ", 15, 0);
+        print_string(filename, 15, 14);
+        FileWrite(filename);
+        return;
+    }
+    show_command(shell_buffer);
+    display_shell_prompt();
+}
+
+// Wait for a key press, polling the controller: runs in the keyboard
+// interrupt, so the key never reaches keyboard_handler
+static void wait_key() {
+    unsigned char status, scancode;
+    while (1) {
+        asm volatile("inb $0x64, %0" : "=a"(status));
+        if (status & 0x01) {
+            asm volatile("inb $0x60, %0" : "=a"(scancode));
+            if (!(scancode & 0x80)) break;
+        }
+    }
+}
+
+// Paginate a file over the whole screen
+static void cmd_cat(int argc, char** argv) {
+    if (!vfs_initialized) {
+        print_string("VFS not initialized. cat command disabled.", 1, 0);
+    } else {
+        int fd = vfs_open_file(argv[1]);
+        if (fd >= 0) {
+            clear_screen();
+            char buf[1024] = {0};
+            int bytes_read = vfs_read_file(fd, buf, sizeof(buf) - 1);
+
+            vfs_close_file(fd);
+
+            if (bytes_read <= 0) {
+                print_string("File is empty or read error.", 1, 0);
+            } else {
+                unsigned short* vga = (unsigned short*)VGA_BUFFER;
+                int row = 1, col = 0;
+                for (int i = 0; i < bytes_read; i++) {
+                    char c = buf[i];
+                    if (c == '\n') {
+                        col = VGA_WIDTH; // Line break (the /proc files are line based)
+                    } else {
+                        if (c < 32 || c > 126) c = ' ';
+                        vga[row * VGA_WIDTH + col] = 0x0700 | c;
+                        col++;
+                    }
+                    if (col >= VGA_WIDTH) {
+                        col = 0;
+                        row++;
+                        if (row > 21) {
+                            print_string("-- More -- Press Space to continue --", 22, 20);
+                            wait_key();
+                            clear_screen();
+                            row = 1;
+                            col = 0;
+                        }
+                    }
+                }
+                // If end of file doesn't end with full screen, just wait for key
+                print_string("-- End of File -- Press any key --", 22, 20);
+                wait_key();
+                clear_screen();
+            }
+        } else {
+            print_string("File not found.", 1, 0);
+        }
+    }
+    show_command(shell_buffer);
+    display_shell_prompt();
+}
+
+static void cmd_kill(int argc, char** argv) {
+    int pid = parse_num(argv[1]);
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (pid > 0 && processes[i].pid == pid) {
+            kill_process(pid);
+            print_string("Process killed: ", 15, 0);
+            print_number(pid, 15, 16);
+            return;
+        }
+    }
+    print_string("Process not found", 15, 0);
+}
+
+// sched <pid> fair|prio|edf <runtime> <period>
+static void cmd_sched(int argc, char** argv) {
+    int pid = parse_num(argv[1]);
+    int ok = pid >= 1 && pid <= MAX_PROCESSES && processes[pid - 1].pid == pid;
+    if (ok && strcmp(argv[2], "edf") == 0) {
+        int runtime = argc > 3 ? parse_num(argv[3]) : -1;
+        int period = argc > 4 ? parse_num(argv[4]) : -1;
+        ok = runtime >= 0 && period >= 0 && sched_setedf(pid - 1, runtime, period, period) == 0;
+    } else {
+        int policy = strcmp(argv[2], "fair") == 0 ? SCHED_FAIR : strcmp(argv[2], "prio") == 0 ? SCHED_PRIO : -1;
+        ok = ok && sched_setpolicy(pid - 1, policy) == 0;
+    }
+    if (ok) {
+        print_string("Policy set", 15, 0);
+    } else {
+        print_string("Usage: sched <pid> fair|prio|edf <runtime> <period> (admission may refuse)", 15, 0);
+    }
+}
+
+// The newest lines, numbered, over rows 15-19
+static void cmd_history(int argc, char** argv) {
+    int shown = shell_history_count() < 5 ? shell_history_count() : 5;
+    for (int i = 0; i < shown; i++) {
+        int back = shown - 1 - i;
+        print_number(shell_history_total() - back, 15 + i, 0);
+        print_string(shell_history(back), 15 + i, 6);
+    }
+}
+
+// Registered names, flowing over rows 15-19
+static void cmd_help(int argc, char** argv) {
+    const ShellCommand* cmd;
+    int col = 0, row = 15;
+    for (int i = 0; (cmd = shell_command(i)) && row < 20; i++) {
+        int len = 0;
+        while (cmd->name[len]) len++;
+        if (col + len > VGA_WIDTH) {
+            row++;
+            col = 0;
+        }
+        print_string(cmd->name, row, col);
+        col += len + 2;
+    }
+}
+
+static const ShellCommand shell_commands[] = {
+    { "help", cmd_help, 0, 0, 0 },
+    { "print", cmd_print, 0, 0, 0 },
+    { "ls", cmd_ls, 0, 0, 0 },
+    { "mkdir", cmd_mkdir, 1, 0, "Usage: mkdir <dir>" },
+    { "rmdir", cmd_rmdir, 1, 0, "Usage: rmdir <dir>" },
+    { "compress", cmd_compress, 1, 0, "Usage: compress [-d] <file>" },
+    { "mount", cmd_mount, 0, 0, 0 },
+    { "umount", cmd_umount, 0, 0, 0 },
+    { "sync", cmd_sync, 0, 0, 0 },
+    { "ps", cmd_ps, 0, 0, 0 },
+    { "history", cmd_history, 0, 0, 0 },
+    { "kill", cmd_kill, 1, 0, "Usage: kill <pid>" },
+    { "sched", cmd_sched, 2, 0, "Usage: sched <pid> fair|prio|edf <runtime> <period>" },
+    { "bench", cmd_bench, 0, 0, 0 },
+    { "touch", cmd_touch, 1, SHELL_INLINE, "Usage: touch <file>" },
+    { "cat", cmd_cat, 1, SHELL_INLINE, "Usage: cat <file>" },
+    { "diary", cmd_diary, 0, SHELL_INLINE, 0 },
+    { "top", cmd_top, 0, SHELL_INLINE, 0 },
+    { "dump", cmd_dump, 0, SHELL_INLINE, 0 },
+    { "virtual", cmd_virtual, 0, SHELL_INLINE, 0 },
+    { "clear", cmd_clear, 0, SHELL_INLINE, 0 },
+    { "halt", cmd_halt, 0, SHELL_INLINE, 0 },
+};
+
+void init_shell() {
+    shell_init();
+    for (unsigned int i = 0; i < sizeof(shell_commands) / sizeof(shell_commands[0]); i++) {
+        shell_register(&shell_commands[i]);
+    }
+}
+
+// Body of every command task
+static void shell_command_task() {
+    char args[SHELL_LINE_MAX];
+    char* argv[SHELL_ARGS];
+    custom_strcpy(args, shell_jobs[current_process].line);
+    int argc = shell_parse(args, argv, SHELL_ARGS);
+    mutex_lock(&stage_output); // The output rows, shared with pipelines
+    memsetw((unsigned short*)VGA_BUFFER + 15 * VGA_WIDTH, 0x0700, 5 * VGA_WIDTH);
+    shell_jobs[current_process].cmd->fn(argc, argv);
+    show_command(shell_jobs[current_process].line);
+    mutex_unlock(&stage_output);
+}
+
+// Run a line without '|': look the command up and start its task, or run
+// it here if it is SHELL_INLINE. Called from the keyboard interrupt, so the
+// task does not run before its job is filled in.
+static void shell_execute(const char* line) {
+    char args[SHELL_LINE_MAX];
+    char* argv[SHELL_ARGS];
+    custom_strcpy(args, line);
+    int argc = shell_parse(args, argv, SHELL_ARGS);
+    const ShellCommand* cmd = argc > 0 ? shell_find(argv[0]) : 0;
+    if (argc == 0) {
+        display_shell_prompt();
+        return;
+    }
+    if (!cmd || argc - 1 < cmd->min_args) {
+        print_string(argc < 0 ? "Too many arguments or unmatched quote." : cmd ? cmd->usage : "Unknown command.", 22, 0);
+        show_command(line);
+        display_shell_prompt();
+        return;
+    }
+    if (cmd->flags & SHELL_INLINE) {
+        cmd->fn(argc, argv);
+        return;
+    }
+    int slot = create_process(shell_command_task, SHELL_PRIORITY, 0);
+    if (slot < 0) {
+        print_string("No free task for the command.", 22, 0);
+        show_command(line);
+    } else {
+        shell_jobs[slot].cmd = cmd;
+        custom_strcpy(shell_jobs[slot].line, line);
+    }
+    display_shell_prompt();
+}
+
+void keyboard_handler() {
+    static const char scancode_to_ascii[] = {
+        0, 0, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', 0,
+        0, 'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p', '[', ']', '\n',
+        0, 'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', ';', '\'', '`', 0,
+        '\\', 'z', 'x', 'c', 'v', 'b', 'n', 'm', ',', '.', '/', 0, 0, 0,
+        ' ', 0
+    };
+    static const char scancode_to_ascii_shift[] = {
+        0, 0, '!', '@', '#', '$', '%', '^', '&', '*', '(', ')', '_', '+', 0,
+        0, 'Q', 'W', 'E', 'R', 'T', 'Y', 'U', 'I', 'O', 'P', '{', '}', '\n',
+        0, 'A', 'S', 'D', 'F', 'G', 'H', 'J', 'K', 'L', ':', '"', '~', 0,
+        '|', 'Z', 'X', 'C', 'V', 'B', 'N', 'M', '<', '>', '?', 0, 0, 0,
+        ' ', 0
+    };
+    static int shift_held = 0;
+    static int extended = 0;       // The previous byte was the 0xE0 prefix
+
+    unsigned char scancode;
+    irq_counts[0x21]++;
+    asm volatile("inb $0x60, %0" : "=a"(scancode));
+
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    vga[0] = 0x4F4B; // 'K'
+
+    if (scancode == 0xE0) { // Extended key: its code follows
+        extended = 1;
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+    int ext = extended;
+    extended = 0;
+
+    // Shift; extended ones are the fake shifts sent around arrow keys
+    if (scancode == 0x2A || scancode == 0x36 || scancode == 0xAA || scancode == 0xB6) {
+        if (!ext) shift_held = !(scancode & 0x80);
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+
+    if (scancode & 0x80) { // Key release
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+
+    print_hex_byte(scancode, 0, 2);
+
+    const char* keymap = shift_held ? scancode_to_ascii_shift : scancode_to_ascii;
+    char c = (scancode < sizeof(scancode_to_ascii) && keymap[scancode]) ? keymap[scancode] : 0;
+
+    if (top_active) { // Any key leaves top
+        top_active = 0;
+        clear_screen();
+        clear_shell();
+        display_shell_prompt();
+        shell_active = 1;
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+
+   if (file_write_active) {
+    const int rect_width = 60;
+    const int rect_height = 15;
+    const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
+    const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
+    const int text_row_start = rect_start_row + 5;
+    const int text_col = rect_start_col + 2;
+
+    if (scancode == 0x0E && file_write_index > 0) {  // Backspace
+        file_write_index--;
+        file_write_buffer[file_write_index] = 0;
+        redraw_write_buffer(text_row_start, text_col, rect_width, rect_height);
+    } else if (scancode == 0x1C) {  // Enter - Save
+        file_write_buffer[file_write_index] = 0;
+        if (file_write_index > 0 && current_file_fd >= 0) {
+            int bytes_written = vfs_write_file(current_file_fd, file_write_buffer, file_write_index);
+            print_string("Bytes written: ", 18, 0);
+            print_number(bytes_written, 18, 15);
+            vfs_close_file(current_file_fd);
+            current_file_fd = -1;
+        } else {
+            print_string("No data or invalid fd", 18, 0);
+            if (current_file_fd >= 0) {
+                vfs_close_file(current_file_fd);
+                current_file_fd = -1;
+            }
+        }
+        file_write_active = 0;
+        clear_screen();
+        clear_shell();
+        display_shell_prompt();
+        shell_active = 1;
+    } else if (scancode == 0x01) {  // Esc - Cancel
+        if (current_file_fd >= 0) {
+            vfs_close_file(current_file_fd);
+            current_file_fd = -1;
+        }
+        file_write_active = 0;
+        clear_screen();
+        clear_shell();
+        display_shell_prompt();
+        shell_active = 1;
+    } else if (c && c >= 32 && c <= 126 && file_write_index < FILE_WRITE_MAX - 1) {
+        file_write_buffer[file_write_index++] = c;
+        file_write_buffer[file_write_index] = 0;
+        redraw_write_buffer(text_row_start, text_col, rect_width, rect_height);
+    }
+
+    asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+    return;
+}
+
+  // Handle diary input
+    if (diary_active) {
+        const int rect_width = 60;
+        const int rect_height = 15;
+        const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
+        const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
+        const int text_row_start = rect_start_row + 5;
+        const int text_col = rect_start_col + 2;
+        static int current_row = 0;
+        static int current_col = 0;
+        int text_row = text_row_start + current_row;
+
+        if (scancode == 0x0E && diary_index > 0) { // Backspace
+            diary_index--;
+            if (current_col > 0) {
+                current_col--;
+            } else if (current_row > 0) {
+                current_row--;
+                current_col = rect_width - 4 - 1;
+            }
+            vga[(text_row_start + current_row) * VGA_WIDTH + text_col + current_col] = 0x2F00 | ' ';
+            diary_buffer[diary_index] = 0;
+        } else if (scancode == 0x1C) { // Enter
+            diary_buffer[diary_index] = 0;
+            if (diary_index > 0) {
+                int fd = vfs_open_file("diary.txt");
+                if (fd < 0) {
+                    fd = vfs_create_file("diary.txt");
+                }
+                if (fd >= 0) {
+                    vfs_write_file(fd, diary_buffer, diary_index);
+                    vfs_close_file(fd);
+                }
+            }
+            diary_active = 0;
+            current_row = 0;
+            current_col = 0;
+            clear_screen();
+            clear_shell();
+            display_shell_prompt();
+            shell_active = 1;
+        } else if (scancode == 0x01) { // Escape
+            diary_active = 0;
+            current_row = 0;
+            current_col = 0;
+            clear_screen();
+            clear_shell();
+            display_shell_prompt();
+            shell_active = 1;
+        } else if (c && current_row < rect_height - 6) {
+            if (current_col >= rect_width - 4) {
+                current_row++;
+                current_col = 0;
+                text_row = text_row_start + current_row;
+            }
+            if (current_row < rect_height - 6) {
+                diary_buffer[diary_index] = c;
+                vga[text_row * VGA_WIDTH + text_col + current_col] = 0x2F00 | c;
+                diary_index++;
+                current_col++;
+                diary_buffer[diary_index] = 0;
+            }
+        }
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+
+
+
+    if (c == '1') {
+        if (!menu_active && !shell_active) {
+            menu_active = 1;
+            display_menu();
+        } else if (menu_active && !shell_active) {
+            menu_active = 0;
+            hide_menu();
+        }
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+
+    if (c == '2' && !shell_active) {
+        halt_system();
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+
+    if (c == '3' && menu_active && !shell_active) {
+        display_bsod();
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+
+    if (menu_active && !shell_active) {
+        if (c == 'S' || c == 's') {
+            shell_active = 1;
+            display_shell_prompt();
+        } else if (c == 'V' || c == 'v') {
+            display_vm_info();
+        }
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+
+    if (shell_active) {
+        if (shell_index == 0) {
+            clear_shell_input();
+            display_shell_prompt();
+            memset(shell_buffer, 0, sizeof(shell_buffer));
+        }
+
+        if (ext && (scancode == 0x48 || scancode == 0x50)) { // Up, Down
+            history_recall(scancode == 0x48 ? 1 : -1);
+            asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+            return;
+        }
+
+        if (scancode == 0x0E && shell_index > 0) {
+            shell_index--;
+            shell_buffer[shell_index] = 0;
+            draw_shell_input();
+            asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+            return;
+        }
+
+        if (scancode == 0x1C) {
+            shell_buffer[shell_index] = 0;
+            clear_shell_command_prompt();
+            clear_shell_output();
+
+            for (int i = 0; i < shell_index; i++) {
+                if (shell_buffer[i] < 32 || shell_buffer[i] > 126) {
+                    shell_buffer[i] = ' ';
+                }
+            }
+            shell_buffer[shell_index] = 0;
+
+            int piped = 0;
+            for (int i = 0; i < shell_index; i++) {
+                if (shell_buffer[i] == '|') piped = 1;
+            }
+
+            shell_history_add(shell_buffer);
+            history_pos = -1;
+            if (piped) {
+                memsetw(&vga[15 * VGA_WIDTH], 0x0700, 5 * VGA_WIDTH); // Rows 15-19
+                if (run_pipeline(shell_buffer) < 0) {
+                    print_string("Pipeline failed: use ls, ps, echo, cat, grep, wc (max 4 stages)", 15, 0);
+                }
+                show_command(shell_buffer);
+                display_shell_prompt();
+            } else {
+                shell_execute(shell_buffer);
+            }
+
+            shell_index = 0;
+            memset(shell_buffer, 0, sizeof(shell_buffer));
+            asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+            return;
+        }
+
+        if (c && c >= 32 && c <= 126 && shell_index < VGA_WIDTH - 9) {
+            shell_buffer[shell_index++] = c;
+            shell_buffer[shell_index] = 0;
+            draw_shell_input();
+        }
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+
+    if (scancode == 0x0E && buffer_index > 0) {
+        buffer_index--;
+        vga[15 * VGA_WIDTH + buffer_index] = 0x0700;
+        keyboard_buffer[buffer_index] = 0;
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+
+    if (scancode == 0x1C) {
+        buffer_index = 0;
+        memsetw(&vga[15 * VGA_WIDTH], 0x0700, VGA_WIDTH);
+        memset(keyboard_buffer, 0, sizeof(keyboard_buffer));
+        asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+        return;
+    }
+
+    if (c && c >= 32 && c <= 126 && buffer_index < VGA_WIDTH - 1) {
+        keyboard_buffer[buffer_index] = c;
+        vga[15 * VGA_WIDTH + buffer_index] = 0x0700 | c;
+        buffer_index++;
+        keyboard_buffer[buffer_index] = 0;
+    }
+    asm volatile("mov $0x20, %%al\n\tout %%al, $0x20" : : : "eax");
+}
+
+// Keyboard Initialization
+void wait_kbc_input_buffer() {
+    unsigned char status;
+    do {
+        asm volatile("inb $0x64, %0" : "=a"(status));
+    } while (status & 0x02);
+}
+
+void wait_kbc_output_buffer() {
+    unsigned char status;
+    do {
+        asm volatile("inb $0x64, %0" : "=a"(status));
+    } while (!(status & 0x01));
+}
+
+void init_keyboard() {
+    unsigned char status;
+    wait_kbc_input_buffer();
+    asm volatile("mov $0xAD, %%al\n\tout %%al, $0x64" : : : "eax");
+    wait_kbc_input_buffer();
+    asm volatile("mov $0xA7, %%al\n\tout %%al, $0x64" : : : "eax");
+    asm volatile("inb $0x60, %0" : "=a"(status) : : "memory");
+    wait_kbc_input_buffer();
+    asm volatile("mov $0xAE, %%al\n\tout %%al, $0x64" : : : "eax");
+    wait_kbc_input_buffer();
+    asm volatile("mov $0x20, %%al\n\tout %%al, $0x64" : : : "eax");
+    wait_kbc_output_buffer();
+    asm volatile("inb $0x60, %0" : "=a"(status) : : "memory");
+    status |= 0x01;
+    status &= ~0x02;
+    wait_kbc_input_buffer();
+    asm volatile("mov $0x60, %%al\n\tout %%al, $0x64" : : : "eax");
+    wait_kbc_input_buffer();
+    asm volatile("mov %0, %%al\n\tout %%al, $0x60" : : "r"(status) : "eax", "memory");
+    wait_kbc_input_buffer();
+    asm volatile("mov $0xFF, %%al\n\tout %%al, $0x60" : : : "eax", "memory");
+    wait_kbc_output_buffer();
+    asm volatile("inb $0x60, %0" : "=a"(status) : : "memory");
+    if (status != 0xFA) {
+        print_string("KBD RESET FAIL", 1, 0);
+    }
+}
+
+// Interrupt Descriptor Table Setup
+static unsigned int idt[256 * 2] __attribute__((aligned(8)));
+
+// PIT channel 0 at TIMER_HZ, square wave mode, instead of the BIOS 18.2 Hz:
+// the scheduler tick and the unit of SCHED_EDF budgets and periods
+void init_timer() {
+    unsigned int divisor = 1193182 / TIMER_HZ;
+    outb(0x43, 0x36);
+    outb(0x40, divisor & 0xFF);
+    outb(0x40, divisor >> 8);
+}
+
+void setup_idt() {
+    extern void default_handler_wrapper();
+    extern void timer_handler_wrapper();
+    extern void keyboard_handler_wrapper();
+    extern void double_fault_handler_wrapper();
+    extern void syscall_handler_wrapper();
+    extern void divide_error_wrapper();
+    extern void invalid_opcode_wrapper();
+    extern void device_not_available_wrapper();
+    extern void general_protection_wrapper();
+    extern void page_fault_wrapper();
+    extern void fpu_error_wrapper();
+    extern void simd_error_wrapper();
+    for (int i = 0; i < 256; i++) {
+        unsigned int handler = (unsigned int)default_handler_wrapper;
+        idt[i * 2] = (handler & 0xFFFF) | (0x08 << 16);
+        idt[i * 2 + 1] = (handler & 0xFFFF0000) | 0x8E00;
+    }
+    unsigned int df_addr = (unsigned int)double_fault_handler_wrapper;
+    idt[0x08 * 2] = (df_addr & 0xFFFF) | (0x08 << 16);
+    idt[0x08 * 2 + 1] = (df_addr & 0xFFFF0000) | 0x8E00;
+    static const struct {
+        int vector;
+        void (*wrapper)();
+    } faults[] = {
+        { 0x00, divide_error_wrapper },
+        { 0x06, invalid_opcode_wrapper },
+        { 0x07, device_not_available_wrapper },
+        { 0x0D, general_protection_wrapper },
+        { 0x0E, page_fault_wrapper },
+        { 0x10, fpu_error_wrapper },
+        { 0x13, simd_error_wrapper },
+    };
+    for (unsigned int i = 0; i < sizeof(faults) / sizeof(faults[0]); i++) {
+        unsigned int addr = (unsigned int)faults[i].wrapper;
+        idt[faults[i].vector * 2] = (addr & 0xFFFF) | (0x08 << 16);
+        idt[faults[i].vector * 2 + 1] = (addr & 0xFFFF0000) | 0x8E00;
+    }
+    unsigned int timer_addr = (unsigned int)timer_handler_wrapper;
+    idt[0x20 * 2] = (timer_addr & 0xFFFF) | (0x08 << 16);
+    idt[0x20 * 2 + 1] = (timer_addr & 0xFFFF0000) | 0x8E00;
+    unsigned int kb_addr = (unsigned int)keyboard_handler_wrapper;
+    idt[0x21 * 2] = (kb_addr & 0xFFFF) | (0x08 << 16);
+    idt[0x21 * 2 + 1] = (kb_addr & 0xFFFF0000) | 0x8E00;
+    unsigned int syscall_addr = (unsigned int)syscall_handler_wrapper;
+    idt[0x80 * 2] = (syscall_addr & 0xFFFF) | (0x08 << 16);
+    idt[0x80 * 2 + 1] = (syscall_addr & 0xFFFF0000) | 0xEE00;
+    struct {
+        unsigned short limit;
+        unsigned int base;
+    } __attribute__((packed)) idtr = { 256 * 8 - 1, (unsigned int)idt };
+    asm volatile("lidt %0" : : "m"(idtr) : "memory");
+    asm volatile(
+        "mov $0x11, %%al\n\t"
+        "out %%al, $0x20\n\t"
+        "out %%al, $0xA0\n\t"
+        "mov $0x20, %%al\n\t"
+        "out %%al, $0x21\n\t"
+        "mov $0x28, %%al\n\t"
+        "out %%al, $0xA1\n\t"
+        "mov $0x04, %%al\n\t"
+        "out %%al, $0x21\n\t"
+        "mov $0x02, %%al\n\t"
+        "out %%al, $0xA1\n\t"
+        "mov $0x01, %%al\n\t"
+        "out %%al, $0x21\n\t"
+        "out %%al, $0xA1\n\t"
+        "mov $0xFC, %%al\n\t"
+        "out %%al, $0x21\n\t"
+        "mov $0x7F, %%al\n\t"
+        "out %%al, $0xA1\n\t"
+        : : : "eax"
+    );
+    for (volatile int i = 0; i < 10000; i++);
+}
+
+// RAM disk ram0: the "ramdisk" boot module when there is one (a saved disk
+// image, left as it is), otherwise zeroed memory. Mount it with "mount ram0".
+#define RAMDISK_BLOCKS 2048 // 1 MiB
+
+static char ramdisk_mem[RAMDISK_BLOCKS * BLOCK_SIZE];
+static RamDisk ram0;
+
+static void init_ramdisk() {
+    unsigned int size;
+    void* image = (void*)multiboot_find_module("ramdisk", &size);
+    if (image && size >= BLOCK_SIZE) {
+        ramdisk_init(&ram0, "ram0", image, size / BLOCK_SIZE);
+    } else {
+        ramdisk_init(&ram0, "ram0", ramdisk_mem, RAMDISK_BLOCKS);
+    }
+    if (block_register(&ram0.dev) < 0) {
+        serial_write("ram0: not registered, its block checksums do not fit\n");
+        print_string("ram0 not registered: its block checksums do not fit", 16, 0);
+    }
+}
+
+// Sample Kernel Tasks
+void task1() {
+    int counter = 0;
+    while (1) {
+        char buf[10];
+        int i = 0, temp = counter;
+        do {
+            buf[i++] = (temp % 10) + '0';
+            temp /= 10;
+        } while (temp);
+        buf[i] = 0;
+        for (int j = 0; j < i / 2; j++) {
+            char t = buf[j];
+            buf[j] = buf[i - j - 1];
+            buf[i - j - 1] = t;
+        }
+        print_string(buf, 10, 10);
+        counter++;
+        for (volatile int j = 0; j < 100000; j++);
+        schedule_flag = 1;
+    }
+}
+
+void task2() {
+    while (1) {
+        for (volatile int j = 0; j < 100000; j++);
+        schedule_flag = 1;
+    }
+}
+
+// Startup and Animation
+void startup_animation() {
+    const char* welcome_msg = "Sebria OS!";
+    int msg_len = 0;
+    while (welcome_msg[msg_len]) msg_len++;
+    int msg_row = 12;
+    int msg_col = 35;
+    int bar_row = 13;
+    int bar_col = 30;
+    int bar_width = 20;
+    char bar[23];
+    bar[0] = '[';
+    bar[bar_width + 1] = ']';
+    bar[bar_width + 2] = 0;
+    for (int i = 1; i <= bar_width; i++) {
+        bar[i] = ' ';
+    }
+    print_string(bar, bar_row, bar_col);
+    for (int i = 0; i < bar_width; i++) {
+        bar[i + 1] = '*';
+        print_string_with_attr(bar, bar_row, bar_col, 0x09);
+        for (int j = 0; j < 10; j++) {
+            while (!schedule_flag);
+            schedule_flag = 0;
+        }
+    }
+    for (int i = 0; i < 10; i++) {
+        while (!schedule_flag);
+        schedule_flag = 0;
+    }
+    for (int i = 0; i < msg_len; i++) {
+        unsigned short* vga = (unsigned short*)VGA_BUFFER;
+        vga[msg_row * VGA_WIDTH + msg_col + i] = 0x0700 | welcome_msg[i];
+        for (int j = 0; j < 5; j++) {
+            while (!schedule_flag);
+            schedule_flag = 0;
+        }
+    }
+    for (int i = 0; i < 20; i++) {
+        while (!schedule_flag);
+        schedule_flag = 0;
+    }
+    clear_screen();
+}
+
+void display_instructions() {
+    unsigned short* vga = (unsigned short*)VGA_BUFFER;
+    const int rect_width = 60;
+    const int rect_height = 15;
+    const int rect_start_row = (VGA_HEIGHT - rect_height) / 2;
+    const int rect_start_col = (VGA_WIDTH - rect_width) / 2;
+    const int rect_end_row = rect_start_row + rect_height - 1;
+    const int rect_end_col = rect_start_col + rect_width - 1;
+    clear_screen();
+    for (int row = rect_start_row; row <= rect_end_row; row++) {
+        memsetw(&vga[row * VGA_WIDTH + rect_start_col], 0x2F00 | ' ', rect_width);
+    }
+    memsetw(&vga[rect_start_row * VGA_WIDTH + rect_start_col], 0x2F00 | '-', rect_width);
+    memsetw(&vga[rect_end_row * VGA_WIDTH + rect_start_col], 0x2F00 | '-', rect_width);
+    for (int row = rect_start_row + 1; row < rect_end_row; row++) {
+        vga[row * VGA_WIDTH + rect_start_col] = 0x2F00 | '|';
+        vga[row * VGA_WIDTH + rect_end_col] = 0x2F00 | '|';
+    }
+    vga[rect_start_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
+    vga[rect_start_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
+    vga[rect_end_row * VGA_WIDTH + rect_start_col] = 0x2F00 | '+';
+    vga[rect_end_row * VGA_WIDTH + rect_end_col] = 0x2F00 | '+';
+    int text_row = rect_start_row + 1;
+    int text_col = rect_start_col + 2;
+    print_string_with_attr("Sebria OS Instructions", text_row++, text_col, 0x2F);
+    print_string_with_attr("----------------------", text_row++, text_col, 0x2F);
+    print_string_with_attr("1. Press '1' to show/hide the menu.", text_row++, text_col, 0x2F);
+    print_string_with_attr("2. Press 'S' in menu to enter shell.", text_row++, text_col, 0x2F);
+    print_string_with_attr("3. Commands: ls, ps, touch, cat, kill, clear, diary, bench", text_row++, text_col, 0x2F);
+    print_string_with_attr("4. Use 'touch ' to create and write to a file.", text_row++, text_col, 0x2F);
+    print_string_with_attr("5. Use 'cat ' to read a file.", text_row++, text_col, 0x2F);
+    print_string_with_attr("6. Press 'V' in menu to view virtual memory info.", text_row++, text_col, 0x2F);
+    print_string_with_attr("7. Press '2' to halt the system.", text_row++, text_col, 0x2F);
+    print_string_with_attr("8. Press '3' in menu to simulate a crash (BSOD).", text_row++, text_col, 0x2F);
+    print_string_with_attr("----------------------", text_row++, text_col, 0x2F);
+    print_string_with_attr("Press any key to continue...", text_row, text_col, 0x2F);
+
+while (1) {
+    unsigned char status, scancode;
+    asm volatile("inb $0x64, %0" : "=a"(status));
+if (status & 0x01) {
+    asm volatile("inb $0x60, %0" : "=a"(scancode));
+if (!(scancode & 0x80)) {
+    clear_screen();
+break;
+}
+}
+}
+}
+
+// Kernel Main Function
+void kmain(unsigned int magic, MultibootInfo* mbi) {
+unsigned long long boot_tsc = rdtsc(); // Cycles since reset: firmware, GRUB, load
+clear_screen();
+if (!multiboot_init(magic, mbi)) {
+print_string("No multiboot info: memory map unavailable", 5, 0);
+}
+//print_string("Starting Sebria OS...", 1, 0);
+
+// Initialize subsystems
+cpu_init();
+fpu_init();
+klib_init(); // memcpy/memset: SSE2 paths if fpu_init enabled SSE
+crc32c_init();
+init_serial();
+init_gdt();
+serial_write("boot tsc=");
+serial_write_u64(boot_tsc);
+serial_write("\n");
+if (multiboot_cmdline_has("boottime")) {
+qemu_exit(0); // boot_time.sh: stop as soon as the kernel is running
+}
+init_pmm(multiboot_reserved_end((unsigned int)kernel_end));
+init_paging();
+
+init_vfs(); // Ensure VFS is initialized
+init_ramdisk();
+init_shell();
+
+setup_idt();
+init_timer();
+init_keyboard();
+asm volatile("sti");
+
+// Initialize processes
+init_processes();
+
+// Create sample processes
+// The sample tasks are CPU hogs: they share the CPU fairly, 5:3 by weight
+// (fair_delta), and only when no strict-priority task is ready
+sched_setpolicy(create_process(task1, 5, 0), SCHED_FAIR);
+sched_setpolicy(create_process(task2, 3, 0), SCHED_FAIR);
+create_process(sync_task, 7, 0); // Asleep unless a mounted VFS has changes
+create_process(history_task, 7, 0); // Asleep unless the shell history has changed
+processes[0].state = 1; // Set first process as running
+
+#ifdef BENCH_AUTORUN
+// Headless benchmark image: run the suite, report over COM1 and leave QEMU
+run_benchmarks();
+qemu_exit(0);
+halt_system();
+#endif
+
+// User programs: every GRUB module is an ELF32 executable run in ring 3.
+// Priority 6 puts them (and their forks) ahead of task1/task2.
+int module_count;
+MultibootModule* modules = multiboot_modules(&module_count);
+unsigned int disk_size;
+const void* disk_image = multiboot_find_module("ramdisk", &disk_size);
+for (int i = 0; i < module_count; i++) {
+if ((const void*)modules[i].mod_start == disk_image) continue; // ram0's contents
+if (proc_spawn_elf((const void*)modules[i].mod_start, modules[i].mod_end - modules[i].mod_start, 6) < 0) {
+print_string("Bad ELF module", 5, 0);
+}
+}
+
+// Run startup animation
+startup_animation();
+
+// Display instructions
+display_instructions();
+
+
+// Main kernel loop: kmain is now the idle task. The timer IRQ preempts it
+// and every other task through task_switch.
+sched_start();
+while (1) {
+asm volatile("hlt");
+}
 }
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "klib.h"
+#include "cpu.h"
+
+// Memory Functions
+// The bulk of each is one rep string instruction (movsd, stosd, scasb) or,
+// once klib_init has found SSE2 usable, 64 bytes per step in xmm registers.
+// Everything is in asm so the compiler cannot turn a loop in here back into
+// a call to the function it is in. In the kernel the xmm registers may hold
+// a task's state, so SSE runs between kernel_fpu_begin and kernel_fpu_end,
+// and only for copies long enough to pay for saving it.
+int klib_sse2 = 0;
+
+#ifdef HOST_BUILD
+#define SSE2_MIN 128     // Shorter runs are faster as rep movsd/stosd
+#define SSE2_STRLEN 1
+#define SIMD_BEGIN() 0
+#define SIMD_END(flags) (void)(flags)
+#else
+#define SSE2_MIN 1024
+#define SSE2_STRLEN 0    // Kernel strings are short: rep scasb
+#define SIMD_BEGIN() kernel_fpu_begin()
+#define SIMD_END(flags) kernel_fpu_end(flags)
+#endif
+
+typedef unsigned int __attribute__((may_alias)) word_alias;
+
+// Pick the SSE2 paths if the CPU has SSE2 and SSE is enabled (executing
+// SSE instructions otherwise faults). Call after cpu_init and fpu_init.
+void klib_init() {
+    klib_sse2 = cpu_info.sse_enabled && cpu_has(CPU_SSE2);
+}
+
+// n: a non-zero multiple of 64
+__attribute__((target("sse2")))
+static void sse2_copy(char* d, const char* s, size_t n) {
+    asm volatile("1:\n\t"
+                 "movdqu (%1), %%xmm0\n\t"
+                 "movdqu 16(%1), %%xmm1\n\t"
+                 "movdqu 32(%1), %%xmm2\n\t"
+                 "movdqu 48(%1), %%xmm3\n\t"
+                 "movdqu %%xmm0, (%0)\n\t"
+                 "movdqu %%xmm1, 16(%0)\n\t"
+                 "movdqu %%xmm2, 32(%0)\n\t"
+                 "movdqu %%xmm3, 48(%0)\n\t"
+                 "add $64, %0\n\t"
+                 "add $64, %1\n\t"
+                 "sub $64, %2\n\t"
+                 "jnz 1b"
+                 : "+r"(d), "+r"(s), "+r"(n) : : "memory", "xmm0", "xmm1", "xmm2", "xmm3");
+}
+
+__attribute__((target("sse2")))
+static void sse2_fill(char* d, unsigned int fill, size_t n) {
+    unsigned int pattern[4] = { fill, fill, fill, fill };
+    asm volatile("movdqu (%2), %%xmm0\n"
+                 "1:\n\t"
+                 "movdqu %%xmm0, (%0)\n\t"
+                 "movdqu %%xmm0, 16(%0)\n\t"
+                 "movdqu %%xmm0, 32(%0)\n\t"
+                 "movdqu %%xmm0, 48(%0)\n\t"
+                 "add $64, %0\n\t"
+                 "sub $64, %1\n\t"
+                 "jnz 1b"
+                 : "+r"(d), "+r"(n) : "r"(pattern) : "memory", "xmm0");
+}
+
+// Offset of the first 16-byte block that differs, or n (a multiple of 16)
+__attribute__((target("sse2")))
+static size_t sse2_mismatch(const unsigned char* p, const unsigned char* q, size_t n) {
+    size_t i = 0;
+    for (; i < n; i += 16) {
+        unsigned int mask;
+        asm volatile("movdqu (%1), %%xmm0\n\t"
+                     "movdqu (%2), %%xmm1\n\t"
+                     "pcmpeqb %%xmm1, %%xmm0\n\t"
+                     "pmovmskb %%xmm0, %0"
+                     : "=r"(mask) : "r"(p + i), "r"(q + i) : "memory", "xmm0", "xmm1");
+        if (mask != 0xFFFF) break;
+    }
+    return i;
+}
+
+// p: 16-byte aligned, so no load crosses into a page the string is not on
+__attribute__((target("sse2")))
+static const char* sse2_strend(const char* p) {
+    while (1) {
+        unsigned int mask;
+        asm volatile("pxor %%xmm0, %%xmm0\n\t"
+                     "pcmpeqb (%1), %%xmm0\n\t"
+                     "pmovmskb %%xmm0, %0"
+                     : "=r"(mask) : "r"(p) : "memory", "xmm0");
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+}
+
+void* memcpy(void* dest, const void* src, size_t n) {
+    char* d = (char*)dest;
+    const char* s = (const char*)src;
+    if (klib_sse2 && n >= SSE2_MIN) {
+        size_t bulk = n & ~(size_t)63;
+        unsigned int flags = SIMD_BEGIN();
+        sse2_copy(d, s, bulk);
+        SIMD_END(flags);
+        d += bulk;
+        s += bulk;
+        n -= bulk;
+    }
+    size_t words = n >> 2, tail = n & 3;
+    asm volatile("rep movsl" : "+D"(d), "+S"(s), "+c"(words) : : "memory");
+    asm volatile("rep movsb" : "+D"(d), "+S"(s), "+c"(tail) : : "memory");
+    return dest;
+}
+
+// Forward copies are safe unless dest overlaps the end of src; those run
+// backwards with the direction flag set (interrupt entry clears it)
+void* memmove(void* dest, const void* src, size_t n) {
+    char* d = (char*)dest;
+    const char* s = (const char*)src;
+    if (d <= s || d >= s + n) return memcpy(dest, src, n);
+    size_t words = n >> 2, tail = n & 3;
+    d += n - 1;
+    s += n - 1;
+    asm volatile("std\n\t"
+                 "rep movsb\n\t"
+                 "sub $3, %0\n\t"
+                 "sub $3, %1\n\t"
+                 "mov %3, %2\n\t"
+                 "rep movsl\n\t"
+                 "cld"
+                 : "+D"(d), "+S"(s), "+c"(tail) : "r"(words) : "memory");
+    return dest;
+}
+
+void* memset(void* dest, int c, size_t n) {
+    char* d = (char*)dest;
+    unsigned int fill = (unsigned char)c * 0x01010101u;
+    if (klib_sse2 && n >= SSE2_MIN) {
+        size_t bulk = n & ~(size_t)63;
+        unsigned int flags = SIMD_BEGIN();
+        sse2_fill(d, fill, bulk);
+        SIMD_END(flags);
+        d += bulk;
+        n -= bulk;
+    }
+    size_t words = n >> 2, tail = n & 3;
+    asm volatile("rep stosl" : "+D"(d), "+c"(words) : "a"(fill) : "memory");
+    asm volatile("rep stosb" : "+D"(d), "+c"(tail) : "a"(fill) : "memory");
+    return dest;
+}
+
+// Fill count 16-bit cells (VGA text: character and attribute)
+void memsetw(unsigned short* dest, unsigned short value, size_t count) {
+    asm volatile("rep stosw" : "+D"(dest), "+c"(count) : "a"(value) : "memory");
+}
+
+int memcmp(const void* a, const void* b, size_t n) {
+    const unsigned char* p = (const unsigned char*)a;
+    const unsigned char* q = (const unsigned char*)b;
+    size_t i = 0;
+    if (klib_sse2 && n >= SSE2_MIN) {
+        unsigned int flags = SIMD_BEGIN();
+        i = sse2_mismatch(p, q, n & ~(size_t)15);
+        SIMD_END(flags);
+    }
+    while (i + 4 <= n && *(const word_alias*)(p + i) == *(const word_alias*)(q + i)) i += 4;
+    for (; i < n; i++) {
+        if (p[i] != q[i]) return p[i] - q[i];
+    }
+    return 0;
+}
+
+size_t strlen(const char* s) {
+    const char* p = s;
+    if (SSE2_STRLEN && klib_sse2) {
+        for (; (unsigned long)p & 15; p++) {
+            if (!*p) return p - s;
+        }
+        return sse2_strend(p) - s;
+    }
+    size_t count = ~(size_t)0;
+    asm volatile("repne scasb" : "+D"(p), "+c"(count) : "a"(0) : "memory");
+    return ~count - 1;
+}
+
+// String manipulation functions
+void custom_strcpy(char* dest, const char* src) {
+    while (*src) {
+        *dest++ = *src++;
+    }
+    *dest = 0;
+}
+
+int strcmp(const char* s1, const char* s2) {
+    while (*s1 && *s2 && *s1 == *s2) {
+        s1++;
+        s2++;
+    }
+    return *s1 - *s2;
+}
+
+int strncmp(const char* s1, const char* s2, size_t n) {
+    while (n > 0 && *s1 && *s2 && *s1 == *s2) {
+        s1++;
+        s2++;
+        n--;
+    }
+    if (n == 0) return 0;
+    return *s1 - *s2;
+}
+// 64-bit by 32-bit divide; the kernel links without libgcc (__udivdi3)
+unsigned long long udiv64(unsigned long long n, unsigned int d, unsigned int* rem) {
+    unsigned int hi = (unsigned int)(n >> 32);
+    unsigned int lo = (unsigned int)n;
+    unsigned int qhi = hi / d;
+    unsigned int qlo;
+    hi %= d;
+    asm("divl %4" : "=a"(qlo), "=d"(hi) : "a"(lo), "d"(hi), "rm"(d));
+    if (rem) *rem = hi;
+    return ((unsigned long long)qhi << 32) | qlo;
+}
@@ -0,0 +1,21 @@
+// Freestanding string, memory and arithmetic helpers
+#ifndef KLIB_H
+#define KLIB_H
+
+typedef __SIZE_TYPE__ size_t;
+
+extern int klib_sse2;        // Bulk copies and fills use SSE2 (klib_init)
+
+void klib_init(void);
+void* memcpy(void* dest, const void* src, size_t n);
+void* memmove(void* dest, const void* src, size_t n);
+void* memset(void* dest, int c, size_t n);
+void memsetw(unsigned short* dest, unsigned short value, size_t count);
+int memcmp(const void* a, const void* b, size_t n);
+size_t strlen(const char* s);
+void custom_strcpy(char* dest, const char* src);
+int strcmp(const char* s1, const char* s2);
+int strncmp(const char* s1, const char* s2, size_t n);
+unsigned long long udiv64(unsigned long long n, unsigned int d, unsigned int* rem);
+
+#endif
@@ -0,0 +1,40 @@
+#include "lock.h"
+#include "sched.h"
+
+void mutex_init(Mutex* m) {
+    m->locked = 0;
+    m->owner = -2;
+}
+
+// Sleep until the mutex is free, then take it. Task context only: the idle
+// loop and interrupt handlers cannot sleep, so they must use trylock.
+void mutex_lock(Mutex* m) {
+    unsigned int flags = irq_save();
+    while (m->locked) {
+        proc_sleep(m);
+    }
+    m->locked = 1;
+    m->owner = current_process;
+    irq_restore(flags);
+}
+
+// Take the mutex if it is free. Returns 1 on success, 0 if it is held.
+int mutex_trylock(Mutex* m) {
+    unsigned int flags = irq_save();
+    int taken = !m->locked;
+    if (taken) {
+        m->locked = 1;
+        m->owner = current_process;
+    }
+    irq_restore(flags);
+    return taken;
+}
+
+// Release the mutex and wake one sleeper, which retries the lock
+void mutex_unlock(Mutex* m) {
+    unsigned int flags = irq_save();
+    m->locked = 0;
+    m->owner = -2;
+    wake_up_nr(m, 1);
+    irq_restore(flags);
+}
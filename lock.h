@@ -0,0 +1,50 @@
+// Kernel locks: spinlocks for data shared with interrupt handlers,
+// sleeping mutexes for long critical sections in task context
+#ifndef LOCK_H
+#define LOCK_H
+
+#include "hal.h"
+
+typedef struct {
+    volatile int locked;
+} Spinlock;
+
+typedef struct {
+    volatile int locked;
+    int owner;            // Slot of the holder (IDLE_PROCESS for kmain), -2 when free
+} Mutex;
+
+#define SPINLOCK_INIT { 0 }
+#define MUTEX_INIT { 0, -2 }
+
+// Spinlocks never sleep. Data also touched by interrupt handlers must use
+// the irqsave variants: an interrupt taken while the lock is held would
+// spin on it forever. On this single CPU the spin only ever catches a
+// missing irqsave; the lock word keeps the code correct if that changes.
+static inline void spin_lock(Spinlock* lock) {
+    while (__sync_lock_test_and_set(&lock->locked, 1)) {
+        while (lock->locked) asm volatile("pause");
+    }
+}
+
+static inline void spin_unlock(Spinlock* lock) {
+    __sync_lock_release(&lock->locked);
+}
+
+static inline unsigned int spin_lock_irqsave(Spinlock* lock) {
+    unsigned int flags = irq_save();
+    spin_lock(lock);
+    return flags;
+}
+
+static inline void spin_unlock_irqrestore(Spinlock* lock, unsigned int flags) {
+    spin_unlock(lock);
+    irq_restore(flags);
+}
+
+void mutex_init(Mutex* m);
+void mutex_lock(Mutex* m);
+int mutex_trylock(Mutex* m);
+void mutex_unlock(Mutex* m);
+
+#endif
@@ -0,0 +1,111 @@
+#include "lz4.h"
+
+#define MIN_MATCH 4
+#define LAST_LITERALS 5   // The last 5 bytes are always literals
+#define MF_LIMIT 12       // The last match must start 12 bytes before the end
+#define MAX_OFFSET 65535
+
+static unsigned int read32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static unsigned int hash32(unsigned int seq) {
+    return (seq * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+// Length field continuation: 255-valued bytes then the remainder
+static int put_length(unsigned char* dst, int op, int cap, int len) {
+    while (len >= 255) {
+        if (op >= cap) return -1;
+        dst[op++] = 255;
+        len -= 255;
+    }
+    if (op >= cap) return -1;
+    dst[op++] = (unsigned char)len;
+    return op;
+}
+
+static int put_sequence(unsigned char* dst, int op, int cap, const unsigned char* lit,
+                        int lit_len, int offset, int match_len) {
+    if (op >= cap) return -1;
+    int token = op++;
+    int match_code = match_len ? match_len - MIN_MATCH : 0;
+    dst[token] = (unsigned char)(((lit_len < 15 ? lit_len : 15) << 4) |
+                                 (match_code < 15 ? match_code : 15));
+    if (lit_len >= 15 && (op = put_length(dst, op, cap, lit_len - 15)) < 0) return -1;
+    if (op + lit_len > cap) return -1;
+    for (int i = 0; i < lit_len; i++) dst[op++] = lit[i];
+    if (!match_len) return op;
+    if (op + 2 > cap) return -1;
+    dst[op++] = offset & 0xFF;
+    dst[op++] = offset >> 8;
+    if (match_code >= 15 && (op = put_length(dst, op, cap, match_code - 15)) < 0) return -1;
+    return op;
+}
+
+// Greedy single-probe compressor
+int lz4_compress(const unsigned char* src, int len, unsigned char* dst, int cap, int* table) {
+    int ip = 0, anchor = 0, op = 0;
+    for (int i = 0; i < LZ4_HASH_SIZE; i++) table[i] = -1;
+
+    if (len > MF_LIMIT) {
+        int limit = len - MF_LIMIT;
+        while (ip < limit) {
+            unsigned int seq = read32(src + ip);
+            unsigned int h = hash32(seq);
+            int ref = table[h];
+            table[h] = ip;
+            if (ref < 0 || ip - ref > MAX_OFFSET || read32(src + ref) != seq) {
+                ip++;
+                continue;
+            }
+            int match_len = MIN_MATCH;
+            int max_len = len - LAST_LITERALS - ip;
+            while (match_len < max_len && src[ref + match_len] == src[ip + match_len]) {
+                match_len++;
+            }
+            op = put_sequence(dst, op, cap, src + anchor, ip - anchor, ip - ref, match_len);
+            if (op < 0) return -1;
+            ip += match_len;
+            anchor = ip;
+        }
+    }
+    return put_sequence(dst, op, cap, src + anchor, len - anchor, 0, 0);
+}
+
+int lz4_decompress(const unsigned char* src, int len, unsigned char* dst, int cap) {
+    int ip = 0, op = 0;
+    while (ip < len) {
+        int token = src[ip++];
+        int lit_len = token >> 4;
+        if (lit_len == 15) {
+            int b;
+            do {
+                if (ip >= len) return -1;
+                b = src[ip++];
+                lit_len += b;
+            } while (b == 255);
+        }
+        if (ip + lit_len > len || op + lit_len > cap) return -1;
+        for (int i = 0; i < lit_len; i++) dst[op++] = src[ip++];
+        if (ip >= len) break; // Final sequence carries literals only
+
+        if (ip + 2 > len) return -1;
+        int offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        int match_len = token & 15;
+        if (match_len == 15) {
+            int b;
+            do {
+                if (ip >= len) return -1;
+                b = src[ip++];
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += MIN_MATCH;
+        if (offset == 0 || offset > op || op + match_len > cap) return -1;
+        // Byte copy: overlapping matches repeat the pattern
+        for (int i = 0; i < match_len; i++, op++) dst[op] = dst[op - offset];
+    }
+    return op;
+}
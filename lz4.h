@@ -0,0 +1,19 @@
+// LZ4 block format codec
+// Raw blocks only (no frame header): the sizes travel out of band. Portable,
+// no allocation: the compressor takes a caller-provided hash table.
+#ifndef LZ4_H
+#define LZ4_H
+
+#define LZ4_HASH_BITS 12
+#define LZ4_HASH_SIZE (1 << LZ4_HASH_BITS)
+
+// Worst-case compressed size of len input bytes
+#define LZ4_BOUND(len) ((len) + (len) / 255 + 16)
+
+// Returns the compressed size, or -1 if the output does not fit in cap
+int lz4_compress(const unsigned char* src, int len, unsigned char* dst, int cap, int* table);
+
+// Returns the decompressed size, or -1 on malformed input or overflow
+int lz4_decompress(const unsigned char* src, int len, unsigned char* dst, int cap);
+
+#endif
@@ -0,0 +1,102 @@
+; Compressed kernel loader
+; GRUB loads this stub and the LZ4-packed kernel.bin at LZ_STUB_BASE, the
+; first 64 KiB boundary past the kernel's kernel_end. The stub
+; decompresses the kernel to its link address, zeroes its .bss and enters the
+; real _start with the multiboot registers (eax, ebx) intact.
+; Built by the Makefile with -DKERNEL_LOAD, -DKERNEL_ENTRY, -DKERNEL_END,
+; -DLZ_STUB_BASE and -DPAYLOAD taken from kernel.elf; lzboot.ld gets the
+; same LZ_STUB_BASE through --defsym.
+[bits 32]
+[global lz_start]
+
+%if KERNEL_END > LZ_STUB_BASE
+%error "kernel_end reaches the stub; LZ_STUB_BASE must be at or above it"
+%endif
+
+MB_MAGIC     equ 0x1BADB002
+MB_FLAGS     equ 0x00000003
+MB_CHECKSUM  equ -(MB_MAGIC + MB_FLAGS)
+
+section .multiboot
+align 4
+    dd MB_MAGIC
+    dd MB_FLAGS
+    dd MB_CHECKSUM
+
+section .text
+lz_start:
+    cli
+    mov esp, stub_stack_top
+    push eax                ; Multiboot magic
+    push ebx                ; Multiboot info
+    mov esi, payload
+    mov ebx, payload_end
+    mov edi, KERNEL_LOAD
+    call lz4_decompress
+
+    ; Zero .bss from the end of the decompressed image to kernel_end
+    mov ecx, KERNEL_END
+    sub ecx, edi
+    jbe .enter
+    xor eax, eax
+    rep stosb
+.enter:
+    pop ebx
+    pop eax
+    mov ecx, KERNEL_ENTRY
+    jmp ecx
+
+; ----------------------------------------
+; LZ4 block decoder
+; esi = source, ebx = source end, edi = destination
+; Returns with edi one past the last byte written
+lz4_decompress:
+.token:
+    movzx edx, byte [esi]   ; High nibble: literal length, low: match length - 4
+    inc esi
+    mov ecx, edx
+    shr ecx, 4
+    cmp ecx, 15
+    jne .literals
+.literal_length:
+    movzx eax, byte [esi]
+    inc esi
+    add ecx, eax
+    cmp eax, 255
+    je .literal_length
+.literals:
+    rep movsb
+    cmp esi, ebx
+    jae .done               ; The final sequence has literals only
+    movzx eax, word [esi]   ; Match offset
+    add esi, 2
+    mov ecx, edx
+    and ecx, 15
+    cmp ecx, 15
+    jne .match
+.match_length:
+    movzx edx, byte [esi]
+    inc esi
+    add ecx, edx
+    cmp edx, 255
+    je .match_length
+.match:
+    add ecx, 4
+    push esi
+    mov esi, edi
+    sub esi, eax
+    rep movsb               ; Byte copy: overlapping matches repeat
+    pop esi
+    jmp .token
+.done:
+    ret
+
+section .data
+payload:
+    incbin PAYLOAD
+payload_end:
+
+section .bss
+align 16
+    resb 4096
+stub_stack_top:
@@ -0,0 +1,63 @@
+// Host tool: pack kernel.bin as a raw LZ4 block for lzboot.asm
+// Usage: lzpack <in> <out>       compress
+//        lzpack -d <in> <out>    decompress (round-trip check)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lz4.h"
+
+static unsigned char* read_file(const char* path, long* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char* buf = malloc(*size + 1);
+    if (buf && fread(buf, 1, *size, f) != (size_t)*size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    return buf;
+}
+
+int main(int argc, char** argv) {
+    int decompress = argc == 4 && strcmp(argv[1], "-d") == 0;
+    if (argc != 3 && !decompress) {
+        fprintf(stderr, "usage: lzpack [-d] <in> <out>\n");
+        return 2;
+    }
+    const char* in = argv[argc - 2];
+    const char* out = argv[argc - 1];
+    long size;
+    unsigned char* src = read_file(in, &size);
+    if (!src) {
+        perror(in);
+        return 1;
+    }
+
+    int cap = decompress ? 64 * 1024 * 1024 : LZ4_BOUND(size);
+    unsigned char* dst = malloc(cap);
+    int n;
+    if (decompress) {
+        n = lz4_decompress(src, size, dst, cap);
+    } else {
+        static int table[LZ4_HASH_SIZE];
+        n = lz4_compress(src, size, dst, cap, table);
+    }
+    if (n < 0) {
+        fprintf(stderr, "lzpack: %s failed for %s\n", decompress ? "decompress" : "compress", in);
+        return 1;
+    }
+
+    FILE* f = fopen(out, "wb");
+    if (!f || fwrite(dst, 1, n, f) != (size_t)n) {
+        perror(out);
+        return 1;
+    }
+    fclose(f);
+    if (!decompress) {
+        printf("lzpack: %s %ld -> %d bytes (%.1f%%)\n", in, size, n, size ? n * 100.0 / size : 0.0);
+    }
+    return 0;
+}
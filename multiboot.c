@@ -0,0 +1,113 @@
+#include "multiboot.h"
+
+MemRegion mem_regions[MAX_MEM_REGIONS];
+int mem_region_count = 0;
+unsigned int mem_total_kb = 0;
+MultibootInfo* boot_info = 0;
+
+static void add_region(unsigned long long base, unsigned long long len) {
+    if (base >= 0x100000000ULL || len == 0) return;
+    if (base + len > 0x100000000ULL) len = 0x100000000ULL - base;
+    if (mem_region_count >= MAX_MEM_REGIONS) return;
+    mem_regions[mem_region_count].base = (unsigned int)base;
+    mem_regions[mem_region_count].length = (unsigned int)len;
+    mem_region_count++;
+    mem_total_kb += (unsigned int)(len >> 10);
+}
+
+// Record usable memory from the boot loader. Prefers the BIOS memory map and
+// falls back to mem_lower/mem_upper. Returns 0 when not booted by multiboot.
+int multiboot_init(unsigned int magic, MultibootInfo* mbi) {
+    mem_region_count = 0;
+    mem_total_kb = 0;
+    if (magic != MULTIBOOT_BOOTLOADER_MAGIC || !mbi) {
+        boot_info = 0;
+        return 0;
+    }
+    boot_info = mbi;
+    if (mbi->flags & MULTIBOOT_INFO_MEM_MAP) {
+        unsigned int addr = mbi->mmap_addr;
+        unsigned int end = mbi->mmap_addr + mbi->mmap_length;
+        while (addr < end) {
+            MultibootMmapEntry* entry = (MultibootMmapEntry*)addr;
+            if (entry->type == MULTIBOOT_MEMORY_AVAILABLE) {
+                add_region(entry->addr, entry->len);
+            }
+            addr += entry->size + sizeof(entry->size);
+        }
+    } else if (mbi->flags & MULTIBOOT_INFO_MEMORY) {
+        add_region(0, (unsigned long long)mbi->mem_lower << 10);
+        add_region(0x100000, (unsigned long long)mbi->mem_upper << 10);
+    }
+    return 1;
+}
+
+static int has_token(const char* p, const char* word) {
+    while (*p) {
+        while (*p == ' ') p++;
+        int i = 0;
+        while (word[i] && p[i] == word[i]) i++;
+        if (!word[i] && (p[i] == ' ' || p[i] == 0)) return 1;
+        while (*p && *p != ' ') p++;
+    }
+    return 0;
+}
+
+// True when word appears as a whole space-separated token of the kernel
+// command line (grub.cfg: multiboot /boot/kernel.elf <words>)
+int multiboot_cmdline_has(const char* word) {
+    if (!boot_info || !(boot_info->flags & MULTIBOOT_INFO_CMDLINE)) return 0;
+    return has_token((const char*)boot_info->cmdline, word);
+}
+
+// Boot modules loaded by GRUB (grub.cfg: module /boot/<file>)
+MultibootModule* multiboot_modules(int* count) {
+    if (!boot_info || !(boot_info->flags & MULTIBOOT_INFO_MODS)) {
+        *count = 0;
+        return 0;
+    }
+    *count = boot_info->mods_count;
+    return (MultibootModule*)boot_info->mods_addr;
+}
+
+// Module whose command line has name as a token (grub.cfg: module
+// /boot/<file> <name>). Returns its start address and size, or 0.
+const void* multiboot_find_module(const char* name, unsigned int* size) {
+    int count;
+    MultibootModule* mods = multiboot_modules(&count);
+    for (int i = 0; i < count; i++) {
+        if (mods[i].string && has_token((const char*)mods[i].string, name)) {
+            *size = mods[i].mod_end - mods[i].mod_start;
+            return (const void*)mods[i].mod_start;
+        }
+    }
+    return 0;
+}
+
+static unsigned int string_end(unsigned int addr) {
+    const char* s = (const char*)addr;
+    while (*s) s++;
+    return (unsigned int)s + 1;
+}
+
+// First address above the kernel image and everything GRUB placed after it
+// (modules, their names, the module list and command line). The frame
+// allocator hands out memory only above this.
+unsigned int multiboot_reserved_end(unsigned int kernel_end) {
+    unsigned int end = kernel_end;
+    if (!boot_info) return end;
+    unsigned int info_end = (unsigned int)boot_info + sizeof(MultibootInfo);
+    if (info_end > end) end = info_end;
+    if (boot_info->flags & MULTIBOOT_INFO_CMDLINE) {
+        unsigned int cmd_end = string_end(boot_info->cmdline);
+        if (cmd_end > end) end = cmd_end;
+    }
+    int count;
+    MultibootModule* mods = multiboot_modules(&count);
+    if (count && (unsigned int)(mods + count) > end) end = (unsigned int)(mods + count);
+    for (int i = 0; i < count; i++) {
+        if (mods[i].mod_end > end) end = mods[i].mod_end;
+        if (mods[i].string && string_end(mods[i].string) > end) end = string_end(mods[i].string);
+    }
+    return end;
+}
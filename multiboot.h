@@ -0,0 +1,58 @@
+// Multiboot (v1) boot information
+#ifndef MULTIBOOT_H
+#define MULTIBOOT_H
+
+#define MULTIBOOT_BOOTLOADER_MAGIC 0x2BADB002
+#define MULTIBOOT_INFO_MEMORY  0x001  // mem_lower/mem_upper valid
+#define MULTIBOOT_INFO_CMDLINE 0x004  // cmdline valid
+#define MULTIBOOT_INFO_MODS    0x008  // mods_count/mods_addr valid
+#define MULTIBOOT_INFO_MEM_MAP 0x040  // mmap_length/mmap_addr valid
+#define MULTIBOOT_MEMORY_AVAILABLE 1
+#define MAX_MEM_REGIONS 16
+
+typedef struct {
+    unsigned int flags;
+    unsigned int mem_lower;   // KiB below 1 MiB
+    unsigned int mem_upper;   // KiB above 1 MiB
+    unsigned int boot_device;
+    unsigned int cmdline;
+    unsigned int mods_count;
+    unsigned int mods_addr;
+    unsigned int syms[4];
+    unsigned int mmap_length;
+    unsigned int mmap_addr;
+} __attribute__((packed)) MultibootInfo;
+
+// size does not include itself; entries are size + 4 bytes apart
+typedef struct {
+    unsigned int size;
+    unsigned long long addr;
+    unsigned long long len;
+    unsigned int type;
+} __attribute__((packed)) MultibootMmapEntry;
+
+typedef struct {
+    unsigned int mod_start;
+    unsigned int mod_end;
+    unsigned int string;
+    unsigned int reserved;
+} __attribute__((packed)) MultibootModule;
+
+// Usable RAM below 4 GiB as reported by the boot loader
+typedef struct {
+    unsigned int base;
+    unsigned int length;
+} MemRegion;
+
+extern MemRegion mem_regions[MAX_MEM_REGIONS];
+extern int mem_region_count;
+extern unsigned int mem_total_kb;          // Sum of usable regions
+extern MultibootInfo* boot_info;           // 0 when not booted by multiboot
+
+int multiboot_init(unsigned int magic, MultibootInfo* mbi);
+int multiboot_cmdline_has(const char* word);
+MultibootModule* multiboot_modules(int* count);
+const void* multiboot_find_module(const char* name, unsigned int* size);
+unsigned int multiboot_reserved_end(unsigned int kernel_end);
+
+#endif
@@ -0,0 +1,205 @@
+#include "paging.h"
+#include "pmm.h"
+#include "console.h"
+#include "klib.h"
+
+unsigned int* kernel_page_dir;    // Kernel page directory
+
+// The kernel directory lives in the image; user directories and page tables
+// come from the frame allocator
+static unsigned int kernel_dir_storage[1024] __attribute__((aligned(PAGE_SIZE)));
+
+// Virtual Memory Management
+void init_paging() {
+    print_string("Initializing paging...", 1, 0);
+    kernel_page_dir = kernel_dir_storage;
+    memset(kernel_page_dir, 0, PAGE_SIZE);
+    for (int i = 0; i < KERNEL_PDES; i++) { // Low memory with 4 MiB pages, supervisor only
+        kernel_page_dir[i] = (i << 22) | PAGE_LARGE | PAGE_WRITE | PAGE_PRESENT;
+    }
+    kernel_page_dir[768] = PAGE_LARGE | PAGE_WRITE | PAGE_PRESENT; // KERNEL_BASE alias of the first 4 MiB
+    asm volatile(
+        "mov %%cr4, %%eax\n\t"
+        "or $0x10, %%eax\n\t"        // PSE
+        "mov %%eax, %%cr4\n\t"
+        "mov %0, %%cr3\n\t"
+        "mov %%cr0, %%eax\n\t"
+        "or $0x80010000, %%eax\n\t"  // PG, and WP so kernel writes honour copy-on-write
+        "mov %%eax, %%cr0"
+        : : "r"(kernel_page_dir) : "eax", "memory"
+    );
+    print_string("Paging enabled", 2, 0);
+}
+
+// Fresh address space: the shared kernel mappings and nothing below
+// USER_STACK_TOP. Returns 0 when out of frames.
+unsigned int* create_user_page_dir() {
+    unsigned int* page_dir = (unsigned int*)frame_alloc();
+    if (!page_dir) return 0;
+    memset(page_dir, 0, PAGE_SIZE);
+    memcpy(page_dir, kernel_page_dir, KERNEL_PDES * sizeof(unsigned int));
+    page_dir[768] = kernel_page_dir[768];
+    return page_dir;
+}
+
+// Release a user address space: its pages, page tables and the directory.
+// Tables still shared with a fork relative only lose a reference, and so
+// does a directory that other threads still run in.
+void free_user_page_dir(unsigned int* page_dir) {
+    if (frame_refcount((unsigned int)page_dir) > 1) {
+        frame_free((unsigned int)page_dir);
+        return;
+    }
+    for (int i = KERNEL_PDES; i < 768; i++) {
+        if (!(page_dir[i] & PAGE_PRESENT) || (page_dir[i] & PAGE_LARGE)) continue;
+        unsigned int* table = (unsigned int*)(page_dir[i] & ~0xFFF);
+        if (frame_refcount((unsigned int)table) > 1) {
+            frame_free((unsigned int)table);
+            continue;
+        }
+        for (int j = 0; j < 1024; j++) {
+            if (table[j] & PAGE_PRESENT) frame_free(table[j] & ~0xFFF);
+        }
+        frame_free((unsigned int)table);
+    }
+    frame_free((unsigned int)page_dir);
+}
+
+// Give page_dir a private copy of a page table it shares after a fork.
+// Every page the table maps gains a sharer, so writable ones become
+// copy-on-write in both copies; shared memory pages stay writable.
+static int unshare_table(unsigned int* page_dir, unsigned int pde) {
+    unsigned int* table = (unsigned int*)(page_dir[pde] & ~0xFFF);
+    if (frame_refcount((unsigned int)table) > 1) {
+        unsigned int* copy = (unsigned int*)frame_alloc();
+        if (!copy) return -1;
+        for (int i = 0; i < 1024; i++) {
+            if (table[i] & PAGE_PRESENT) {
+                if ((table[i] & (PAGE_WRITE | PAGE_SHARED)) == PAGE_WRITE) table[i] = (table[i] & ~PAGE_WRITE) | PAGE_COW;
+                frame_ref(table[i] & ~0xFFF);
+            }
+            copy[i] = table[i];
+        }
+        frame_free((unsigned int)table);
+        table = copy;
+    }
+    page_dir[pde] = (unsigned int)table | PAGE_USER | PAGE_WRITE | PAGE_PRESENT;
+    return 0;
+}
+
+// Map one 4 KiB page, allocating its page table on first use
+int paging_map(unsigned int* page_dir, unsigned int virt, unsigned int phys, unsigned int flags) {
+    unsigned int pde = virt >> 22;
+    if (page_dir[pde] & PAGE_COW) {
+        if (unshare_table(page_dir, pde) < 0) return -1;
+    } else if (!(page_dir[pde] & PAGE_PRESENT)) {
+        unsigned int* table = (unsigned int*)frame_alloc();
+        if (!table) return -1;
+        memset(table, 0, PAGE_SIZE);
+        page_dir[pde] = (unsigned int)table | PAGE_USER | PAGE_WRITE | PAGE_PRESENT;
+    }
+    unsigned int* table = (unsigned int*)(page_dir[pde] & ~0xFFF);
+    table[(virt >> 12) & 0x3FF] = (phys & ~0xFFF) | flags;
+    return 0;
+}
+
+// Page table entry for virt (frame | flags), 0 when unmapped
+unsigned int paging_lookup(unsigned int* page_dir, unsigned int virt) {
+    unsigned int pde = page_dir[virt >> 22];
+    if (!(pde & PAGE_PRESENT)) return 0;
+    if (pde & PAGE_LARGE) return (pde & 0xFFC00000) + (virt & 0x3FF000) + (pde & 0xFFF);
+    return ((unsigned int*)(pde & ~0xFFF))[(virt >> 12) & 0x3FF];
+}
+
+// True when every page of [addr, addr + len) is user-accessible (and
+// writable if write): syscalls check user pointers with this before use.
+// Copy-on-write pages in a range the kernel will write are copied first.
+int paging_user_range(unsigned int* page_dir, unsigned int addr, unsigned int len, int write) {
+    if (addr < USER_BASE || addr > USER_STACK_TOP || len > USER_STACK_TOP - addr) return 0;
+    for (unsigned int page = addr & ~0xFFF; page < addr + len; page += PAGE_SIZE) {
+        unsigned int pte = paging_lookup(page_dir, page);
+        if ((pte & (PAGE_PRESENT | PAGE_USER)) != (PAGE_PRESENT | PAGE_USER)) return 0;
+        if (write && (!(pte & PAGE_WRITE) || (page_dir[page >> 22] & PAGE_COW))) {
+            if (paging_cow_fault(page_dir, page) < 0) return 0;
+        }
+    }
+    return 1;
+}
+
+// True when a NUL-terminated string at addr lies entirely in user pages
+int paging_user_string(unsigned int* page_dir, unsigned int addr) {
+    while (paging_user_range(page_dir, addr, 1, 0)) {
+        const char* p = (const char*)addr;
+        do {
+            if (*p == 0) return 1;
+            p++;
+        } while ((unsigned int)p & 0xFFF);
+        addr = (unsigned int)p;
+    }
+    return 0;
+}
+
+void paging_switch(unsigned int* page_dir) {
+    unsigned int cr3;
+    asm volatile("mov %%cr3, %0" : "=r"(cr3));
+    if (cr3 != (unsigned int)page_dir) {
+        asm volatile("mov %0, %%cr3" : : "r"(page_dir) : "memory");
+    }
+}
+
+void paging_flush() {
+    asm volatile("mov %%cr3, %%eax\n\tmov %%eax, %%cr3" : : : "eax", "memory");
+}
+
+// fork: share the user half of src with dst (a fresh create_user_page_dir).
+// Page tables are shared read-only and refcounted, so the cost depends on
+// the number of directory entries, not on how much memory src maps. The
+// caller flushes the TLB if src is live.
+void paging_clone(unsigned int* dst, unsigned int* src) {
+    for (int i = KERNEL_PDES; i < 768; i++) {
+        if (!(src[i] & PAGE_PRESENT) || (src[i] & PAGE_LARGE)) continue;
+        src[i] = (src[i] & ~PAGE_WRITE) | PAGE_COW;
+        dst[i] = src[i];
+        frame_ref(src[i] & ~0xFFF);
+    }
+}
+
+// Resolve a write to a copy-on-write page: unshare its page table, then
+// copy the page unless this address space is its last user. Returns -1 if
+// addr is not a copy-on-write page or memory ran out.
+int paging_cow_fault(unsigned int* page_dir, unsigned int addr) {
+    if (addr < USER_BASE || addr >= USER_STACK_TOP) return -1;
+    unsigned int pde = addr >> 22;
+    if (!(page_dir[pde] & PAGE_PRESENT)) return -1;
+    if ((page_dir[pde] & PAGE_COW) && unshare_table(page_dir, pde) < 0) return -1;
+    unsigned int* pte = &((unsigned int*)(page_dir[pde] & ~0xFFF))[(addr >> 12) & 0x3FF];
+    int result = 0;
+    if (*pte & PAGE_COW) {
+        unsigned int frame = *pte & ~0xFFF;
+        if (frame_refcount(frame) > 1) {
+            unsigned int copy = frame_alloc();
+            if (!copy) return -1;
+            memcpy((void*)copy, (const void*)frame, PAGE_SIZE);
+            frame_free(frame);
+            frame = copy;
+        }
+        *pte = frame | (*pte & 0xFFF & ~PAGE_COW) | PAGE_WRITE;
+    } else if (!(*pte & PAGE_PRESENT) || !(*pte & PAGE_WRITE)) {
+        result = -1; // Unmapped or really read-only
+    }
+    paging_flush();
+    return result;
+}
+
+// Pages mapped in the user half, shared ones included (/proc/<pid>)
+unsigned int paging_user_pages(unsigned int* page_dir) {
+    unsigned int pages = 0;
+    for (int i = KERNEL_PDES; i < 768; i++) {
+        if (!(page_dir[i] & PAGE_PRESENT) || (page_dir[i] & PAGE_LARGE)) continue;
+        unsigned int* table = (unsigned int*)(page_dir[i] & ~0xFFF);
+        for (int j = 0; j < 1024; j++) {
+            if (table[j] & PAGE_PRESENT) pages++;
+        }
+    }
+    return pages;
+}
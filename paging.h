@@ -0,0 +1,36 @@
+// Virtual Memory Management
+#ifndef PAGING_H
+#define PAGING_H
+
+#define PAGE_SIZE 4096
+#define KERNEL_BASE 0xC0000000
+#define KERNEL_MAP_SIZE 0x4000000            // Low 64 MiB, identity mapped in every directory
+#define KERNEL_PDES (KERNEL_MAP_SIZE >> 22)  // 4 MiB directory entries covering it
+#define USER_BASE 0x40000000                 // User programs link here (user.ld)
+#define USER_STACK_TOP 0xC0000000
+#define USER_STACK_PAGES 4
+
+// Page directory/table entry bits
+#define PAGE_PRESENT 0x001
+#define PAGE_WRITE   0x002
+#define PAGE_USER    0x004
+#define PAGE_LARGE   0x080   // 4 MiB page (directory entries, needs CR4.PSE)
+#define PAGE_COW     0x200   // Available bit: read-only until copied on write
+#define PAGE_SHARED  0x400   // Available bit: shared memory, stays writable across fork
+
+extern unsigned int* kernel_page_dir;    // Kernel page directory
+
+void init_paging(void);
+unsigned int* create_user_page_dir(void);
+void free_user_page_dir(unsigned int* page_dir);
+int paging_map(unsigned int* page_dir, unsigned int virt, unsigned int phys, unsigned int flags);
+unsigned int paging_lookup(unsigned int* page_dir, unsigned int virt);
+int paging_user_range(unsigned int* page_dir, unsigned int addr, unsigned int len, int write);
+int paging_user_string(unsigned int* page_dir, unsigned int addr);
+void paging_switch(unsigned int* page_dir);
+void paging_flush(void);
+void paging_clone(unsigned int* dst, unsigned int* src);
+int paging_cow_fault(unsigned int* page_dir, unsigned int addr);
+unsigned int paging_user_pages(unsigned int* page_dir);
+
+#endif
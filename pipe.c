@@ -0,0 +1,65 @@
+#include "pipe.h"
+#include "sched.h"
+#include "klib.h"
+
+Pipe pipes[MAX_PIPES];
+
+// Allocate a pipe with one reader and one writer. Returns its index or -1.
+int pipe_create() {
+    for (int i = 0; i < MAX_PIPES; i++) {
+        if (!pipes[i].readers && !pipes[i].writers) {
+            pipes[i].head = 0;
+            pipes[i].tail = 0;
+            pipes[i].readers = 1;
+            pipes[i].writers = 1;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Copy out up to len buffered bytes. Returns the count, 0 at end of file
+// (empty and no writers left) or PIPE_AGAIN if a writer may still add data.
+// Never blocks: callers sleep on &pipes[p] and retry.
+int pipe_read(int p, char* buf, int len) {
+    Pipe* pipe = &pipes[p];
+    unsigned int avail = pipe->head - pipe->tail;
+    if (avail == 0) {
+        return pipe->writers ? PIPE_AGAIN : 0;
+    }
+    int n = len < (int)avail ? len : (int)avail;
+    unsigned int at = pipe->tail & (PIPE_SIZE - 1);
+    int first = n < (int)(PIPE_SIZE - at) ? n : (int)(PIPE_SIZE - at);
+    memcpy(buf, pipe->buf + at, first);       // Up to the end of the ring
+    memcpy(buf + first, pipe->buf, n - first); // Then from its start
+    pipe->tail += n;
+    wake_up(pipe); // Writers waiting for room
+    return n;
+}
+
+// Buffer up to len bytes. Returns the count (short when the pipe fills up),
+// PIPE_AGAIN if it is full, or -1 once every read end is closed.
+int pipe_write(int p, const char* buf, int len) {
+    Pipe* pipe = &pipes[p];
+    if (!pipe->readers) return -1;
+    unsigned int room = PIPE_SIZE - (pipe->head - pipe->tail);
+    if (room == 0) return PIPE_AGAIN;
+    int n = len < (int)room ? len : (int)room;
+    unsigned int at = pipe->head & (PIPE_SIZE - 1);
+    int first = n < (int)(PIPE_SIZE - at) ? n : (int)(PIPE_SIZE - at);
+    memcpy(pipe->buf + at, buf, first);
+    memcpy(pipe->buf, buf + first, n - first);
+    pipe->head += n;
+    wake_up(pipe); // Readers waiting for data
+    return n;
+}
+
+// Drop one end; the other side sees end of file or a broken pipe
+void pipe_close(int p, int write_end) {
+    if (write_end) {
+        if (pipes[p].writers > 0) pipes[p].writers--;
+    } else {
+        if (pipes[p].readers > 0) pipes[p].readers--;
+    }
+    wake_up(&pipes[p]);
+}
@@ -0,0 +1,24 @@
+// Anonymous pipes: fixed-size kernel ring buffers behind a read and a write fd
+#ifndef PIPE_H
+#define PIPE_H
+
+#define MAX_PIPES 8
+#define PIPE_SIZE 512     // Power of two: head and tail wrap with a mask
+#define PIPE_AGAIN -2     // Would block: empty with writers left, or full with readers left
+
+typedef struct {
+    char buf[PIPE_SIZE];
+    unsigned int head;    // Bytes ever written
+    unsigned int tail;    // Bytes ever read; head - tail are buffered
+    int readers;          // Open read ends
+    int writers;          // Open write ends
+} Pipe;
+
+extern Pipe pipes[MAX_PIPES];
+
+int pipe_create(void);
+int pipe_read(int p, char* buf, int len);
+int pipe_write(int p, const char* buf, int len);
+void pipe_close(int p, int write_end);
+
+#endif
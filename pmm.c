@@ -0,0 +1,68 @@
+#include "pmm.h"
+#include "multiboot.h"
+
+static unsigned int frame_bitmap[PMM_FRAMES / 32]; // Bit set: frame in use
+static unsigned short frame_refs[PMM_FRAMES];      // Sharers of each allocated frame
+static unsigned int next_word = 0;                 // Allocation search hint
+unsigned int frames_free = 0;
+
+// Free every usable frame from the boot memory map above reserved_end
+// (kernel image, boot modules and multiboot data)
+void init_pmm(unsigned int reserved_end) {
+    for (int i = 0; i < PMM_FRAMES / 32; i++) {
+        frame_bitmap[i] = 0xFFFFFFFF;
+    }
+    frames_free = 0;
+    next_word = 0;
+    reserved_end = (reserved_end + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    for (int r = 0; r < mem_region_count; r++) {
+        unsigned int start = (mem_regions[r].base + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+        unsigned int end = mem_regions[r].base + mem_regions[r].length;
+        if (end < mem_regions[r].base || end > PMM_LIMIT) end = PMM_LIMIT;
+        end &= ~(PAGE_SIZE - 1);
+        if (start < reserved_end) start = reserved_end;
+        for (unsigned int addr = start; addr < end; addr += PAGE_SIZE) {
+            unsigned int frame = addr / PAGE_SIZE;
+            if (frame_bitmap[frame / 32] & (1u << (frame % 32))) {
+                frame_bitmap[frame / 32] &= ~(1u << (frame % 32));
+                frames_free++;
+            }
+        }
+    }
+}
+
+unsigned int frame_alloc() {
+    for (int n = 0; n < PMM_FRAMES / 32; n++) {
+        int w = (next_word + n) % (PMM_FRAMES / 32);
+        unsigned int bits = frame_bitmap[w];
+        if (bits == 0xFFFFFFFF) continue;
+        int bit = 0;
+        while (bits & (1u << bit)) bit++;
+        frame_bitmap[w] |= 1u << bit;
+        frame_refs[w * 32 + bit] = 1;
+        frames_free--;
+        next_word = w;
+        return (w * 32 + bit) * PAGE_SIZE;
+    }
+    return 0;
+}
+
+void frame_free(unsigned int frame) {
+    unsigned int index = frame / PAGE_SIZE;
+    if (index >= PMM_FRAMES || !frame_refs[index]) return;
+    if (--frame_refs[index]) return;
+    if (frame_bitmap[index / 32] & (1u << (index % 32))) {
+        frame_bitmap[index / 32] &= ~(1u << (index % 32));
+        frames_free++;
+    }
+}
+
+void frame_ref(unsigned int frame) {
+    unsigned int index = frame / PAGE_SIZE;
+    if (index < PMM_FRAMES && frame_refs[index]) frame_refs[index]++;
+}
+
+unsigned int frame_refcount(unsigned int frame) {
+    unsigned int index = frame / PAGE_SIZE;
+    return index < PMM_FRAMES ? frame_refs[index] : 0;
+}
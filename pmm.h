@@ -0,0 +1,21 @@
+// Physical frame allocator
+#ifndef PMM_H
+#define PMM_H
+
+#include "paging.h"
+
+// Frames come from the identity-mapped low memory so the kernel can reach
+// every page table and user page directly, whatever cr3 holds
+#define PMM_LIMIT KERNEL_MAP_SIZE
+#define PMM_FRAMES (PMM_LIMIT / PAGE_SIZE)
+
+extern char kernel_end[];          // End of the kernel image and .bss (linker.ld)
+extern unsigned int frames_free;   // Frames currently available
+
+void init_pmm(unsigned int reserved_end);
+unsigned int frame_alloc(void);    // Physical address, 0 when out of memory
+void frame_free(unsigned int frame); // Drops one reference; released at zero
+void frame_ref(unsigned int frame);  // Another page table or directory shares it
+unsigned int frame_refcount(unsigned int frame);
+
+#endif
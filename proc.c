@@ -0,0 +1,229 @@
+#include "proc.h"
+#include "hal.h"
+#include "sched.h"
+#include "paging.h"
+#include "pmm.h"
+#include "gdt.h"
+#include "elf.h"
+#include "vfs.h"
+#include "klib.h"
+#include "cpu.h"
+
+static unsigned char kernel_stacks[MAX_PROCESSES][KSTACK_SIZE] __attribute__((aligned(16)));
+static unsigned int idle_esp;     // kmain's frame while a task runs
+static int sched_running = 0;     // task_switch does nothing before sched_start
+
+// A kernel task whose function returns ends up here
+static void task_return() {
+    unsigned int eflags = irq_save(); // The process table is shared with interrupt handlers
+    kill_process(processes[current_process].pid);
+    irq_restore(eflags);
+    while (1) {
+        asm volatile("hlt");
+    }
+}
+
+// Reset the slot's kernel stack to a single zeroed TrapFrame at its top
+static TrapFrame* initial_frame(int slot) {
+    unsigned int top = (unsigned int)kernel_stacks[slot] + KSTACK_SIZE;
+    TrapFrame* frame = (TrapFrame*)(top - sizeof(TrapFrame));
+    memset(frame, 0, sizeof(TrapFrame));
+    processes[slot].kstack_top = top;
+    processes[slot].esp = (int)frame;
+    return frame;
+}
+
+// The first switch to a task "returns" from an interrupt into its entry point
+void proc_init_context(int slot) {
+    TrapFrame* frame = initial_frame(slot);
+    fpu_reset(slot);
+    if (processes[slot].privilege == 3) return; // proc_spawn_elf fills in the ring 3 frame
+    frame->gs = frame->fs = frame->es = frame->ds = KERNEL_DS;
+    frame->eip = (unsigned int)processes[slot].task;
+    frame->cs = KERNEL_CS;
+    frame->eflags = EFLAGS_IF;
+    frame->user_esp = (unsigned int)task_return; // Ring 0 iret leaves esp here: the return address
+    processes[slot].code_segment = KERNEL_CS;
+}
+
+static int map_user_stack(unsigned int* page_dir) {
+    for (int i = 1; i <= USER_STACK_PAGES; i++) {
+        unsigned int frame = frame_alloc();
+        if (!frame) return -1;
+        memset((void*)frame, 0, PAGE_SIZE);
+        if (paging_map(page_dir, USER_STACK_TOP - i * PAGE_SIZE, frame, PAGE_USER | PAGE_WRITE | PAGE_PRESENT) < 0) {
+            frame_free(frame);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Point a fresh slot's initial frame at ring 3 code
+static void user_frame(Process* p, unsigned int entry, unsigned int esp) {
+    TrapFrame* frame = (TrapFrame*)p->esp;
+    frame->gs = frame->fs = frame->es = frame->ds = USER_DS;
+    frame->eip = entry;
+    frame->cs = USER_CS;
+    frame->eflags = EFLAGS_IF;
+    frame->user_esp = esp;
+    frame->user_ss = USER_DS;
+    p->code_segment = USER_CS;
+}
+
+// Start an ELF32 executable as a ring 3 process in its own address space.
+// Returns the process slot, or -1 if the image is invalid or memory ran out.
+int proc_spawn_elf(const void* image, unsigned int size, int priority) {
+    unsigned int eflags = irq_save(); // Not schedulable until the frame is complete
+    int slot = create_process(0, priority, 3);
+    if (slot < 0) {
+        irq_restore(eflags);
+        return -1;
+    }
+    Process* p = &processes[slot];
+    unsigned int entry;
+    if (elf_load((const unsigned char*)image, size, p->page_dir, &entry) < 0 || map_user_stack(p->page_dir) < 0) {
+        kill_process(p->pid); // Frees the partly built address space
+        irq_restore(eflags);
+        return -1;
+    }
+    user_frame(p, entry, USER_STACK_TOP);
+    irq_restore(eflags);
+    return slot;
+}
+
+// fork: the child resumes from the same syscall with eax = 0 in an address
+// space that shares every page with the parent until one of them writes.
+// Returns the child's pid to the parent, -1 on failure or from ring 0.
+int proc_fork(TrapFrame* frame) {
+    if ((frame->cs & 3) != 3 || current_process == IDLE_PROCESS) return -1;
+    Process* parent = &processes[current_process];
+    int slot = create_process(0, parent->priority, 3);
+    if (slot < 0) return -1;
+    Process* child = &processes[slot];
+    sched_setpolicy(slot, parent->policy);
+    paging_clone(child->page_dir, parent->page_dir);
+    paging_flush(); // The parent's page tables just became read-only
+    fpu_fork(current_process, slot);
+    child->parent = parent->pid;
+    child->user_stack = parent->user_stack;
+    child->code_segment = parent->code_segment;
+    int* files = proc_files(current_process); // A thread forks its process's table
+    for (int i = 0; i < MAX_PROC_FDS; i++) {
+        child->files[i] = vfs_dup(files[i]);
+    }
+    TrapFrame* child_frame = (TrapFrame*)child->esp;
+    *child_frame = *frame;
+    child_frame->regs.eax = 0;
+    return child->pid;
+}
+
+// Start a thread of the calling process: a slot of its own for the
+// scheduler, running entry(arg) in ring 3 on the stack below stack_top, in
+// the caller's address space and with its descriptor table. The entry gets
+// a null return address and must end with SYS_THREAD_EXIT. The creator can
+// wait for the thread like a child. Returns its thread id, or -1.
+int proc_thread_create(TrapFrame* frame, unsigned int entry, unsigned int stack_top, unsigned int arg) {
+    if ((frame->cs & 3) != 3 || current_process == IDLE_PROCESS) return -1;
+    Process* creator = &processes[current_process];
+    if (entry < USER_BASE || entry >= USER_STACK_TOP || stack_top < USER_BASE + 8) return -1;
+    if (!paging_user_range(creator->page_dir, stack_top - 8, 8, 1)) return -1;
+    int slot = create_process(0, creator->priority, 3);
+    if (slot < 0) return -1;
+    Process* t = &processes[slot];
+    sched_setpolicy(slot, creator->policy);
+    free_user_page_dir(t->page_dir);
+    frame_ref((unsigned int)creator->page_dir);
+    t->page_dir = creator->page_dir;
+    t->group = creator->group;
+    t->parent = creator->pid;
+    t->user_stack = stack_top;
+    unsigned int* sp = (unsigned int*)(stack_top - 8); // Same address space: write it directly
+    sp[0] = 0;
+    sp[1] = arg;
+    user_frame(t, entry, stack_top - 8);
+    return t->pid;
+}
+
+// exec: replace the calling process's program. The old address space is
+// kept until the new one is fully built, so a bad image leaves the caller
+// running and gets -1.
+int proc_exec(TrapFrame* frame, const void* image, unsigned int size) {
+    if ((frame->cs & 3) != 3 || current_process == IDLE_PROCESS) return -1;
+    Process* p = &processes[current_process];
+    unsigned int* page_dir = create_user_page_dir();
+    if (!page_dir) return -1;
+    unsigned int entry;
+    if (elf_load((const unsigned char*)image, size, page_dir, &entry) < 0 || map_user_stack(page_dir) < 0) {
+        free_user_page_dir(page_dir);
+        return -1;
+    }
+    exit_threads(current_process, -1); // They were running the old program
+    unsigned int* old = p->page_dir;
+    p->page_dir = page_dir;
+    paging_switch(page_dir);
+    free_user_page_dir(old);
+    fpu_reset(current_process);
+    memset(&frame->regs, 0, sizeof(Registers));
+    frame->eip = entry;
+    frame->user_esp = USER_STACK_TOP;
+    frame->eflags = EFLAGS_IF;
+    return 0;
+}
+
+// Block the running kernel task until wake_up(chan). Call with interrupts
+// disabled, right after finding the condition false, so that no wakeup is
+// lost; they are disabled again on return. Not for the idle task or for
+// interrupt handlers, which have no context of their own to park.
+void proc_sleep(const void* chan) {
+    sleep_on(current_process, chan);
+    while (processes[current_process].state == 3) {
+        asm volatile("sti\n\thlt\n\tcli"); // The next interrupt switches away
+    }
+    processes[current_process].state = 1;
+}
+
+// Hand the CPU to the scheduler; the caller (kmain) becomes the idle task
+void sched_start() {
+    unsigned int eflags = irq_save();
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processes[i].state == 1) sched_ready(i);
+    }
+    current_process = IDLE_PROCESS;
+    sched_running = 1;
+    schedule_flag = 1;
+    irq_restore(eflags);
+}
+
+// Called by the timer, keyboard, syscall and fault stubs with the frame of
+// the interrupted context. Returns the frame to resume: the same one unless
+// a reschedule is pending and schedule() picks another task.
+unsigned int task_switch(unsigned int esp) {
+    if (!sched_running || !schedule_flag) return esp;
+    schedule_flag = 0;
+    int prev = current_process;
+    if (prev == IDLE_PROCESS) {
+        idle_esp = esp;
+    } else {
+        processes[prev].esp = (int)esp;
+    }
+    schedule();
+    int next = current_process;
+    if (next == prev) return esp;
+
+    if (next == IDLE_PROCESS) {
+        paging_switch(kernel_page_dir);
+    } else {
+        tss_set_kernel_stack(processes[next].kstack_top);
+        paging_switch(processes[next].page_dir);
+    }
+    // A task that exited or was killed while running still owned its address
+    // space; cr3 has moved on, so it can go now
+    int dead = prev != IDLE_PROCESS && (processes[prev].state == 2 || processes[prev].state == 4);
+    if (dead && processes[prev].page_dir != kernel_page_dir) {
+        free_user_page_dir(processes[prev].page_dir);
+        processes[prev].page_dir = kernel_page_dir;
+    }
+    fpu_switch(next);
+    return next == IDLE_PROCESS ? idle_esp : (unsigned int)processes[next].esp;
+}
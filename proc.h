@@ -0,0 +1,16 @@
+// Task contexts: kernel stacks, context switch and user programs
+#ifndef PROC_H
+#define PROC_H
+
+#include "hal.h"
+
+#define KSTACK_SIZE 8192
+
+void sched_start(void);
+unsigned int task_switch(unsigned int esp);
+int proc_spawn_elf(const void* image, unsigned int size, int priority);
+int proc_fork(TrapFrame* frame);
+int proc_exec(TrapFrame* frame, const void* image, unsigned int size);
+int proc_thread_create(TrapFrame* frame, unsigned int entry, unsigned int stack_top, unsigned int arg);
+
+#endif
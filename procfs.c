@@ -0,0 +1,206 @@
+#include "procfs.h"
+#include "klib.h"
+#include "sched.h"
+#include "vfs.h"
+#include "pipe.h"
+#include "paging.h"
+#include "pmm.h"
+#include "journal.h"
+#include "cpu.h"
+
+volatile unsigned int irq_counts[IRQ_VECTORS];
+
+// Fixed files, by id: /proc/<name>
+static const char* proc_names[] = { "stat", "interrupts", "meminfo", "vfs", "blocks", "cpuinfo" };
+#define PROC_NAMES (int)(sizeof(proc_names) / sizeof(proc_names[0]))
+
+typedef struct {
+    char* buf;
+    int len;
+    int cap;
+} ProcOut;
+
+static void put(ProcOut* out, const char* s) {
+    while (*s && out->len < out->cap) out->buf[out->len++] = *s++;
+}
+
+static void put_num(ProcOut* out, unsigned int n) {
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+    while (count && out->len < out->cap) out->buf[out->len++] = digits[--count];
+}
+
+// "name value\n", the line format of every procfs file
+static void put_field(ProcOut* out, const char* name, unsigned int value) {
+    put(out, name);
+    put(out, " ");
+    put_num(out, value);
+    put(out, "\n");
+}
+
+// Map the part of a /proc name after the prefix to a file id, -1 if none
+int procfs_lookup(const char* name) {
+    for (int i = 0; i < PROC_NAMES; i++) {
+        if (strcmp(name, proc_names[i]) == 0) return i;
+    }
+    int pid = 0;
+    if (!*name) return -1;
+    for (; *name; name++) {
+        if (*name < '0' || *name > '9' || pid > MAX_PROCESSES) return -1;
+        pid = pid * 10 + (*name - '0');
+    }
+    return pid >= 1 && pid <= MAX_PROCESSES ? PROC_PID_FILES + pid : -1;
+}
+
+static void render_process(ProcOut* out, int pid) {
+    int slot = pid - 1; // pid = slot + 1
+    Process* p = &processes[slot];
+    if (p->pid != pid) return; // Gone: reads as empty
+    int open = 0;
+    int* files = proc_files(slot);
+    for (int i = 0; i < MAX_PROC_FDS; i++) {
+        if (files[i] >= 0) open++;
+    }
+    put_field(out, "pid", p->pid);
+    put_field(out, "group", p->group);
+    put_field(out, "parent", p->parent);
+    put(out, "kind ");
+    put(out, process_kind(slot));
+    put(out, "\nstate ");
+    put(out, process_state_name(p->state));
+    put(out, "\n");
+    put_field(out, "priority", p->priority);
+    put(out, p->policy == SCHED_FAIR ? "policy fair\n" : p->policy == SCHED_EDF ? "policy edf\n" : "policy prio\n");
+    put_field(out, "vruntime_kcycles", (unsigned int)udiv64(p->vruntime, 1000, 0));
+    if (p->policy == SCHED_EDF) {
+        put_field(out, "dl_runtime", p->dl_runtime);
+        put_field(out, "dl_period", p->dl_period);
+        put_field(out, "dl_deadline", p->dl_deadline);
+        put_field(out, "dl_jobs", p->dl_jobs);
+        put_field(out, "dl_misses", p->dl_misses);
+    }
+    put_field(out, "ticks", p->ticks);
+    put_field(out, "slices", p->slices);
+    put_field(out, "voluntary", p->voluntary);
+    put_field(out, "involuntary", p->involuntary);
+    put_field(out, "runtime_kcycles", (unsigned int)udiv64(p->runtime, 1000, 0));
+    put(out, "wait_hist");
+    for (int i = 0; i < WAIT_BUCKETS; i++) {
+        put(out, " ");
+        put_num(out, p->wait_hist[i]);
+    }
+    put(out, "\n");
+    put_field(out, "pages", p->page_dir == kernel_page_dir ? 0 : paging_user_pages(p->page_dir));
+    put_field(out, "fds", open);
+}
+
+// Render file id into buf. Returns its length; an exited process renders
+// as an empty file.
+int procfs_render(int id, char* buf, int cap) {
+    ProcOut out = { buf, 0, cap };
+    if (id == 0) {
+        int tasks = 0;
+        for (int i = 0; i < MAX_PROCESSES; i++) {
+            if (processes[i].pid) tasks++;
+        }
+        put_field(&out, "ticks", sched_ticks);
+        put_field(&out, "idle_ticks", idle_ticks);
+        put_field(&out, "switches", sched_switches);
+        put_field(&out, "tasks", tasks);
+    } else if (id == 1) {
+        for (int v = 0; v < IRQ_VECTORS; v++) {
+            if (!irq_counts[v]) continue;
+            put_num(&out, v); // "<vector> <count>"
+            put(&out, " ");
+            put_num(&out, irq_counts[v]);
+            put(&out, "\n");
+        }
+    } else if (id == 2) {
+        put_field(&out, "frames", PMM_FRAMES);
+        put_field(&out, "frames_free", frames_free);
+        put_field(&out, "page_size", PAGE_SIZE);
+    } else if (id == 3) {
+        int open = 0, pipes_used = 0, compressed = 0, saved = 0;
+        for (int i = 0; i < MAX_FILES; i++) {
+            if (fds[i].used) open++;
+        }
+        for (int i = 0; i < MAX_INODES; i++) {
+            Inode* inode = &vfs.inodes[i];
+            if (!inode->used || inode->type != VFS_FILE || inode->zsize < 0) continue;
+            compressed++;
+            saved += (inode->size + VFS_BLOCK_SIZE - 1) / VFS_BLOCK_SIZE; // Raw blocks less held ones
+            for (int j = 0; j < FILE_BLOCKS; j++) saved -= inode->blocks[j] >= 0;
+        }
+        for (int i = 0; i < MAX_PIPES; i++) {
+            if (pipes[i].readers || pipes[i].writers) pipes_used++;
+        }
+        put_field(&out, "files", vfs.files);
+        put_field(&out, "dirs", vfs.dirs);
+        put_field(&out, "inodes_used", vfs.inodes_used);
+        put_field(&out, "blocks_free", vfs.blocks_free);
+        put_field(&out, "open_fds", open);
+        put_field(&out, "pipes", pipes_used);
+        put_field(&out, "creates", vfs_stats.creates);
+        put_field(&out, "opens", vfs_stats.opens);
+        put_field(&out, "reads", vfs_stats.reads);
+        put_field(&out, "writes", vfs_stats.writes);
+        put_field(&out, "bytes_read", vfs_stats.bytes_read);
+        put_field(&out, "bytes_written", vfs_stats.bytes_written);
+        put_field(&out, "deletes", vfs_stats.deletes);
+        put_field(&out, "dcache_hits", vfs_stats.dcache_hits);
+        put_field(&out, "dcache_misses", vfs_stats.dcache_misses);
+        put_field(&out, "compressed_files", compressed);
+        put_field(&out, "blocks_saved", saved);
+        put_field(&out, "zcache_hits", vfs_stats.zcache_hits);
+        put_field(&out, "zcache_misses", vfs_stats.zcache_misses);
+        put_field(&out, "zcache_writebacks", vfs_stats.zcache_writebacks);
+        put_field(&out, "journal_attached", journal_attached());
+        put_field(&out, "journal_pending", journal_pending());
+        put_field(&out, "journal_commits", journal_stats.commits);
+        put_field(&out, "journal_appends", journal_stats.appends);
+        put_field(&out, "journal_blocks", journal_stats.blocks_written);
+        put_field(&out, "journal_checkpoints", journal_stats.checkpoints);
+        put_field(&out, "journal_replayed", journal_stats.replayed);
+    } else if (id == 4) {
+        for (int i = 0; i < MAX_BLOCK_DEVICES; i++) {
+            BlockDevice* dev = block_device(i);
+            if (!dev) continue;
+            put(&out, dev->name); // "<name> <blocks> <reads> <writes> <sum_errors>"
+            put(&out, " ");
+            put_num(&out, dev->blocks);
+            put(&out, " ");
+            put_num(&out, dev->reads);
+            put(&out, " ");
+            put_num(&out, dev->writes);
+            put(&out, " ");
+            put_num(&out, dev->sum_errors);
+            put(&out, "\n");
+        }
+    } else if (id == 5) {
+        put(&out, "vendor ");
+        put(&out, cpu_info.vendor);
+        put(&out, "\n");
+        put_field(&out, "family", cpu_info.family);
+        put_field(&out, "model", cpu_info.model);
+        put_field(&out, "stepping", cpu_info.stepping);
+        put(&out, "flags");
+        const char* name;
+        for (int i = 0; (name = cpu_feature_name(i)); i++) {
+            put(&out, " ");
+            put(&out, name);
+        }
+        put(&out, "\n");
+        put_field(&out, "sse_enabled", cpu_info.sse_enabled);
+        put_field(&out, "fpu_traps", fpu_stats.traps);
+        put_field(&out, "fpu_saves", fpu_stats.saves);
+        put_field(&out, "fpu_restores", fpu_stats.restores);
+        put_field(&out, "fpu_kernel_uses", fpu_stats.kernel_uses);
+    } else if (id > PROC_PID_FILES && id <= PROC_PID_FILES + MAX_PROCESSES) {
+        render_process(&out, id - PROC_PID_FILES);
+    }
+    return out.len;
+}
@@ -0,0 +1,15 @@
+// Synthetic /proc: files rendered from live kernel counters on every read
+#ifndef PROCFS_H
+#define PROCFS_H
+
+#define PROC_PREFIX "/proc/"
+#define PROC_FILE_MAX 1024     // Largest rendered file
+#define IRQ_VECTORS 256
+#define PROC_PID_FILES 100     // Ids from here on are /proc/<pid>: id - PROC_PID_FILES
+
+extern volatile unsigned int irq_counts[IRQ_VECTORS]; // Interrupts taken, by vector
+
+int procfs_lookup(const char* name);
+int procfs_render(int id, char* buf, int cap);
+
+#endif
@@ -0,0 +1,27 @@
+#include "ramdisk.h"
+#include "klib.h"
+
+static int ramdisk_read(BlockDevice* dev, unsigned int block, void* buf) {
+    memcpy(buf, ((RamDisk*)dev->priv)->mem + block * BLOCK_SIZE, BLOCK_SIZE);
+    return 0;
+}
+
+static int ramdisk_write(BlockDevice* dev, unsigned int block, const void* buf) {
+    memcpy(((RamDisk*)dev->priv)->mem + block * BLOCK_SIZE, buf, BLOCK_SIZE);
+    return 0;
+}
+
+// Set up rd over mem, which it does not clear: a disk image (a boot module)
+// keeps its contents. Callers register rd->dev.
+void ramdisk_init(RamDisk* rd, const char* name, void* mem, unsigned int blocks) {
+    rd->mem = (char*)mem;
+    rd->dev.name = name;
+    rd->dev.blocks = blocks;
+    rd->dev.read = ramdisk_read;
+    rd->dev.write = ramdisk_write;
+    rd->dev.priv = rd;
+    rd->dev.reads = 0;
+    rd->dev.writes = 0;
+    rd->dev.sums = 0;
+    rd->dev.sum_errors = 0;
+}
@@ -0,0 +1,15 @@
+// RAM disk: a block device over a span of memory, for temporary storage and
+// for measuring the file system without device latency
+#ifndef RAMDISK_H
+#define RAMDISK_H
+
+#include "block.h"
+
+typedef struct {
+    BlockDevice dev;
+    char* mem;                // dev.blocks * BLOCK_SIZE bytes
+} RamDisk;
+
+void ramdisk_init(RamDisk* rd, const char* name, void* mem, unsigned int blocks);
+
+#endif
@@ -0,0 +1,520 @@
+#include "sched.h"
+#include "hal.h"
+#include "klib.h"
+#include "paging.h"
+#include "vfs.h"
+
+Process processes[MAX_PROCESSES]; // Array of processes
+volatile int current_process = 0; // Index of currently running process
+volatile int schedule_flag = 0;   // Flag to trigger scheduling
+volatile unsigned int sched_ticks = 0;
+volatile unsigned int idle_ticks = 0;
+volatile unsigned int sched_switches = 0;
+
+// SCHED_FAIR run queue: a binary min-heap of slots keyed on vruntime. A slot
+// that stops being ready stays queued until it reaches the top, where it is
+// dropped; a slot is never queued twice.
+static int fair_heap[MAX_PROCESSES];
+static int fair_pos[MAX_PROCESSES];   // Index in fair_heap, -1 when not queued
+static int fair_count = 0;
+static unsigned long long fair_min_vruntime = 0; // Never decreases; new and woken tasks start here
+
+// Process Management
+void init_processes() {
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        processes[i].pid = 0;
+        processes[i].state = 2;
+        fair_pos[i] = -1;
+    }
+    fair_count = 0;
+    fair_min_vruntime = 0;
+}
+
+int create_process(void (*task)(), int priority, int privilege) {
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (!processes[i].pid) {
+            processes[i].task = task;
+            processes[i].state = 0;
+            processes[i].pid = i + 1;
+            processes[i].group = i + 1;
+            processes[i].priority = priority;
+            processes[i].policy = SCHED_PRIO;
+            processes[i].vruntime = 0;
+            processes[i].dl_jobs = processes[i].dl_misses = 0;
+            processes[i].privilege = privilege;
+            processes[i].parent = 0;
+            processes[i].exit_code = 0;
+            processes[i].wait_chan = 0;
+            processes[i].ticks = 0;
+            processes[i].slices = 0;
+            processes[i].voluntary = 0;
+            processes[i].involuntary = 0;
+            processes[i].runtime = 0;
+            processes[i].run_start = processes[i].ready_since = rdtsc();
+            for (int j = 0; j < WAIT_BUCKETS; j++) {
+                processes[i].wait_hist[j] = 0;
+            }
+            for (int j = 0; j < MAX_PROC_FDS; j++) {
+                processes[i].files[j] = -1;
+            }
+            processes[i].user_stack = privilege == 3 ? USER_STACK_TOP : 0;
+            processes[i].page_dir = privilege == 3 ? create_user_page_dir() : kernel_page_dir;
+            if (!processes[i].page_dir) {
+                processes[i].page_dir = kernel_page_dir;
+                processes[i].state = 2;
+                processes[i].pid = 0;
+                return -1;
+            }
+            proc_init_context(i);
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Killing any thread ends its whole process
+void kill_process(int pid) {
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processes[i].pid == pid && processes[i].state != 4) {
+            exit_group(i, -1);
+            break;
+        }
+    }
+}
+
+// The descriptor table a slot uses: threads share their leader's
+int* proc_files(int slot) {
+    return processes[processes[slot].group - 1].files;
+}
+
+static void release_slot(int slot) {
+    processes[slot].state = 2;
+    processes[slot].pid = 0;
+}
+
+// Terminate one task: a process, or a single thread of one. Its descriptors
+// are closed, so pipe peers see end of file. It stays a zombie holding its pid and exit code until its parent
+// waits for it; orphans are released at once. A parent blocked in wait
+// becomes ready again.
+void exit_process(int slot, int code) {
+    int pid = processes[slot].pid;
+    for (int i = 0; i < MAX_PROC_FDS; i++) {
+        if (processes[slot].files[i] >= 0) {
+            vfs_close_file(processes[slot].files[i]);
+            processes[slot].files[i] = -1;
+        }
+    }
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processes[i].pid && processes[i].parent == pid) {
+            processes[i].parent = 0;
+            if (processes[i].state == 4) release_slot(i);
+        }
+    }
+    processes[slot].exit_code = code;
+    int parent = -1;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processes[slot].parent && processes[i].pid == processes[slot].parent && processes[i].state != 4) parent = i;
+    }
+    if (parent >= 0) {
+        processes[slot].state = 4;
+        wake_up(&processes[parent]); // wait sleeps on its own slot
+    } else {
+        release_slot(slot);
+    }
+    if (slot == current_process) {
+        schedule_flag = 1; // Address space is freed once we switch away
+    } else if (processes[slot].page_dir != kernel_page_dir) {
+        free_user_page_dir(processes[slot].page_dir);
+        processes[slot].page_dir = kernel_page_dir;
+    }
+}
+
+// End every other live thread of slot's process, e.g. before exec
+void exit_threads(int slot, int code) {
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (i != slot && processes[i].pid && processes[i].state != 4 && processes[i].group == processes[slot].group) {
+            exit_process(i, code);
+        }
+    }
+}
+
+// exit: the whole process goes, its threads first, so the leader's exit
+// code is the one its parent collects
+void exit_group(int slot, int code) {
+    exit_threads(slot, code);
+    exit_process(slot, code);
+}
+
+// wait: collect an exited child (pid, or any child for -1). Returns its pid
+// and stores its exit code; 0 if matching children are all still running;
+// -1 if there is no such child.
+int reap_child(int slot, int pid, int* code) {
+    int found = 0;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (!processes[i].pid || processes[i].parent != processes[slot].pid) continue;
+        if (pid != -1 && processes[i].pid != pid) continue;
+        if (processes[i].state == 4) {
+            int child = processes[i].pid;
+            *code = processes[i].exit_code;
+            release_slot(i);
+            return child;
+        }
+        found = 1;
+    }
+    return found ? 0 : -1;
+}
+
+// Block a process until wake_up(chan). Whoever blocks re-checks its
+// condition after waking: a wakeup only means it may have changed.
+void sleep_on(int slot, const void* chan) {
+    processes[slot].state = 3;
+    processes[slot].wait_chan = chan;
+    schedule_flag = 1;
+}
+
+void wake_up(const void* chan) {
+    wake_up_nr(chan, MAX_PROCESSES);
+}
+
+// Wake at most nr sleepers on chan, lowest slot first. Returns how many woke.
+int wake_up_nr(const void* chan, int nr) {
+    int woken = 0;
+    for (int i = 0; i < MAX_PROCESSES && woken < nr; i++) {
+        if (processes[i].state == 3 && processes[i].wait_chan == chan) {
+            processes[i].wait_chan = 0;
+            sched_ready(i);
+            woken++;
+        }
+    }
+    return woken;
+}
+
+// Give a VFS fd the lowest free descriptor of a process. Returns the
+// descriptor; if the table is full the fd is closed and -1 returned.
+int fd_install(int slot, int file) {
+    if (file < 0) return -1;
+    int* files = proc_files(slot);
+    for (int i = 0; i < MAX_PROC_FDS; i++) {
+        if (files[i] < 0) {
+            files[i] = file;
+            return i;
+        }
+    }
+    vfs_close_file(file);
+    return -1;
+}
+
+const char* process_state_name(int state) {
+    static const char* names[] = { "Ready", "Running", "Terminated", "Blocked", "Zombie" };
+    return state >= 0 && state <= 4 ? names[state] : "?";
+}
+
+const char* process_kind(int slot) {
+    if (processes[slot].privilege == 0) return "kernel";
+    return processes[slot].group == processes[slot].pid ? "user" : "thread";
+}
+
+// Weight of a SCHED_FAIR task by priority 1-10: 1024 at 5, 1.25x per step
+static const unsigned int fair_weights[] = { 419, 524, 655, 819, 1024, 1280, 1600, 2000, 2500, 3125 };
+
+// Virtual runtime for running cycles at a priority: heavier tasks age slower
+unsigned long long fair_delta(unsigned long long cycles, int priority) {
+    if (priority < 1) priority = 1;
+    if (priority > 10) priority = 10;
+    return udiv64(cycles * 1024, fair_weights[priority - 1], 0);
+}
+
+static int fair_less(int a, int b) {
+    if (processes[a].vruntime != processes[b].vruntime) return processes[a].vruntime < processes[b].vruntime;
+    return a < b;
+}
+
+static void fair_swap(int i, int j) {
+    int t = fair_heap[i];
+    fair_heap[i] = fair_heap[j];
+    fair_heap[j] = t;
+    fair_pos[fair_heap[i]] = i;
+    fair_pos[fair_heap[j]] = j;
+}
+
+static void fair_sift(int i) {
+    while (i > 0 && fair_less(fair_heap[i], fair_heap[(i - 1) / 2])) {
+        fair_swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    while (1) {
+        int least = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < fair_count && fair_less(fair_heap[l], fair_heap[least])) least = l;
+        if (r < fair_count && fair_less(fair_heap[r], fair_heap[least])) least = r;
+        if (least == i) break;
+        fair_swap(i, least);
+        i = least;
+    }
+}
+
+// Queue a slot, or move it to match a changed vruntime if already queued
+static void fair_push(int slot) {
+    if (fair_pos[slot] < 0) {
+        fair_pos[slot] = fair_count;
+        fair_heap[fair_count++] = slot;
+    }
+    fair_sift(fair_pos[slot]);
+}
+
+static void fair_pop() {
+    fair_pos[fair_heap[0]] = -1;
+    if (--fair_count > 0) {
+        fair_heap[0] = fair_heap[fair_count];
+        fair_pos[fair_heap[0]] = 0;
+        fair_sift(0);
+    }
+}
+
+// The ready SCHED_FAIR task with the least vruntime, -1 if none
+static int fair_first() {
+    while (fair_count) {
+        Process* p = &processes[fair_heap[0]];
+        if (p->state == 0 && p->policy == SCHED_FAIR) return fair_heap[0];
+        fair_pop(); // Blocked, exited or moved to another policy since queued
+    }
+    return -1;
+}
+
+// Make a slot ready to run. A SCHED_FAIR task is queued no earlier than
+// fair_min_vruntime, so sleeping earns it no credit over running tasks.
+void sched_ready(int slot) {
+    Process* p = &processes[slot];
+    p->state = 0;
+    p->ready_since = rdtsc();
+    if (p->policy == SCHED_FAIR) {
+        if (p->vruntime < fair_min_vruntime) p->vruntime = fair_min_vruntime;
+        fair_push(slot);
+    }
+}
+
+// Move a task to another scheduling policy. Returns 0, or -1 if the slot or
+// policy is invalid; SCHED_EDF needs its parameters, from sched_setedf.
+int sched_setpolicy(int slot, int policy) {
+    if (slot < 0 || slot >= MAX_PROCESSES || !processes[slot].pid) return -1;
+    if (policy != SCHED_PRIO && policy != SCHED_FAIR) return -1;
+    Process* p = &processes[slot];
+    if (p->policy == policy) return 0;
+    if (p->policy == SCHED_EDF && p->state == 3 && p->wait_chan == &p->dl_release) {
+        p->wait_chan = 0; // Throttled or between jobs: no release will come now
+        p->policy = policy;
+        sched_ready(slot);
+        return 0;
+    }
+    p->policy = policy;
+    if (policy == SCHED_FAIR) {
+        p->vruntime = fair_min_vruntime;
+        if (p->state == 0) fair_push(slot);
+    }
+    return 0;
+}
+
+// SCHED_EDF admission: the summed density (runtime / deadline) of all EDF
+// tasks stays within EDF_UTIL_MAX, enough for EDF to meet every deadline and
+// leaving the rest of the CPU to the other classes
+static unsigned int edf_density(int skip) {
+    unsigned int total = 0;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        Process* p = &processes[i];
+        if (i != skip && p->pid && p->policy == SCHED_EDF) total += p->dl_runtime * 1024 / p->dl_deadline;
+    }
+    return total;
+}
+
+// Make a task periodic: runtime ticks of CPU each period, every job due
+// deadline ticks after its release. The first job is released at once.
+// Returns 0, or -1 if the parameters are invalid or would not be admitted.
+int sched_setedf(int slot, unsigned int runtime, unsigned int period, unsigned int deadline) {
+    if (slot < 0 || slot >= MAX_PROCESSES || !processes[slot].pid) return -1;
+    if (!runtime || runtime > deadline || deadline > period || period > 3600 * TIMER_HZ) return -1;
+    if (edf_density(slot) + runtime * 1024 / deadline > EDF_UTIL_MAX) return -1;
+    Process* p = &processes[slot];
+    p->policy = SCHED_EDF;
+    p->dl_runtime = runtime;
+    p->dl_period = period;
+    p->dl_deadline = deadline;
+    p->dl_budget = runtime;
+    p->dl_abs = sched_ticks + deadline;
+    p->dl_release = sched_ticks + period;
+    p->dl_done = p->dl_missed = 0;
+    p->dl_jobs = 1;
+    p->dl_misses = 0;
+    return 0;
+}
+
+// The current job of an EDF task is finished. Returns the channel to sleep
+// on until its next release.
+const void* edf_job_done(int slot) {
+    processes[slot].dl_done = 1;
+    return &processes[slot].dl_release;
+}
+
+// Timer tick for SCHED_EDF: charge the running task's budget, throttling it
+// once spent, then count missed deadlines and release due jobs
+static void edf_tick() {
+    if (current_process != IDLE_PROCESS && processes[current_process].policy == SCHED_EDF) {
+        Process* p = &processes[current_process];
+        if (p->dl_budget) p->dl_budget--;
+        if (!p->dl_budget && !p->dl_done && p->state == 1) {
+            p->state = 3; // Sleeps on dl_release like a finished job
+            p->wait_chan = &p->dl_release;
+            schedule_flag = 1;
+        }
+    }
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        Process* p = &processes[i];
+        if (!p->pid || p->policy != SCHED_EDF) continue;
+        if (!p->dl_done && !p->dl_missed && (int)(sched_ticks - p->dl_abs) >= 0) {
+            p->dl_missed = 1;
+            p->dl_misses++;
+        }
+        if ((int)(sched_ticks - p->dl_release) < 0) continue;
+        // An unfinished job carries on under the new budget and deadline
+        p->dl_jobs++;
+        p->dl_done = p->dl_missed = 0;
+        p->dl_budget = p->dl_runtime;
+        p->dl_abs = p->dl_release + p->dl_deadline;
+        p->dl_release += p->dl_period;
+        if (p->state == 3 && p->wait_chan == &p->dl_release) {
+            p->wait_chan = 0;
+            sched_ready(i);
+            schedule_flag = 1;
+        }
+    }
+}
+
+// CPU accounting, at each switch: the outgoing task is charged its
+// timeslice, the incoming one has its time spent ready recorded
+static void charge(int slot, unsigned long long now) {
+    Process* p = &processes[slot];
+    p->runtime += now - p->run_start;
+    if (p->policy == SCHED_FAIR) p->vruntime += fair_delta(now - p->run_start, p->priority);
+    p->run_start = now;
+}
+
+static void switch_out(int slot, unsigned long long now) {
+    Process* p = &processes[slot];
+    charge(slot, now);
+    if (p->state == 1) {
+        sched_ready(slot); // Preempted; killed tasks stay terminated
+        p->involuntary++;
+    } else {
+        p->voluntary++;
+    }
+}
+
+static void switch_in(int slot, unsigned long long now) {
+    Process* p = &processes[slot];
+    p->state = 1;
+    p->run_start = now;
+    p->slices++;
+    p->wait_hist[wait_bucket(now - p->ready_since)]++;
+    if (p->policy == SCHED_FAIR && p->vruntime > fair_min_vruntime) fair_min_vruntime = p->vruntime;
+    sched_switches++;
+}
+
+// Histogram bucket of a wait: 0 below 2^WAIT_BUCKET_SHIFT cycles, each
+// further bucket 4x wider, the last one open ended
+int wait_bucket(unsigned long long cycles) {
+    int bucket = 0;
+    cycles >>= WAIT_BUCKET_SHIFT;
+    while (cycles && bucket < WAIT_BUCKETS - 1) {
+        cycles >>= 2;
+        bucket++;
+    }
+    return bucket;
+}
+
+// SCHED_EDF: the earliest absolute deadline, the running task included
+static int pick_edf() {
+    int next = -1;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        Process* p = &processes[i];
+        if (p->policy != SCHED_EDF) continue;
+        if (p->state != 0 && !(i == current_process && p->state == 1)) continue;
+        if (next == -1 || (int)(p->dl_abs - processes[next].dl_abs) < 0) next = i;
+    }
+    return next;
+}
+
+// SCHED_PRIO: the best other ready task, else the running one keeps the CPU
+static int pick_prio() {
+    int next = -1;
+    int max_priority = -1;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processes[i].state == 0 && processes[i].policy == SCHED_PRIO && processes[i].priority > max_priority) {
+            max_priority = processes[i].priority;
+            next = i;
+        }
+    }
+    if (next == -1 && current_process != IDLE_PROCESS && processes[current_process].state == 1 &&
+        processes[current_process].policy == SCHED_PRIO) {
+        next = current_process;
+    }
+    return next;
+}
+
+// SCHED_FAIR: the least vruntime, the running task included once charged
+static int pick_fair(unsigned long long now) {
+    int next = fair_first();
+    if (current_process != IDLE_PROCESS && processes[current_process].state == 1 &&
+        processes[current_process].policy == SCHED_FAIR) {
+        charge(current_process, now);
+        if (next == -1 || !fair_less(next, current_process)) return current_process;
+    }
+    if (next != -1) fair_pop();
+    return next;
+}
+
+// Classes in order: deadline tasks, strict priority tasks, then fair tasks
+// share what is left
+void schedule() {
+    unsigned long long now = rdtsc();
+    int next = pick_edf();
+    if (next == -1) next = pick_prio();
+    if (next == -1) next = pick_fair(now);
+    if (next != -1 && next != current_process) {
+        if (current_process != IDLE_PROCESS) switch_out(current_process, now);
+        current_process = next;
+        switch_in(next, now);
+    } else if (next == -1 && current_process != IDLE_PROCESS && processes[current_process].state != 1) {
+        switch_out(current_process, now);
+        current_process = IDLE_PROCESS; // Nothing runnable: back to the idle loop
+    }
+}
+
+// Save and put back the scheduler state; call both with interrupts off
+void sched_snapshot(SchedSnapshot* s) {
+    memcpy(s->processes, processes, sizeof(processes));
+    s->current_process = current_process;
+    s->sched_switches = sched_switches;
+    memcpy(s->fair_heap, fair_heap, sizeof(fair_heap));
+    memcpy(s->fair_pos, fair_pos, sizeof(fair_pos));
+    s->fair_count = fair_count;
+    s->fair_min_vruntime = fair_min_vruntime;
+}
+
+void sched_restore(const SchedSnapshot* s) {
+    memcpy(processes, s->processes, sizeof(processes));
+    current_process = s->current_process;
+    sched_switches = s->sched_switches;
+    memcpy(fair_heap, s->fair_heap, sizeof(fair_heap));
+    memcpy(fair_pos, s->fair_pos, sizeof(fair_pos));
+    fair_count = s->fair_count;
+    fair_min_vruntime = s->fair_min_vruntime;
+}
+
+// Timer interrupt: charge the tick to whoever it interrupted
+void sched_tick() {
+    sched_ticks++;
+    if (current_process == IDLE_PROCESS) {
+        idle_ticks++;
+    } else {
+        processes[current_process].ticks++;
+    }
+    edf_tick();
+}
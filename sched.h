@@ -0,0 +1,106 @@
+// Process Management
+#ifndef SCHED_H
+#define SCHED_H
+
+#include "syscall.h"
+
+#define MAX_PROCESSES 16
+#define IDLE_PROCESS -1   // current_process while kmain's idle loop runs
+#define MAX_PROC_FDS 8    // Per-process descriptors, each naming an entry of the VFS fds table
+#define WAIT_BUCKETS 8    // Wait-time histogram: under 2^16 cycles, then 4x wider each, last open
+#define WAIT_BUCKET_SHIFT 16
+#define TIMER_HZ 1000     // PIT rate; SCHED_EDF parameters are in these ticks
+#define EDF_UTIL_MAX 921  // Admission limit on summed runtime/deadline, of 1024
+
+// Process structure for task management
+typedef struct {
+    void (*task)();           // Task function pointer
+    int state;                // 0: ready, 1: running, 2: terminated, 3: blocked, 4: zombie
+    int esp;                  // Saved kernel stack pointer (TrapFrame*)
+    int pid;                  // Process ID (slot + 1); a thread's pid is its thread id
+    int group;                // pid of the thread group leader, == pid for a process
+    int priority;             // Process priority (1-10); the weight of a SCHED_FAIR task
+    int policy;               // SCHED_PRIO or SCHED_FAIR (syscall.h)
+    unsigned int user_stack;  // User stack address
+    unsigned int code_segment;// Code segment
+    int privilege;            // 0: kernel, 3: user
+    unsigned int* page_dir;   // Page directory address
+    unsigned int kstack_top;  // Kernel stack for traps from this task (TSS esp0)
+    int parent;               // Parent pid, 0 when none
+    int exit_code;            // Reported to the parent by wait
+    const void* wait_chan;    // What a blocked process sleeps on (wake_up)
+    int files[MAX_PROC_FDS];  // Open descriptors: VFS fd or -1 (used in group leaders only)
+    unsigned int ticks;       // Timer ticks taken while running
+    unsigned int slices;      // Timeslices: times the scheduler switched to it
+    unsigned int voluntary;   // Switched away after blocking or exiting
+    unsigned int involuntary; // Switched away while still runnable (preempted)
+    unsigned long long runtime;     // TSC cycles spent running
+    unsigned long long run_start;   // TSC when its current timeslice began
+    unsigned long long ready_since; // TSC when it last became ready
+    unsigned int wait_hist[WAIT_BUCKETS]; // Ready-to-running delays, by wait_bucket()
+    unsigned long long vruntime;    // SCHED_FAIR: runtime scaled by fair_delta()
+    unsigned int dl_runtime;  // SCHED_EDF, in ticks: budget of each job
+    unsigned int dl_period;   // Interval between job releases
+    unsigned int dl_deadline; // Relative deadline of a job, <= period
+    unsigned int dl_budget;   // Budget left to the current job
+    unsigned int dl_abs;      // Absolute deadline of the current job (sched_ticks)
+    unsigned int dl_release;  // When the next job is released
+    int dl_done;              // Current job finished (edf_job_done)
+    int dl_missed;            // Current job already counted as missed
+    unsigned int dl_jobs;     // Jobs released
+    unsigned int dl_misses;   // Jobs not finished by their deadline
+} Process;
+
+// Everything schedule() changes, for callers that run it on trial (bench.c)
+typedef struct {
+    Process processes[MAX_PROCESSES];
+    int current_process;
+    unsigned int sched_switches;
+    int fair_heap[MAX_PROCESSES];
+    int fair_pos[MAX_PROCESSES];
+    int fair_count;
+    unsigned long long fair_min_vruntime;
+} SchedSnapshot;
+
+extern Process processes[MAX_PROCESSES]; // Array of processes
+extern volatile int current_process;     // Index of currently running process
+extern volatile int schedule_flag;       // Flag to trigger scheduling
+extern volatile unsigned int sched_ticks;    // Timer ticks since boot
+extern volatile unsigned int idle_ticks;     // Ticks that found the idle loop running
+extern volatile unsigned int sched_switches; // Context switches between tasks
+
+void init_processes(void);
+int create_process(void (*task)(), int priority, int privilege);
+void kill_process(int pid);
+void exit_process(int slot, int code);
+void exit_threads(int slot, int code);
+void exit_group(int slot, int code);
+int* proc_files(int slot);
+int reap_child(int slot, int pid, int* code);
+void sleep_on(int slot, const void* chan);
+void wake_up(const void* chan);
+int wake_up_nr(const void* chan, int nr);
+int fd_install(int slot, int file);
+void schedule(void);
+const char* process_state_name(int state);
+const char* process_kind(int slot);
+void sched_tick(void);
+int wait_bucket(unsigned long long cycles);
+void sched_ready(int slot);
+int sched_setpolicy(int slot, int policy);
+unsigned long long fair_delta(unsigned long long cycles, int priority);
+int sched_setedf(int slot, unsigned int runtime, unsigned int period, unsigned int deadline);
+const void* edf_job_done(int slot);
+void sched_snapshot(SchedSnapshot* s);
+void sched_restore(const SchedSnapshot* s);
+
+// Build the initial kernel stack of a new slot: proc.c in the kernel, a stub
+// in hal_host.c. Privilege 3 slots start with an empty address space and get
+// their program from proc_spawn_elf.
+void proc_init_context(int slot);
+
+// Park the running task until wake_up(chan); called with interrupts off.
+// proc.c in the kernel; the host stub only marks the task blocked.
+void proc_sleep(const void* chan);
+
+#endif
@@ -0,0 +1,42 @@
+#include "serial.h"
+#include "hal.h"
+#include "klib.h"
+
+// Serial Port (COM1, 38400 8N1)
+void init_serial() {
+    outb(COM1_PORT + 1, 0x00); // Disable UART interrupts
+    outb(COM1_PORT + 3, 0x80); // DLAB on
+    outb(COM1_PORT + 0, 0x03); // Divisor 3 (38400 baud)
+    outb(COM1_PORT + 1, 0x00);
+    outb(COM1_PORT + 3, 0x03); // 8 bits, no parity, one stop bit
+    outb(COM1_PORT + 2, 0xC7); // Enable and clear FIFOs
+    outb(COM1_PORT + 4, 0x0B); // DTR, RTS, OUT2
+}
+
+void serial_putc(char c) {
+    while (!(inb(COM1_PORT + 5) & 0x20));
+    outb(COM1_PORT, c);
+}
+
+void serial_write(const char* str) {
+    while (*str) {
+        if (*str == '\n') serial_putc('\r');
+        serial_putc(*str++);
+    }
+}
+
+void serial_write_u64(unsigned long long value) {
+    char buf[24];
+    int i = 0;
+    unsigned int digit;
+    do {
+        value = udiv64(value, 10, &digit);
+        buf[i++] = '0' + digit;
+    } while (value);
+    while (i > 0) serial_putc(buf[--i]);
+}
+
+// Exit QEMU through isa-debug-exit; QEMU's status becomes (code << 1) | 1
+void qemu_exit(int code) {
+    outl(QEMU_EXIT_PORT, code);
+}
@@ -0,0 +1,14 @@
+// Serial Port (COM1) and QEMU debug exit
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#define COM1_PORT 0x3F8
+#define QEMU_EXIT_PORT 0xF4     // -device isa-debug-exit,iobase=0xf4,iosize=0x04
+
+void init_serial(void);
+void serial_putc(char c);
+void serial_write(const char* str);
+void serial_write_u64(unsigned long long value);
+void qemu_exit(int code);
+
+#endif
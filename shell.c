@@ -0,0 +1,140 @@
+#include "shell.h"
+#include "klib.h"
+
+// Registered commands, chained by name hash through next
+static const ShellCommand* commands[SHELL_COMMANDS];
+static int next[SHELL_COMMANDS];
+static int heads[SHELL_HASH_SIZE];
+static int count;
+
+// History ring: line n of all ever added sits in slot n % SHELL_HISTORY
+static char history[SHELL_HISTORY][SHELL_LINE_MAX];
+static unsigned int history_total;
+
+static unsigned int name_hash(const char* name) {
+    unsigned int h = 2166136261u; // FNV-1a
+    while (*name) h = (h ^ (unsigned char)*name++) * 16777619u;
+    return h & (SHELL_HASH_SIZE - 1);
+}
+
+void shell_init() {
+    count = 0;
+    memset(heads, 0xFF, sizeof(heads));
+    history_total = 0;
+}
+
+// Add a command; the table keeps the pointer. Returns -1 when the table is
+// full or the name is taken.
+int shell_register(const ShellCommand* cmd) {
+    if (count == SHELL_COMMANDS || shell_find(cmd->name)) return -1;
+    unsigned int h = name_hash(cmd->name);
+    commands[count] = cmd;
+    next[count] = heads[h];
+    heads[h] = count++;
+    return 0;
+}
+
+const ShellCommand* shell_find(const char* name) {
+    for (int i = heads[name_hash(name)]; i >= 0; i = next[i]) {
+        if (strcmp(commands[i]->name, name) == 0) return commands[i];
+    }
+    return 0;
+}
+
+// The index'th command in registration order, 0 past the last
+const ShellCommand* shell_command(int index) {
+    return index >= 0 && index < count ? commands[index] : 0;
+}
+
+// Split line in place into at most max arguments. Returns argc, or -1 for
+// more arguments than fit or an unterminated quote.
+int shell_parse(char* line, char** argv, int max) {
+    int argc = 0;
+    char* out = line;
+    while (1) {
+        while (*line == ' ') line++;
+        if (!*line) break;
+        if (argc == max) return -1;
+        argv[argc++] = out;
+        int quoted = 0;
+        for (; *line && (quoted || *line != ' '); line++) {
+            if (*line == '"') {
+                quoted = !quoted;
+            } else {
+                *out++ = *line;
+            }
+        }
+        if (quoted) return -1;
+        if (*line) line++;
+        *out++ = 0; // Never past line: the closing quote or space made room
+    }
+    return argc;
+}
+
+// History
+// Add a line, unless it is empty or repeats the newest one. Longer lines
+// are cut to SHELL_LINE_MAX - 1 characters.
+void shell_history_add(const char* line) {
+    if (!line[0] || (history_total && strcmp(shell_history(0), line) == 0)) return;
+    char* slot = history[history_total++ % SHELL_HISTORY];
+    int n = 0;
+    while (line[n] && n < SHELL_LINE_MAX - 1) {
+        slot[n] = line[n];
+        n++;
+    }
+    slot[n] = 0;
+}
+
+// The line added back + 1 lines ago (0: the newest), 0 past the oldest kept
+const char* shell_history(int back) {
+    if (back < 0 || back >= shell_history_count()) return 0;
+    return history[(history_total - 1 - back) % SHELL_HISTORY];
+}
+
+int shell_history_count() {
+    return history_total < SHELL_HISTORY ? (int)history_total : SHELL_HISTORY;
+}
+
+// Lines added since shell_init: changes whenever the ring does
+unsigned int shell_history_total() {
+    return history_total;
+}
+
+// The kept lines, oldest first, each ended by '\n'. Returns the length;
+// the oldest lines are left out if cap is too small for all of them.
+int shell_history_save(char* buf, int cap) {
+    int back = shell_history_count() - 1, len = 0;
+    for (int need = 0; back >= 0; back--, need = 0) { // Skip what cannot fit
+        for (int i = back; i >= 0; i--) need += strlen(shell_history(i)) + 1;
+        if (need <= cap) break;
+    }
+    for (; back >= 0; back--) {
+        const char* line = shell_history(back);
+        int n = strlen(line);
+        memcpy(buf + len, line, n);
+        len += n;
+        buf[len++] = '\n';
+    }
+    return len;
+}
+
+// Add the lines of buf (as shell_history_save writes them) as older than
+// the ones already kept
+void shell_history_load(const char* buf, int len) {
+    static char newer[SHELL_HISTORY][SHELL_LINE_MAX];
+    int kept = shell_history_count();
+    for (int i = 0; i < kept; i++) custom_strcpy(newer[i], shell_history(kept - 1 - i));
+    history_total = 0;
+    char line[SHELL_LINE_MAX];
+    int n = 0;
+    for (int i = 0; i < len; i++) {
+        if (buf[i] != '\n') {
+            if (n < SHELL_LINE_MAX - 1) line[n++] = buf[i];
+            continue;
+        }
+        line[n] = 0;
+        shell_history_add(line);
+        n = 0;
+    }
+    for (int i = 0; i < kept; i++) shell_history_add(newer[i]);
+}
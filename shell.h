@@ -0,0 +1,41 @@
+// Shell command table and argument parsing
+// Commands register by name into a fixed table hashed on the name, so a
+// lookup is one hash and a short chain walk however many are registered.
+// A line splits into argv at spaces; "double quotes" keep spaces in one
+// argument. Lines run are kept in a history ring for recall.
+#ifndef SHELL_H
+#define SHELL_H
+
+#define SHELL_COMMANDS 32         // Registered commands
+#define SHELL_HASH_SIZE 64        // Name hash chains (power of two)
+#define SHELL_ARGS 8              // argv entries, the command name included
+#define SHELL_LINE_MAX 80         // Longest line, terminator included
+#define SHELL_HISTORY 32          // Lines the history ring keeps
+
+// Command flags
+#define SHELL_INLINE 1            // Runs in the keyboard interrupt: it takes over
+                                  // the keyboard or the screen
+
+typedef struct {
+    const char* name;
+    void (*fn)(int argc, char** argv);
+    int min_args;                 // Arguments required after the name
+    int flags;
+    const char* usage;            // Shown when fewer than min_args are given
+} ShellCommand;
+
+void shell_init(void);
+int shell_register(const ShellCommand* cmd);
+const ShellCommand* shell_find(const char* name);
+const ShellCommand* shell_command(int index);
+int shell_parse(char* line, char** argv, int max);
+
+// History: a ring of the last SHELL_HISTORY lines, oldest overwritten
+void shell_history_add(const char* line);
+const char* shell_history(int back);
+int shell_history_count(void);
+unsigned int shell_history_total(void);
+int shell_history_save(char* buf, int cap);
+void shell_history_load(const char* buf, int len);
+
+#endif
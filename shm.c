@@ -0,0 +1,78 @@
+#include "shm.h"
+#include "paging.h"
+#include "pmm.h"
+#include "klib.h"
+
+ShmRegion shm_regions[MAX_SHM];
+
+static void shm_release(ShmRegion* r) {
+    for (int i = 0; i < r->pages; i++) {
+        frame_free(r->frames[i]);
+    }
+    r->used = 0;
+}
+
+// A region is done once it has been mapped and every address space that
+// mapped it is gone: only the region's own references are left
+static int shm_idle(ShmRegion* r) {
+    if (!r->mapped) return 0;
+    for (int i = 0; i < r->pages; i++) {
+        if (frame_refcount(r->frames[i]) > 1) return 0;
+    }
+    return 1;
+}
+
+// Open the region named key, creating it with size bytes of zeroed memory
+// if it does not exist. Returns its id, or -1 if size is 0 or too large
+// for the region, or no slots or frames are left.
+int shm_create(unsigned int key, unsigned int size) {
+    int pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    if (pages == 0 || pages > SHM_MAX_PAGES) return -1;
+    for (int i = 0; i < MAX_SHM; i++) {
+        ShmRegion* r = &shm_regions[i];
+        if (r->used && shm_idle(r)) shm_release(r);
+        if (r->used && r->key == key) return pages <= r->pages ? i : -1;
+    }
+    for (int i = 0; i < MAX_SHM; i++) {
+        ShmRegion* r = &shm_regions[i];
+        if (r->used) continue;
+        r->pages = 0;
+        while (r->pages < pages) {
+            unsigned int frame = frame_alloc();
+            if (!frame) {
+                shm_release(r);
+                return -1;
+            }
+            memset((void*)frame, 0, PAGE_SIZE);
+            r->frames[r->pages++] = frame;
+        }
+        r->used = 1;
+        r->key = key;
+        r->mapped = 0;
+        return i;
+    }
+    return -1;
+}
+
+// Map region id into a user address space at its fixed address, which is
+// the same in every process, so pointers inside the region stay valid.
+// The pages are writable and stay shared across fork (PAGE_SHARED) instead
+// of becoming copy-on-write. Returns the address, or 0 on failure.
+unsigned int shm_map(unsigned int* page_dir, int id) {
+    if (id < 0 || id >= MAX_SHM || !shm_regions[id].used) return 0;
+    ShmRegion* r = &shm_regions[id];
+    unsigned int base = SHM_BASE + id * SHM_REGION_SPAN;
+    for (int i = 0; i < r->pages; i++) {
+        unsigned int virt = base + i * PAGE_SIZE;
+        unsigned int pte = paging_lookup(page_dir, virt);
+        if (pte & PAGE_PRESENT) {
+            if ((pte & ~0xFFF) != r->frames[i]) return 0; // Something else lives there
+            continue;                                     // Mapped already
+        }
+        if (paging_map(page_dir, virt, r->frames[i], PAGE_SHARED | PAGE_USER | PAGE_WRITE | PAGE_PRESENT) < 0) return 0;
+        frame_ref(r->frames[i]);
+    }
+    r->mapped = 1;
+    paging_flush();
+    return base;
+}
@@ -0,0 +1,25 @@
+// Shared memory regions: the same frames mapped into several address spaces
+#ifndef SHM_H
+#define SHM_H
+
+#include "paging.h"
+
+#define MAX_SHM 8
+#define SHM_MAX_PAGES 16
+#define SHM_BASE 0xA0000000                          // Region i maps at SHM_BASE + i * SHM_REGION_SPAN
+#define SHM_REGION_SPAN (SHM_MAX_PAGES * PAGE_SIZE)
+
+typedef struct {
+    int used;
+    unsigned int key;                   // Name shared by the processes that open it
+    int pages;
+    int mapped;                         // Set by the first map; unused regions are reclaimed after that
+    unsigned int frames[SHM_MAX_PAGES]; // One reference each held by the region
+} ShmRegion;
+
+extern ShmRegion shm_regions[MAX_SHM];
+
+int shm_create(unsigned int key, unsigned int size);
+unsigned int shm_map(unsigned int* page_dir, int id);
+
+#endif
@@ -0,0 +1,59 @@
+// System call numbers
+#ifndef SYSCALL_H
+#define SYSCALL_H
+
+#define SYS_WRITE 1
+#define SYS_OPEN  2
+#define SYS_EXIT  3
+#define SYS_PS    4
+#define SYS_KILL  5
+#define SYS_READ  6
+#define SYS_CLOSE 7
+#define SYS_CREATE 8
+#define SYS_LS    9     // Retired: a fixed 255-byte root listing; use SYS_GETDENTS
+#define SYS_FORK  10
+#define SYS_EXEC  11
+#define SYS_WAIT  12
+#define SYS_PIPE  13
+#define SYS_FWRITE 14
+#define SYS_SHM_CREATE 15
+#define SYS_SHM_MAP 16
+#define SYS_FUTEX 17
+#define SYS_THREAD_CREATE 18
+#define SYS_THREAD_EXIT 19
+#define SYS_SCHED_SET 20
+#define SYS_SCHED_YIELD 21
+#define SYS_GETDENTS 22
+#define SYS_STAT 23
+#define SYS_FSTAT 24
+
+// SYS_FUTEX operations
+#define FUTEX_WAIT 0      // Sleep if *addr still equals val
+#define FUTEX_WAKE 1      // Wake up to val sleepers on addr
+
+// SYS_SCHED_SET policies
+#define SCHED_PRIO 0      // Strict priority: the highest ready priority runs
+#define SCHED_FAIR 1      // Fair share by virtual runtime, when no SCHED_PRIO task is ready
+#define SCHED_EDF  2      // Earliest deadline first, ahead of both; admission controlled
+
+// SYS_GETDENTS records and SYS_STAT/SYS_FSTAT results
+#define DIRENT_NAME_MAX 32 // Name bytes in a Dirent, terminator included
+#define STAT_FILE 0
+#define STAT_DIR  1
+
+typedef struct {
+    int inode;
+    int type;                    // STAT_FILE or STAT_DIR
+    int size;                    // Bytes, or entries for a directory
+    char name[DIRENT_NAME_MAX];
+} Dirent;
+
+typedef struct {
+    int inode;
+    int type;                    // STAT_FILE or STAT_DIR
+    int size;                    // Bytes, or entries for a directory
+    int blocks;                  // Data blocks held
+    int parent;                  // Inode of the directory holding it
+} Stat;
+
+#endif
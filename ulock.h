@@ -0,0 +1,37 @@
+// Locks for ring 3 programs on top of SYS_FUTEX. A lock word lives in
+// memory the contending processes share (a shared memory region); taking
+// and releasing a free lock is a single atomic instruction, and the kernel
+// is entered only to sleep on a held lock or to wake a sleeper.
+#ifndef ULOCK_H
+#define ULOCK_H
+
+#include "usys.h"
+
+typedef struct {
+    volatile int state;   // 0: free, 1: held, 2: held and someone may sleep on it
+} UMutex;
+
+#define UMUTEX_INIT { 0 }
+
+static inline void umutex_lock(UMutex* m) {
+    int c = __sync_val_compare_and_swap(&m->state, 0, 1);
+    if (c == 0) return; // Uncontended
+    if (c != 2) c = __sync_lock_test_and_set(&m->state, 2);
+    while (c != 0) {
+        sys_futex_wait(&m->state, 2); // Returns at once if state moved on
+        c = __sync_lock_test_and_set(&m->state, 2);
+    }
+}
+
+static inline int umutex_trylock(UMutex* m) {
+    return __sync_val_compare_and_swap(&m->state, 0, 1) == 0;
+}
+
+static inline void umutex_unlock(UMutex* m) {
+    if (__sync_fetch_and_sub(&m->state, 1) != 1) { // There may be sleepers
+        m->state = 0;
+        sys_futex_wake(&m->state, 1);
+    }
+}
+
+#endif
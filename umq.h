@@ -0,0 +1,70 @@
+// Message queues for ring 3 programs: a single-producer, single-consumer
+// ring of fixed-size messages in a shared memory region. Sending and
+// receiving only touch the shared counters. The futex syscall is made only
+// to sleep on a full or empty queue, or to wake a peer that went to sleep.
+#ifndef UMQ_H
+#define UMQ_H
+
+#include "usys.h"
+
+#define MQ_MSG_SIZE 32
+
+typedef struct {
+    volatile int head;              // Messages ever sent (written by the producer)
+    volatile int tail;              // Messages ever received (written by the consumer)
+    volatile int consumer_waiting;  // Consumer is asleep, or about to sleep, on head
+    volatile int producer_waiting;  // Producer is asleep, or about to sleep, on tail
+    int slots;                      // Capacity in messages, a power of two
+    char data[];                    // slots * MQ_MSG_SIZE bytes
+} MsgQueue;
+
+// Bytes of shared memory a queue of slots messages needs
+#define MQ_BYTES(slots) (sizeof(MsgQueue) + (slots) * MQ_MSG_SIZE)
+
+// The waiting flag and the peer's counter are a store followed by a load
+// of another location; x86 may reorder that pair, so fence it
+static inline void mq_fence() {
+    __sync_synchronize();
+}
+
+static inline void mq_init(MsgQueue* q, int slots) {
+    q->head = q->tail = 0;
+    q->consumer_waiting = q->producer_waiting = 0;
+    q->slots = slots;
+}
+
+static inline void mq_send(MsgQueue* q, const void* msg) {
+    int head = q->head;
+    while (head - q->tail == q->slots) { // Full
+        int tail = q->tail;
+        q->producer_waiting = 1;
+        mq_fence();
+        if (head - q->tail == q->slots) sys_futex_wait(&q->tail, tail);
+        q->producer_waiting = 0;
+    }
+    char* slot = q->data + (head & (q->slots - 1)) * MQ_MSG_SIZE;
+    for (int i = 0; i < MQ_MSG_SIZE; i++) slot[i] = ((const char*)msg)[i];
+    asm volatile("" : : : "memory"); // Message before the counter (x86 keeps store order)
+    q->head = head + 1;
+    mq_fence();
+    if (q->consumer_waiting) sys_futex_wake(&q->head, 1);
+}
+
+static inline void mq_recv(MsgQueue* q, void* msg) {
+    int tail = q->tail;
+    while (q->head == tail) { // Empty
+        q->consumer_waiting = 1;
+        mq_fence();
+        if (q->head == tail) sys_futex_wait(&q->head, tail);
+        q->consumer_waiting = 0;
+    }
+    asm volatile("" : : : "memory"); // Counter before the message
+    const char* slot = q->data + (tail & (q->slots - 1)) * MQ_MSG_SIZE;
+    for (int i = 0; i < MQ_MSG_SIZE; i++) ((char*)msg)[i] = slot[i];
+    asm volatile("" : : : "memory");
+    q->tail = tail + 1;
+    mq_fence();
+    if (q->producer_waiting) sys_futex_wake(&q->tail, 1);
+}
+
+#endif
@@ -0,0 +1,7 @@
+// Sample user program: runs in ring 3 in its own address space
+#include "usys.h"
+
+void _start() {
+    sys_write("Hello from user space!");
+    sys_exit(0);
+}
@@ -0,0 +1,38 @@
+// Sample user program: forked workers increment a counter in shared memory
+// under a UMutex; preemption inside the critical section makes them contend
+#include "ulock.h"
+
+#define LOCK_KEY 0x6C6B   // "lk"
+#define WORKERS 3
+#define ROUNDS 20000
+
+typedef struct {
+    UMutex lock;
+    int counter;
+} Shared;
+
+void _start() {
+    int id = sys_shm_create(LOCK_KEY, sizeof(Shared));
+    Shared* shared = id < 0 ? 0 : (Shared*)sys_shm_map(id);
+    if (!shared) {
+        sys_write("lock: no shared memory");
+        sys_exit(1);
+    }
+    shared->lock.state = 0;
+    shared->counter = 0;
+    for (int i = 0; i < WORKERS; i++) {
+        if (sys_fork() == 0) {
+            for (int j = 0; j < ROUNDS; j++) {
+                umutex_lock(&shared->lock);
+                int value = shared->counter;
+                for (volatile int k = 0; k < 50; k++); // Widen the window for a tick to land
+                shared->counter = value + 1;
+                umutex_unlock(&shared->lock);
+            }
+            sys_exit(0);
+        }
+    }
+    while (sys_wait(-1, 0) > 0);
+    sys_write(shared->counter == WORKERS * ROUNDS ? "lock: no lost updates" : "lock: lost updates");
+    sys_exit(shared->counter == WORKERS * ROUNDS ? 0 : 1);
+}
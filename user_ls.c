@@ -0,0 +1,29 @@
+// Sample user program: walks the root directory a few records per
+// getdents call and checks the listing against stat and fstat
+#include "usys.h"
+
+void _start() {
+    Stat st, fst;
+    int fd = sys_open("/");
+    if (fd < 0 || sys_stat("/", &st) < 0 || sys_fstat(fd, &fst) < 0) {
+        sys_write("ls: cannot open /");
+        sys_exit(1);
+    }
+    Dirent ents[4]; // Small on purpose: a full listing takes several calls
+    int entries = 0, files = 0, bytes = 0, n;
+    while ((n = sys_getdents(fd, ents, sizeof(ents))) > 0) {
+        for (int i = 0; i < n / (int)sizeof(Dirent); i++) {
+            Stat est;
+            if (ents[i].type == STAT_FILE && sys_stat(ents[i].name, &est) == 0 &&
+                est.inode == ents[i].inode && est.parent == st.inode) {
+                files++;
+                bytes += est.size;
+            }
+            entries++;
+        }
+    }
+    sys_close(fd);
+    int ok = n == 0 && fst.inode == st.inode && fst.type == STAT_DIR && entries == st.size;
+    sys_write(ok ? "ls: root listing matches stat" : "ls: listing and stat disagree");
+    sys_exit(ok ? 0 : 1);
+}
@@ -0,0 +1,36 @@
+// Sample user program: a producer and a forked consumer pass numbered
+// messages through a queue in shared memory
+#include "umq.h"
+
+#define MQ_KEY 0x6D71   // "mq"
+#define MQ_SLOTS 64
+#define MESSAGES 10000
+
+void _start() {
+    int id = sys_shm_create(MQ_KEY, MQ_BYTES(MQ_SLOTS));
+    MsgQueue* q = id < 0 ? 0 : (MsgQueue*)sys_shm_map(id);
+    if (!q) {
+        sys_write("mq: no shared memory");
+        sys_exit(1);
+    }
+    mq_init(q, MQ_SLOTS);
+    int msg[MQ_MSG_SIZE / sizeof(int)];
+    int pid = sys_fork(); // The mapping stays shared in the child
+    if (pid == 0) {
+        int bad = 0;
+        for (int i = 0; i < MESSAGES; i++) {
+            mq_recv(q, msg);
+            if (msg[0] != i || msg[1] != ~i) bad++;
+        }
+        sys_exit(bad ? 1 : 0);
+    }
+    for (int i = 0; pid > 0 && i < MESSAGES; i++) {
+        msg[0] = i;
+        msg[1] = ~i;
+        mq_send(q, msg);
+    }
+    int code = 1;
+    if (pid > 0) sys_wait(pid, &code);
+    sys_write(code == 0 ? "mq: 10000 messages in order" : "mq: transfer failed");
+    sys_exit(code);
+}
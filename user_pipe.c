@@ -0,0 +1,38 @@
+// Sample user program: streams more than a pipe's capacity to a forked
+// reader, so both sides block on the ring buffer along the way
+#include "usys.h"
+
+#define TOTAL 4096
+
+void _start() {
+    int fds[2];
+    if (sys_pipe(fds) < 0) {
+        sys_write("pipe: no pipe");
+        sys_exit(1);
+    }
+    int pid = sys_fork();
+    if (pid == 0) {
+        sys_close(fds[1]);
+        char buf[100];
+        int total = 0, sum = 0, n;
+        while ((n = sys_read(fds[0], buf, sizeof(buf))) > 0) {
+            for (int i = 0; i < n; i++) sum += (unsigned char)buf[i];
+            total += n;
+        }
+        sys_exit(total == TOTAL && sum == TOTAL * 'p' ? 0 : 1);
+    }
+    sys_close(fds[0]);
+    char block[256];
+    for (int i = 0; i < (int)sizeof(block); i++) block[i] = 'p';
+    int sent = 0;
+    while (pid > 0 && sent < TOTAL) {
+        int n = sys_fwrite(fds[1], block, sizeof(block));
+        if (n <= 0) break;
+        sent += n;
+    }
+    sys_close(fds[1]); // Reader sees end of file
+    int code = 1;
+    if (pid > 0) sys_wait(pid, &code);
+    sys_write(sent == TOTAL && code == 0 ? "pipe: 4096 bytes through" : "pipe: transfer failed");
+    sys_exit(code);
+}
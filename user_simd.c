@@ -0,0 +1,50 @@
+// Sample user program: a parent and a forked child each keep their own
+// values in xmm0-xmm7 across many yields; the kernel's lazy FPU switching
+// must hand every task back exactly the registers it left
+#include "usys.h"
+
+#define ROUNDS 1000
+
+__attribute__((target("sse2")))
+static void load_regs(const unsigned int* v) {
+    asm volatile("movdqu 0(%0), %%xmm0\n\tmovdqu 16(%0), %%xmm1\n\t"
+                 "movdqu 32(%0), %%xmm2\n\tmovdqu 48(%0), %%xmm3\n\t"
+                 "movdqu 64(%0), %%xmm4\n\tmovdqu 80(%0), %%xmm5\n\t"
+                 "movdqu 96(%0), %%xmm6\n\tmovdqu 112(%0), %%xmm7"
+                 : : "r"(v) : "memory");
+}
+
+__attribute__((target("sse2")))
+static void store_regs(unsigned int* v) {
+    asm volatile("movdqu %%xmm0, 0(%0)\n\tmovdqu %%xmm1, 16(%0)\n\t"
+                 "movdqu %%xmm2, 32(%0)\n\tmovdqu %%xmm3, 48(%0)\n\t"
+                 "movdqu %%xmm4, 64(%0)\n\tmovdqu %%xmm5, 80(%0)\n\t"
+                 "movdqu %%xmm6, 96(%0)\n\tmovdqu %%xmm7, 112(%0)"
+                 : : "r"(v) : "memory");
+}
+
+// Nothing between the load and the store may use xmm registers: only the
+// syscall, and whatever the other task does while this one is switched out
+static int run(unsigned int seed) {
+    unsigned int want[32], got[32];
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < 32; i++) want[i] = seed * 2654435761u + round * 32 + i;
+        load_regs(want);
+        sys_sched_yield();
+        store_regs(got);
+        for (int i = 0; i < 32; i++) {
+            if (got[i] != want[i]) return 1;
+        }
+    }
+    return 0;
+}
+
+void _start() {
+    int pid = sys_fork();
+    if (pid == 0) sys_exit(run(2));
+    int failed = pid < 0 || run(1);
+    int code = 1;
+    if (pid > 0 && (sys_wait(pid, &code) < 0 || code != 0)) failed = 1;
+    sys_write(failed ? "simd: xmm state was corrupted" : "simd: xmm state kept across 2000 switches");
+    sys_exit(failed);
+}
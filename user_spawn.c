@@ -0,0 +1,29 @@
+// Sample user program: forks workers that exec user_hello, then waits for them
+#include "usys.h"
+
+#define WORKERS 4
+
+static int results[WORKERS]; // Written by every child: copy-on-write pages
+
+void _start() {
+    int started = 0;
+    for (int i = 0; i < WORKERS; i++) {
+        int pid = sys_fork();
+        if (pid == 0) {
+            results[i] = 1;
+            sys_exec("user_hello");
+            sys_exit(1); // exec failed
+        }
+        if (pid > 0) started++;
+    }
+    int failed = 0;
+    int code;
+    while (sys_wait(-1, &code) > 0) {
+        if (code != 0) failed++;
+    }
+    for (int i = 0; i < WORKERS; i++) {
+        if (results[i]) failed++; // Children's writes must not leak back
+    }
+    sys_write(started == WORKERS && !failed ? "spawn: workers done" : "spawn: worker failed");
+    sys_exit(failed);
+}
@@ -0,0 +1,50 @@
+// Sample user program: worker threads sum slices of one array in the shared
+// address space and report through a pipe opened before they started
+#include "uthread.h"
+
+#define THREADS 4
+#define ITEMS 4096
+#define STACK_SIZE 4096
+
+static int data[ITEMS];
+static int partial[THREADS];
+static char stacks[THREADS][STACK_SIZE] __attribute__((aligned(16)));
+static int report_fd;
+
+static int worker(void* arg) {
+    int id = (int)arg;
+    int sum = 0;
+    for (int i = id * (ITEMS / THREADS); i < (id + 1) * (ITEMS / THREADS); i++) sum += data[i];
+    partial[id] = sum;
+    char done = '0' + id;
+    sys_fwrite(report_fd, &done, 1); // Descriptor table is shared too
+    return id;
+}
+
+void _start() {
+    int fds[2];
+    if (sys_pipe(fds) < 0) {
+        sys_write("thread: no pipe");
+        sys_exit(1);
+    }
+    report_fd = fds[1];
+    for (int i = 0; i < ITEMS; i++) data[i] = i;
+    int tids[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        tids[i] = uthread_create(worker, (void*)i, stacks[i], STACK_SIZE);
+    }
+    int failed = 0;
+    for (int i = 0; i < THREADS; i++) {
+        int result;
+        if (tids[i] < 0 || uthread_join(tids[i], &result) < 0 || result != i) failed++;
+    }
+    char reports[THREADS];
+    sys_close(fds[1]);
+    int got = 0, n;
+    while ((n = sys_read(fds[0], reports + got, THREADS - got)) > 0) got += n;
+    int total = 0;
+    for (int i = 0; i < THREADS; i++) total += partial[i];
+    if (got != THREADS || total != ITEMS * (ITEMS - 1) / 2) failed++;
+    sys_write(failed ? "thread: workers failed" : "thread: 4 workers summed the array");
+    sys_exit(failed);
+}
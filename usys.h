@@ -0,0 +1,125 @@
+// System call wrappers for ring 3 programs (int 0x80, see syscall.h)
+#ifndef USYS_H
+#define USYS_H
+
+#include "syscall.h"
+
+static inline int syscall3(int num, unsigned int a, unsigned int b, unsigned int c) {
+    int ret;
+    asm volatile("int $0x80" : "=a"(ret) : "a"(num), "b"(a), "c"(b), "d"(c) : "memory");
+    return ret;
+}
+
+static inline int sys_write(const char* s) {
+    return syscall3(SYS_WRITE, (unsigned int)s, 0, 0);
+}
+
+static inline void sys_exit(int code) {
+    syscall3(SYS_EXIT, code, 0, 0);
+    while (1);
+}
+
+// Returns the child's pid in the parent and 0 in the child
+static inline int sys_fork() {
+    return syscall3(SYS_FORK, 0, 0, 0);
+}
+
+// Replace this program with a GRUB module; returns only on failure
+static inline int sys_exec(const char* name) {
+    return syscall3(SYS_EXEC, (unsigned int)name, 0, 0);
+}
+
+// Wait for a child (pid, or -1 for any); returns its pid or -1
+static inline int sys_wait(int pid, int* code) {
+    return syscall3(SYS_WAIT, pid, (unsigned int)code, 0);
+}
+
+static inline int sys_read(int fd, void* buf, int len) {
+    return syscall3(SYS_READ, fd, (unsigned int)buf, len);
+}
+
+// Write len bytes to a descriptor; returns how many were written or -1
+static inline int sys_fwrite(int fd, const void* buf, int len) {
+    return syscall3(SYS_FWRITE, fd, (unsigned int)buf, len);
+}
+
+static inline int sys_close(int fd) {
+    return syscall3(SYS_CLOSE, fd, 0, 0);
+}
+
+// Open a file or directory by path; returns a descriptor or -1
+static inline int sys_open(const char* path) {
+    return syscall3(SYS_OPEN, (unsigned int)path, 0, 0);
+}
+
+// Fill buf with whole Dirent records from a directory's cursor on; returns
+// the bytes filled, 0 at the end, or -1
+static inline int sys_getdents(int fd, Dirent* buf, int bytes) {
+    return syscall3(SYS_GETDENTS, fd, (unsigned int)buf, bytes);
+}
+
+static inline int sys_stat(const char* path, Stat* st) {
+    return syscall3(SYS_STAT, (unsigned int)path, (unsigned int)st, 0);
+}
+
+static inline int sys_fstat(int fd, Stat* st) {
+    return syscall3(SYS_FSTAT, fd, (unsigned int)st, 0);
+}
+
+// fds[0] is the read end, fds[1] the write end; returns 0 or -1
+static inline int sys_pipe(int fds[2]) {
+    return syscall3(SYS_PIPE, (unsigned int)fds, 0, 0);
+}
+
+// Open (or create, zeroed) the shared memory region named key; returns its id
+static inline int sys_shm_create(unsigned int key, unsigned int size) {
+    return syscall3(SYS_SHM_CREATE, key, size, 0);
+}
+
+// Map a region; returns its address, the same in every process, or 0
+static inline void* sys_shm_map(int id) {
+    int addr = syscall3(SYS_SHM_MAP, id, 0, 0);
+    return addr == -1 ? 0 : (void*)addr;
+}
+
+// Sleep while *addr == val (returns 0 when woken, -1 if it already differs)
+static inline int sys_futex_wait(volatile int* addr, int val) {
+    return syscall3(SYS_FUTEX, (unsigned int)addr, FUTEX_WAIT, val);
+}
+
+// Wake up to count sleepers on addr; returns how many woke
+static inline int sys_futex_wake(volatile int* addr, int count) {
+    return syscall3(SYS_FUTEX, (unsigned int)addr, FUTEX_WAKE, count);
+}
+
+// Start a thread running entry(arg) on the stack below stack_top; returns
+// its thread id, which sys_wait accepts to join it. Prefer uthread.h.
+static inline int sys_thread_create(void (*entry)(void*), void* stack_top, void* arg) {
+    return syscall3(SYS_THREAD_CREATE, (unsigned int)entry, (unsigned int)stack_top, (unsigned int)arg);
+}
+
+// Move the calling thread to a scheduling policy (SCHED_PRIO, SCHED_FAIR); 0 or -1
+static inline int sys_sched_set(int policy) {
+    return syscall3(SYS_SCHED_SET, policy, 0, 0);
+}
+
+// Make the calling thread periodic under SCHED_EDF: runtime timer ticks of
+// CPU every period ticks, each job due by the end of its period. Returns -1
+// when admission control turns it down.
+static inline int sys_sched_edf(unsigned int runtime, unsigned int period) {
+    return syscall3(SYS_SCHED_SET, SCHED_EDF, runtime, period);
+}
+
+// SCHED_EDF: this job is done, sleep until the next release. Otherwise
+// just gives up the CPU.
+static inline int sys_sched_yield() {
+    return syscall3(SYS_SCHED_YIELD, 0, 0, 0);
+}
+
+// End the calling thread; from the main thread this ends the process
+static inline void sys_thread_exit(int code) {
+    syscall3(SYS_THREAD_EXIT, code, 0, 0);
+    while (1);
+}
+
+#endif
@@ -0,0 +1,32 @@
+// Threads for ring 3 programs: SYS_THREAD_CREATE with caller-provided
+// stacks. A thread returning from its function exits with its result.
+#ifndef UTHREAD_H
+#define UTHREAD_H
+
+#include "usys.h"
+
+typedef struct {
+    int (*fn)(void*);
+    void* arg;
+} UThreadStart;
+
+static inline void uthread_entry(void* p) {
+    UThreadStart* start = (UThreadStart*)p;
+    sys_thread_exit(start->fn(start->arg));
+}
+
+// Run fn(arg) in a new thread on stack[0..size). The start record sits at
+// the top of that stack. Returns the thread id, or -1.
+static inline int uthread_create(int (*fn)(void*), void* arg, void* stack, unsigned int size) {
+    UThreadStart* start = (UThreadStart*)(((unsigned int)stack + size - sizeof(UThreadStart)) & ~15u);
+    start->fn = fn;
+    start->arg = arg;
+    return sys_thread_create(uthread_entry, start, start);
+}
+
+// Wait for a thread this thread created; returns its result via *result
+static inline int uthread_join(int tid, int* result) {
+    return sys_wait(tid, result) == tid ? 0 : -1;
+}
+
+#endif
@@ -0,0 +1,1257 @@
+#include "vfs.h"
+#include "klib.h"
+#include "console.h"
+#include "pipe.h"
+#include "lock.h"
+#include "procfs.h"
+#include "journal.h"
+#include "lz4.h"
+
+VFS_Mount vfs;                    // Single VFS mount
+FileDescriptor fds[MAX_FILES];    // File descriptor table
+int vfs_initialized = 0;          // Flag to track VFS initialization
+VfsStats vfs_stats;
+
+// Held across every entry point below: the shell runs VFS commands from the
+// keyboard interrupt while tasks may be in the middle of a call
+static Spinlock vfs_lock = SPINLOCK_INIT;
+
+// Directory entries: inodes hashed on (directory, name), chained through
+// hash_next. Free inodes are chained the same way from inode_free.
+static int entry_heads[VFS_HASH_SIZE];
+static int inode_free = -1;
+
+// File data blocks, and the stack of free ones
+static char blocks[VFS_BLOCKS][VFS_BLOCK_SIZE];
+static int block_free[VFS_BLOCKS];
+
+// Journal checkpoint state (see Journal)
+static int checkpoint_next;    // Next entry the running checkpoint logs, -1 at the end
+static int checkpoint_running; // A checkpoint is part way through the tree
+static int checkpoint_due;     // The log filled; the next sync checkpoints
+
+// Dentry cache: recently resolved paths, direct mapped on the path hash.
+// Removing any entry bumps dcache_gen, which drops every cached path (inode
+// numbers are reused), so only hits on live entries are possible.
+typedef struct {
+    unsigned int gen;
+    int inode;
+    char path[VFS_PATH_MAX];
+} Dentry;
+
+static Dentry dcache[DCACHE_SIZE];
+static unsigned int dcache_gen = 1;
+
+// Compressed file cache
+// A file in compressed mode keeps its contents as one LZ4 block, in as few
+// data blocks as that takes (raw when LZ4 would not save a block). Reads
+// and writes go through a small LRU cache of decompressed files. A write
+// only changes the cached copy, after reserving the blocks to store the
+// file raw, so writing it back on eviction or last close cannot run out of
+// space; the surplus goes back to the pool then.
+#define ZCACHE_SLOTS 4
+
+typedef struct {
+    int inode;                    // -1 when free
+    int dirty;                    // Newer than the file's blocks
+    unsigned int used_at;         // LRU stamp
+    char data[MAX_FILE_SIZE];
+} ZSlot;
+
+static ZSlot zcache[ZCACHE_SLOTS];
+static unsigned int zcache_clock;
+static unsigned char zbuf[LZ4_BOUND(MAX_FILE_SIZE)];
+static int lz4_table[LZ4_HASH_SIZE];
+
+static ZSlot* zcache_find(int ino) {
+    for (int k = 0; k < ZCACHE_SLOTS; k++) {
+        if (zcache[k].inode == ino) return &zcache[k];
+    }
+    return 0;
+}
+
+static void zcache_drop(int ino) {
+    ZSlot* z = zcache_find(ino);
+    if (z) z->inode = -1;
+}
+
+// Virtual File System
+void init_vfs() {
+    print_string("Initializing VFS...", 3, 0);
+    
+    // Debug: Step 1
+    //print_string("Step 1: Setting device", 4, 0);
+    custom_strcpy(vfs.device, "hda");
+    
+    // Debug: Step 2
+    //print_string("Step 2: Setting mount point", 5, 0);
+    custom_strcpy(vfs.mount_point, "/");
+    
+    // Debug: Step 3
+    //print_string("Step 3: Setting fs type", 6, 0);
+    custom_strcpy(vfs.fs_type, "ext2");
+    
+    // Debug: Step 4
+    //print_string("Step 4: Initializing counters", 7, 0);
+    vfs.inodes_used = 0;
+    vfs.files = 0;
+    vfs.dirs = 0;
+    
+    // Debug: Step 5
+    //print_string("Step 5: Initializing inodes", 8, 0);
+    inode_free = -1;
+    for (int i = MAX_INODES - 1; i >= 0; i--) {
+        vfs.inodes[i].used = 0;
+        vfs.inodes[i].id = i;
+        vfs.inodes[i].size = 0;
+        vfs.inodes[i].name[0] = 0;
+        vfs.inodes[i].hash_next = inode_free;
+        inode_free = i;
+    }
+    memset(entry_heads, 0xFF, sizeof(entry_heads)); // All -1
+    for (int i = 0; i < VFS_BLOCKS; i++) {
+        block_free[i] = VFS_BLOCKS - 1 - i;
+    }
+    vfs.blocks_free = VFS_BLOCKS;
+    for (int k = 0; k < ZCACHE_SLOTS; k++) zcache[k].inode = -1;
+    dcache_gen++;
+    journal_close(); // A fresh tree is not what any attached log describes
+    checkpoint_running = 0;
+    checkpoint_due = 0;
+    
+    // Debug: Step 6
+    //print_string("Step 6: Initializing file descriptors", 9, 0);
+    for (int i = 0; i < MAX_FILES; i++) {
+        fds[i].used = 0;
+        fds[i].inode_id = -1;
+        fds[i].offset = 0;
+        fds[i].refs = 0;
+        fds[i].pipe = -1;
+        fds[i].proc_file = -1;
+    }
+    for (int i = 0; i < MAX_PIPES; i++) {
+        pipes[i].readers = 0;
+        pipes[i].writers = 0;
+    }
+
+    // The root directory: inode 0, its own parent
+    Inode* root = &vfs.inodes[VFS_ROOT];
+    inode_free = root->hash_next;
+    root->used = 1;
+    root->type = VFS_DIR;
+    root->parent = VFS_ROOT;
+    root->first_child = root->last_child = -1;
+    root->next_sibling = root->prev_sibling = -1;
+    root->hash_next = -1;
+    vfs.inodes_used = 1;
+    vfs.dirs = 1;
+    
+    // Debug: Step 7
+    //print_string("Step 7: Setting VFS flag", 10, 0);
+    vfs_initialized = 1;
+    
+    // Final confirmation
+    print_string("VFS initialized", 4, 0);
+}
+
+// Paths
+// "/a/b" and "a/b" both start at the root; "." and ".." are understood.
+// A component is at most VFS_NAME_MAX - 1 characters.
+
+static unsigned int entry_hash(int dir, const char* name, int len) {
+    unsigned int h = 2166136261u ^ (unsigned int)dir; // FNV-1a
+    for (int i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return h & (VFS_HASH_SIZE - 1);
+}
+
+static int name_is(const char* name, const char* comp, int len) {
+    return strncmp(name, comp, len) == 0 && name[len] == 0;
+}
+
+// The entry comp[0..len) of directory dir, -1 if none
+static int find_entry(int dir, const char* comp, int len) {
+    for (int i = entry_heads[entry_hash(dir, comp, len)]; i >= 0; i = vfs.inodes[i].hash_next) {
+        if (vfs.inodes[i].parent == dir && name_is(vfs.inodes[i].name, comp, len)) return i;
+    }
+    return -1;
+}
+
+// Walk path from the root, one hashed lookup per component
+static int walk(const char* path) {
+    int ino = VFS_ROOT;
+    while (*path) {
+        while (*path == '/') path++;
+        if (!*path) break;
+        const char* comp = path;
+        while (*path && *path != '/') path++;
+        int len = path - comp;
+        if (vfs.inodes[ino].type != VFS_DIR) return -1;
+        if (len == 1 && comp[0] == '.') continue;
+        if (len == 2 && comp[0] == '.' && comp[1] == '.') {
+            ino = vfs.inodes[ino].parent;
+            continue;
+        }
+        if (len >= VFS_NAME_MAX) return -1;
+        ino = find_entry(ino, comp, len);
+        if (ino < 0) return -1;
+    }
+    return ino;
+}
+
+// The inode a path names, -1 if none; the dentry cache first
+static int resolve(const char* path) {
+    unsigned int h = 2166136261u;
+    int len = 0;
+    for (; path[len]; len++) {
+        h = (h ^ (unsigned char)path[len]) * 16777619u;
+    }
+    Dentry* d = &dcache[h & (DCACHE_SIZE - 1)];
+    if (d->gen == dcache_gen && strcmp(d->path, path) == 0) {
+        vfs_stats.dcache_hits++;
+        return d->inode;
+    }
+    vfs_stats.dcache_misses++;
+    int ino = walk(path);
+    if (ino >= 0 && len < VFS_PATH_MAX) {
+        custom_strcpy(d->path, path);
+        d->inode = ino;
+        d->gen = dcache_gen;
+    }
+    return ino;
+}
+
+// Split path into its directory, which must exist, and last component.
+// Returns the directory's inode, or -1; *leaf points into path.
+static int resolve_parent(const char* path, const char** leaf, int* leaf_len) {
+    int end = 0;
+    while (path[end]) end++;
+    while (end > 0 && path[end - 1] == '/') end--;
+    int start = end;
+    while (start > 0 && path[start - 1] != '/') start--;
+    *leaf = path + start;
+    *leaf_len = end - start;
+    if (*leaf_len == 0 || *leaf_len >= VFS_NAME_MAX || start >= VFS_PATH_MAX) return -1;
+    if (name_is(".", *leaf, *leaf_len) || name_is("..", *leaf, *leaf_len)) return -1;
+    char dir_path[VFS_PATH_MAX];
+    memcpy(dir_path, path, start);
+    dir_path[start] = 0;
+    int dir = resolve(dir_path);
+    return dir >= 0 && vfs.inodes[dir].type == VFS_DIR ? dir : -1;
+}
+
+// Entries
+
+static int add_entry(const char* path, int type) {
+    const char* leaf;
+    int len;
+    int dir = resolve_parent(path, &leaf, &len);
+    if (dir < 0 || find_entry(dir, leaf, len) >= 0) return -1;
+    if (inode_free < 0) {
+        print_string("No free inodes", 16, 0);
+        return -1;
+    }
+    int i = inode_free;
+    Inode* inode = &vfs.inodes[i];
+    inode_free = inode->hash_next;
+    inode->used = 1;
+    inode->type = type;
+    inode->size = 0;
+    memcpy(inode->name, leaf, len);
+    inode->name[len] = 0;
+    memset(inode->blocks, 0xFF, sizeof(inode->blocks));
+    inode->zsize = -1;
+    inode->first_child = inode->last_child = -1;
+
+    unsigned int h = entry_hash(dir, leaf, len);
+    inode->hash_next = entry_heads[h];
+    entry_heads[h] = i;
+    Inode* parent = &vfs.inodes[dir];
+    inode->parent = dir;
+    inode->next_sibling = -1;
+    inode->prev_sibling = parent->last_child;
+    if (parent->last_child >= 0) {
+        vfs.inodes[parent->last_child].next_sibling = i;
+    } else {
+        parent->first_child = i;
+    }
+    parent->last_child = i;
+    parent->size++;
+
+    vfs.inodes_used++;
+    if (type == VFS_DIR) {
+        vfs.dirs++;
+    } else {
+        vfs.files++;
+    }
+    return i;
+}
+
+// Entry after i in checkpoint order, skipping i's children
+static int checkpoint_after(int i) {
+    while (i != VFS_ROOT && vfs.inodes[i].next_sibling < 0) i = vfs.inodes[i].parent;
+    return i == VFS_ROOT ? -1 : vfs.inodes[i].next_sibling;
+}
+
+static void remove_entry(int i) {
+    // A running checkpoint about to log the entry moves on past it
+    if (checkpoint_running && checkpoint_next == i) checkpoint_next = checkpoint_after(i);
+    Inode* inode = &vfs.inodes[i];
+    Inode* parent = &vfs.inodes[inode->parent];
+    int len = 0;
+    while (inode->name[len]) len++;
+    int* link = &entry_heads[entry_hash(inode->parent, inode->name, len)];
+    while (*link != i) link = &vfs.inodes[*link].hash_next;
+    *link = inode->hash_next;
+
+    // Open listings of the directory positioned on it move to the next entry
+    for (int fd = 0; fd < MAX_FILES; fd++) {
+        if (fds[fd].used && fds[fd].inode_id == inode->parent && fds[fd].offset == i) {
+            fds[fd].offset = inode->next_sibling;
+        }
+    }
+    if (inode->prev_sibling >= 0) {
+        vfs.inodes[inode->prev_sibling].next_sibling = inode->next_sibling;
+    } else {
+        parent->first_child = inode->next_sibling;
+    }
+    if (inode->next_sibling >= 0) {
+        vfs.inodes[inode->next_sibling].prev_sibling = inode->prev_sibling;
+    } else {
+        parent->last_child = inode->prev_sibling;
+    }
+    parent->size--;
+
+    zcache_drop(i);
+    for (int j = 0; j < FILE_BLOCKS; j++) {
+        if (inode->blocks[j] >= 0) block_free[vfs.blocks_free++] = inode->blocks[j];
+        inode->blocks[j] = -1;
+    }
+    if (inode->type == VFS_DIR) {
+        vfs.dirs--;
+    } else {
+        vfs.files--;
+    }
+    inode->used = 0;
+    inode->size = 0;
+    inode->name[0] = 0;
+    inode->hash_next = inode_free;
+    inode_free = i;
+    vfs.inodes_used--;
+    dcache_gen++;
+}
+
+static int is_open(int ino) {
+    for (int j = 0; j < MAX_FILES; j++) {
+        if (fds[j].used && fds[j].inode_id == ino) return 1;
+    }
+    return 0;
+}
+
+// Compressed files: block layout, cache fill and write-back
+static int blocks_for(int bytes) {
+    return (bytes + VFS_BLOCK_SIZE - 1) / VFS_BLOCK_SIZE;
+}
+
+// Copy n bytes between a buffer and the start of the file's blocks. A
+// missing block (a hole in a raw file) reads as zeros.
+static void gather(Inode* inode, char* buf, int n) {
+    for (int off = 0; off < n; off += VFS_BLOCK_SIZE) {
+        int chunk = n - off < VFS_BLOCK_SIZE ? n - off : VFS_BLOCK_SIZE;
+        int b = inode->blocks[off / VFS_BLOCK_SIZE];
+        if (b < 0) {
+            memset(buf + off, 0, chunk);
+        } else {
+            memcpy(buf + off, blocks[b], chunk);
+        }
+    }
+}
+
+static void scatter(Inode* inode, const char* buf, int n) {
+    for (int off = 0; off < n; off += VFS_BLOCK_SIZE) {
+        int chunk = n - off < VFS_BLOCK_SIZE ? n - off : VFS_BLOCK_SIZE;
+        memcpy(blocks[inode->blocks[off / VFS_BLOCK_SIZE]], buf + off, chunk);
+    }
+}
+
+// Take a block from the pool (the caller checks it is not empty), zeroed so
+// no deleted file's data shows through
+static int alloc_block() {
+    int b = block_free[--vfs.blocks_free];
+    memset(blocks[b], 0, VFS_BLOCK_SIZE);
+    return b;
+}
+
+// Make the file hold exactly its first n blocks, freeing any after them.
+// Growing stops when the pool runs out; returns the leading blocks held.
+static int set_blocks(Inode* inode, int n) {
+    int held = 0;
+    for (int j = 0; j < FILE_BLOCKS; j++) {
+        short* b = &inode->blocks[j];
+        if (j < n && *b < 0 && vfs.blocks_free) *b = alloc_block();
+        if (j >= n && *b >= 0) {
+            block_free[vfs.blocks_free++] = *b;
+            *b = -1;
+        }
+        if (*b >= 0 && held == j) held++;
+    }
+    return held;
+}
+
+// Store a cached file back in its blocks, compressed if that saves any.
+// Its blocks cover the raw size (see write_compressed), so this never fails.
+static void zcache_flush(ZSlot* z) {
+    Inode* inode = &vfs.inodes[z->inode];
+    int n = lz4_compress((const unsigned char*)z->data, inode->size, zbuf, sizeof(zbuf), lz4_table);
+    if (n > 0 && blocks_for(n) < blocks_for(inode->size)) {
+        scatter(inode, (const char*)zbuf, n);
+        inode->zsize = n;
+    } else {
+        scatter(inode, z->data, inode->size);
+        inode->zsize = 0;
+    }
+    set_blocks(inode, blocks_for(inode->zsize ? inode->zsize : inode->size));
+    z->dirty = 0;
+    vfs_stats.zcache_writebacks++;
+}
+
+// The decompressed contents of a compressed file, loaded into the least
+// recently used slot (written back first if dirty) on a miss
+static ZSlot* zcache_get(Inode* inode) {
+    ZSlot* z = zcache_find(inode->id);
+    if (z) {
+        z->used_at = ++zcache_clock;
+        vfs_stats.zcache_hits++;
+        return z;
+    }
+    z = &zcache[0];
+    for (int k = 1; k < ZCACHE_SLOTS && z->inode >= 0; k++) {
+        if (zcache[k].inode < 0 || zcache[k].used_at < z->used_at) z = &zcache[k];
+    }
+    if (z->inode >= 0 && z->dirty) zcache_flush(z);
+    z->inode = inode->id;
+    z->dirty = 0;
+    z->used_at = ++zcache_clock;
+    if (inode->zsize > 0) {
+        gather(inode, (char*)zbuf, inode->zsize);
+        if (lz4_decompress(zbuf, inode->zsize, (unsigned char*)z->data, MAX_FILE_SIZE) != inode->size) {
+            memset(z->data, 0, inode->size); // Corrupt: never expected in RAM
+        }
+    } else {
+        gather(inode, z->data, inode->size);
+    }
+    vfs_stats.zcache_misses++;
+    return z;
+}
+
+// Write back the files no descriptor has open, whose last close has passed
+// (or, replaying a log, never came)
+static void zcache_writeback() {
+    for (int k = 0; k < ZCACHE_SLOTS; k++) {
+        if (zcache[k].inode >= 0 && zcache[k].dirty && !is_open(zcache[k].inode)) zcache_flush(&zcache[k]);
+    }
+}
+
+static int write_compressed(Inode* inode, int off, const char* buf, int len) {
+    ZSlot* z = zcache_get(inode);
+    int end = off + len < MAX_FILE_SIZE ? off + len : MAX_FILE_SIZE;
+    if (end <= off) return 0;
+    int held = set_blocks(inode, blocks_for(end > inode->size ? end : inode->size));
+    z->dirty = 1; // Even if nothing is written: write-back trims the reservation
+    if (held < blocks_for(inode->size)) return 0;
+    if (end > held * VFS_BLOCK_SIZE) end = held * VFS_BLOCK_SIZE; // Pool ran out
+    if (end <= off) return 0;
+    memcpy(z->data + off, buf, end - off);
+    if (end > inode->size) inode->size = end;
+    return end - off;
+}
+
+// Switch file i between raw and compressed storage. Returns -1 if the pool
+// cannot hold the raw form the switch passes through.
+static int set_compressed(int i, int on) {
+    Inode* inode = &vfs.inodes[i];
+    if (inode->type != VFS_FILE) return -1;
+    if (on == (inode->zsize >= 0)) return 0;
+    if (on) {
+        if (set_blocks(inode, blocks_for(inode->size)) < blocks_for(inode->size)) return -1;
+        inode->zsize = 0; // Its blocks hold it raw
+        zcache_flush(zcache_get(inode));
+    } else {
+        ZSlot* z = zcache_get(inode);
+        z->dirty = 1; // If the blocks do not fit, write-back trims them again
+        if (set_blocks(inode, blocks_for(inode->size)) < blocks_for(inode->size)) return -1;
+        scatter(inode, z->data, inode->size);
+        inode->zsize = -1;
+        zcache_drop(i);
+    }
+    return 0;
+}
+
+// Writes fill the file's blocks, taking new ones from the pool as the file
+// grows; a write stops short when MAX_FILE_SIZE or the pool is reached.
+// One starting past the end (only a bad log record can) writes nothing, so
+// a file never has holes.
+static int write_inode(Inode* inode, int off, const char* buf, int len) {
+    if (off > inode->size) return 0;
+    if (inode->zsize >= 0) return write_compressed(inode, off, buf, len);
+    int bytes = 0;
+    while (bytes < len && off < MAX_FILE_SIZE) {
+        short* b = &inode->blocks[off / VFS_BLOCK_SIZE];
+        if (*b < 0) {
+            if (!vfs.blocks_free) break;
+            *b = alloc_block();
+        }
+        char* block = blocks[*b];
+        int end = off - off % VFS_BLOCK_SIZE + VFS_BLOCK_SIZE;
+        int n = end - off < len - bytes ? end - off : len - bytes;
+        memcpy(block + off % VFS_BLOCK_SIZE, buf + bytes, n);
+        off += n;
+        bytes += n;
+    }
+    if (off > inode->size) {
+        inode->size = off;
+    }
+    return bytes;
+}
+
+// Cut a file to its first size bytes, freeing the blocks past them and
+// zeroing the rest of the last one, so later growth reads zeros there
+static void truncate_inode(Inode* inode, int size) {
+    if (size >= inode->size) return;
+    if (inode->zsize >= 0) {
+        zcache_get(inode)->dirty = 1; // Write-back trims the blocks
+        inode->size = size;
+        return;
+    }
+    for (int j = blocks_for(size); j < FILE_BLOCKS; j++) {
+        if (inode->blocks[j] >= 0) {
+            block_free[vfs.blocks_free++] = inode->blocks[j];
+            inode->blocks[j] = -1;
+        }
+    }
+    int tail = size % VFS_BLOCK_SIZE, b = inode->blocks[size / VFS_BLOCK_SIZE];
+    if (tail && b >= 0) memset(blocks[b] + tail, 0, VFS_BLOCK_SIZE - tail);
+    inode->size = size;
+}
+
+// Journal
+// With a device mounted, every change is logged as a record naming its
+// entry by path, so replay does not depend on inode numbers. Records are
+// buffered and written out together (group commit) by vfs_sync. When the
+// log region fills, a snapshot of the whole tree replaces it.
+#define J_CREATE 1
+#define J_MKDIR  2
+#define J_DELETE 3
+#define J_RMDIR  4
+#define J_WRITE  5               // Data bytes at an offset
+#define J_COMPRESS 6             // Storage mode: offset 1 compressed, 0 raw
+#define J_TRUNCATE 7             // Cut to offset bytes
+
+typedef struct {
+    short type;
+    short path_len;              // Path bytes after the header, no terminator
+    int offset;
+    int len;                     // Data bytes after the path
+} JournalRecord;
+
+// A created entry's path has a directory part under VFS_PATH_MAX and one
+// more component, so its canonical form fits too
+#define JOURNAL_PATH_MAX (VFS_PATH_MAX + VFS_NAME_MAX)
+
+static char record[sizeof(JournalRecord) + JOURNAL_PATH_MAX + MAX_FILE_SIZE];
+static char snapshot_data[MAX_FILE_SIZE];
+
+// Build the record for a change to inode i; returns its size. Done before
+// a removal, while the path still resolves.
+static int log_build(int type, int i, int offset, const char* data, int len) {
+    JournalRecord* r = (JournalRecord*)record;
+    char* path = record + sizeof(JournalRecord);
+    int path_len = 0;
+    for (int j = i; j != VFS_ROOT; j = vfs.inodes[j].parent) {
+        for (const char* c = vfs.inodes[j].name; *c; c++) path_len++;
+        path_len++;
+    }
+    int pos = path_len;
+    for (int j = i; j != VFS_ROOT; j = vfs.inodes[j].parent) {
+        int n = 0;
+        while (vfs.inodes[j].name[n]) n++;
+        pos -= n;
+        memcpy(path + pos, vfs.inodes[j].name, n);
+        path[--pos] = '/';
+    }
+    r->type = type;
+    r->path_len = path_len;
+    r->offset = offset;
+    r->len = len;
+    memcpy(path + path_len, data, len);
+    return sizeof(JournalRecord) + path_len + len;
+}
+
+// Copy out a file's contents
+static void read_inode(Inode* inode, char* buf) {
+    if (inode->zsize >= 0) {
+        memcpy(buf, zcache_get(inode)->data, inode->size);
+        return;
+    }
+    gather(inode, buf, inode->size);
+}
+
+// Log the whole tree, parents before children, into the other log region
+// and switch to it. The walk runs in chunks with vfs_lock dropped in
+// between (see run_checkpoint), so ticks are not lost over a large tree.
+// Changes made meanwhile log their own records behind the entries already
+// written, and entries not reached yet are logged as they are then.
+static void checkpoint_begin() {
+    journal_checkpoint_begin();
+    checkpoint_next = vfs.inodes[VFS_ROOT].first_child;
+    checkpoint_running = 1;
+    checkpoint_due = 0;
+}
+
+// Log entries until about one transaction's worth has gone out. Returns 1
+// while entries remain, else the result of switching regions.
+static int checkpoint_step() {
+    int logged = 0;
+    while (checkpoint_next >= 0 && logged < JOURNAL_TXN_MAX) {
+        int i = checkpoint_next;
+        Inode* inode = &vfs.inodes[i];
+        int size = log_build(inode->type == VFS_DIR ? J_MKDIR : J_CREATE, i, 0, 0, 0);
+        journal_append(record, size);
+        logged += size;
+        if (inode->type == VFS_FILE && inode->zsize >= 0) journal_append(record, log_build(J_COMPRESS, i, 1, 0, 0));
+        if (inode->type == VFS_FILE && inode->size) {
+            read_inode(inode, snapshot_data);
+            size = log_build(J_WRITE, i, 0, snapshot_data, inode->size);
+            journal_append(record, size);
+            logged += size;
+        }
+        checkpoint_next = inode->type == VFS_DIR && inode->first_child >= 0 ? inode->first_child : checkpoint_after(i);
+    }
+    if (checkpoint_next >= 0) return 1;
+    checkpoint_running = 0;
+    return journal_checkpoint_end();
+}
+
+// Finish a started checkpoint, letting interrupts in between chunks. Called
+// and returns with vfs_lock held; another caller may finish it meanwhile.
+static int run_checkpoint(unsigned int* flags) {
+    if (!checkpoint_running) return 0;
+    while (checkpoint_step() > 0) {
+        spin_unlock_irqrestore(&vfs_lock, *flags);
+        *flags = spin_lock_irqsave(&vfs_lock);
+        if (!checkpoint_running) break;
+    }
+    return journal_attached() ? 0 : -1;
+}
+
+// A full log is replaced at the next sync rather than in the middle of an
+// operation; until then changes need no records, the snapshot holds them
+static void log_append(int size) {
+    if (checkpoint_due) return;
+    int result = journal_append(record, size);
+    if (result == JOURNAL_FULL && !checkpoint_running) {
+        checkpoint_due = 1;
+        return;
+    }
+    if (result < 0) print_string("Journal failed: changes are no longer durable", 16, 0);
+}
+
+static void log_op(int type, int i, int offset, const char* data, int len) {
+    if (journal_attached()) log_append(log_build(type, i, offset, data, len));
+}
+
+// Read the record header at *pos and check it against the transaction and
+// the tree's limits: a record with a good checksum can still be stale, from
+// an older format, or crafted. Returns -1 for a malformed one.
+static int next_record(const char* txn, int len, int* pos, JournalRecord* r) {
+    if (len - *pos < (int)sizeof(*r)) return -1;
+    memcpy(r, txn + *pos, sizeof(*r));
+    *pos += sizeof(*r);
+    if (r->type < J_CREATE || r->type > J_TRUNCATE) return -1;
+    if (r->path_len < 0 || r->path_len > JOURNAL_PATH_MAX || r->len < 0) return -1;
+    if (r->offset < 0 || r->offset > MAX_FILE_SIZE || (r->type == J_COMPRESS && r->offset > 1)) return -1;
+    if (r->len > len - *pos - r->path_len) return -1;
+    return 0;
+}
+
+// Replay one committed transaction onto the tree. Every record is checked
+// before any is applied, so a malformed transaction changes nothing;
+// returning -1 ends replay there.
+static int apply_txn(const char* txn, int len) {
+    int pos = 0;
+    JournalRecord r;
+    char path[JOURNAL_PATH_MAX + 1];
+    while (pos < len) {
+        if (next_record(txn, len, &pos, &r) < 0) return -1;
+        pos += r.path_len + r.len;
+    }
+    pos = 0;
+    while (pos < len) {
+        next_record(txn, len, &pos, &r);
+        memcpy(path, txn + pos, r.path_len);
+        path[r.path_len] = 0;
+        pos += r.path_len;
+        int i = r.type == J_CREATE || r.type == J_MKDIR ? -1 : walk(path);
+        if (r.type == J_CREATE) add_entry(path, VFS_FILE);
+        if (r.type == J_MKDIR) add_entry(path, VFS_DIR);
+        if ((r.type == J_DELETE || r.type == J_RMDIR) && i > VFS_ROOT) remove_entry(i);
+        if (r.type == J_WRITE && i > VFS_ROOT && vfs.inodes[i].type == VFS_FILE) {
+            write_inode(&vfs.inodes[i], r.offset, txn + pos, r.len);
+        }
+        if (r.type == J_COMPRESS && i > VFS_ROOT) set_compressed(i, r.offset);
+        if (r.type == J_TRUNCATE && i > VFS_ROOT && vfs.inodes[i].type == VFS_FILE) {
+            truncate_inode(&vfs.inodes[i], r.offset);
+        }
+        pos += r.len;
+    }
+    return 0;
+}
+
+// Attach a device: replay its log onto the tree, then start a snapshot of
+// the result, so files made before the mount become durable too
+static int do_mount(BlockDevice* dev) {
+    if (!vfs_initialized || journal_attached() || journal_open(dev, apply_txn) < 0) return -1;
+    zcache_writeback();
+    checkpoint_begin();
+    return 0;
+}
+
+static void name_device(BlockDevice* dev) {
+    int n = 0;
+    for (; dev->name[n] && n < (int)sizeof(vfs.device) - 1; n++) vfs.device[n] = dev->name[n];
+    vfs.device[n] = 0;
+    custom_strcpy(vfs.fs_type, "logfs");
+}
+
+// Commit what is buffered; a full region starts a snapshot, which the
+// caller runs. Returns 0 or -1.
+static int do_sync() {
+    zcache_writeback();
+    int result = checkpoint_due ? JOURNAL_FULL : journal_commit();
+    if (result == JOURNAL_FULL && !checkpoint_running) {
+        checkpoint_begin();
+        return 0;
+    }
+    return result < 0 ? -1 : 0;
+}
+
+// Detach the device once synced; the tree stays
+static void do_unmount() {
+    journal_close();
+    custom_strcpy(vfs.device, "hda");
+    custom_strcpy(vfs.fs_type, "ext2");
+}
+
+static int do_create_file(const char* name) {
+    if (!vfs_initialized) {
+        print_string("VFS not initialized in create", 16, 0);
+        return -1;
+    }
+    int i = add_entry(name, VFS_FILE);
+    if (i >= 0) {
+        log_op(J_CREATE, i, 0, 0, 0);
+        print_string("Created inode: ", 16, 0);
+        print_number(i, 16, 15);
+    }
+    return i;
+}
+
+static int do_mkdir(const char* path) {
+    if (!vfs_initialized) return -1;
+    int i = add_entry(path, VFS_DIR);
+    if (i >= 0) log_op(J_MKDIR, i, 0, 0, 0);
+    return i;
+}
+
+// Remove an empty directory that is not open
+static int do_rmdir(const char* path) {
+    if (!vfs_initialized) return -1;
+    int i = resolve(path);
+    if (i <= VFS_ROOT || vfs.inodes[i].type != VFS_DIR || vfs.inodes[i].size || is_open(i)) return -1;
+    int size = journal_attached() ? log_build(J_RMDIR, i, 0, 0, 0) : 0;
+    remove_entry(i);
+    if (size) log_append(size);
+    return 0;
+}
+
+static int alloc_fd(int skip) {
+    for (int i = 0; i < MAX_FILES; i++) {
+        if (!fds[i].used && i != skip) return i;
+    }
+    return -1;
+}
+
+static int open_inode(int ino, int offset) {
+    int fd = alloc_fd(-1);
+    if (fd < 0) {
+        print_string("No free file descriptors", 16, 0);
+        return -1;
+    }
+    fds[fd].used = 1;
+    fds[fd].inode_id = ino;
+    fds[fd].offset = offset;
+    fds[fd].refs = 1;
+    fds[fd].pipe = -1;
+    fds[fd].proc_file = -1;
+    return fd;
+}
+
+static int do_open_file(const char* name) {
+    if (!vfs_initialized) {
+        print_string("VFS not initialized in open", 16, 0);
+        return -1;
+    }
+    if (strncmp(name, PROC_PREFIX, sizeof(PROC_PREFIX) - 1) == 0) {
+        int id = procfs_lookup(name + sizeof(PROC_PREFIX) - 1);
+        int fd = id < 0 ? -1 : open_inode(-1, 0);
+        if (fd >= 0) fds[fd].proc_file = id;
+        return fd;
+    }
+    int i = resolve(name);
+    if (i < 0) {
+        print_string("File not found: ", 16, 0);
+        print_string(name, 16, 16);
+        return -1;
+    }
+    // A directory opens with its cursor on the first entry, for getdents
+    int fd = open_inode(i, vfs.inodes[i].type == VFS_DIR ? vfs.inodes[i].first_child : 0);
+    if (fd >= 0) {
+        print_string("Opened fd: ", 16, 0);
+        print_number(fd, 16, 11);
+    }
+    return fd;
+}
+
+// A descriptor listing a directory; its offset is the cursor
+static int do_opendir(const char* path) {
+    if (!vfs_initialized) return -1;
+    int i = resolve(path);
+    if (i < 0 || vfs.inodes[i].type != VFS_DIR) return -1;
+    return open_inode(i, vfs.inodes[i].first_child);
+}
+
+static int dir_fd(int fd) {
+    return fd >= 0 && fd < MAX_FILES && fds[fd].used && fds[fd].inode_id >= 0 &&
+           fds[fd].pipe < 0 && vfs.inodes[fds[fd].inode_id].type == VFS_DIR;
+}
+
+// Up to count entries of a directory listing from its cursor on. Returns how
+// many were filled, 0 at the end, -1 if fd is not a directory.
+static int do_getdents(int fd, Dirent* ents, int count) {
+    if (!dir_fd(fd)) return -1;
+    int n = 0;
+    for (int i = fds[fd].offset; i >= 0 && n < count; i = fds[fd].offset) {
+        Inode* inode = &vfs.inodes[i];
+        ents[n].inode = i;
+        ents[n].type = inode->type;
+        ents[n].size = inode->size;
+        custom_strcpy(ents[n].name, inode->name);
+        fds[fd].offset = inode->next_sibling;
+        n++;
+    }
+    return n;
+}
+
+static void fill_stat(int i, Stat* st) {
+    Inode* inode = &vfs.inodes[i];
+    st->inode = i;
+    st->type = inode->type;
+    st->size = inode->size;
+    st->blocks = 0;
+    for (int j = 0; j < FILE_BLOCKS; j++) {
+        if (inode->blocks[j] >= 0) st->blocks++;
+    }
+    st->parent = inode->parent;
+}
+
+static int do_stat(const char* path, Stat* st) {
+    if (!vfs_initialized) return -1;
+    int i = resolve(path);
+    if (i < 0) return -1;
+    fill_stat(i, st);
+    return 0;
+}
+
+// Pipes and /proc files have no inode to report
+static int do_fstat(int fd, Stat* st) {
+    if (fd < 0 || fd >= MAX_FILES || !fds[fd].used || fds[fd].inode_id < 0) return -1;
+    fill_stat(fds[fd].inode_id, st);
+    return 0;
+}
+
+// Fix vfs_read_file to allow full reads:
+static int do_read_file(int fd, char* buf, int len) {
+    if (!vfs_initialized) {
+        print_string("VFS not initialized in read", 17, 0);
+        return -1;
+    }
+    if (fd < 0 || fd >= MAX_FILES || !fds[fd].used || dir_fd(fd)) {
+        print_string("Invalid file descriptor: ", 17, 0);
+        print_number(fd, 17, 25);
+        return -1;
+    }
+    if (fds[fd].pipe >= 0) {
+        return fds[fd].pipe_write_end ? -1 : pipe_read(fds[fd].pipe, buf, len);
+    }
+    if (fds[fd].proc_file >= 0) {
+        // Rendered afresh on every read; the offset walks the new text
+        static char text[PROC_FILE_MAX];
+        int size = procfs_render(fds[fd].proc_file, text, sizeof(text));
+        int bytes = 0;
+        while (bytes < len && fds[fd].offset < size) {
+            buf[bytes++] = text[fds[fd].offset++];
+        }
+        return bytes;
+    }
+    Inode* inode = &vfs.inodes[fds[fd].inode_id];
+    if (!inode->used) {
+        print_string("Inode not used: ", 17, 0);
+        print_number(fds[fd].inode_id, 17, 16);
+        return -1;
+    }
+    if (inode->size == 0 || fds[fd].offset >= inode->size) {
+        print_string("File empty or offset beyond size", 17, 0);
+        return 0;
+    }
+    int bytes = 0;
+    if (inode->zsize >= 0) {
+        bytes = inode->size - fds[fd].offset < len ? inode->size - fds[fd].offset : len;
+        memcpy(buf, zcache_get(inode)->data + fds[fd].offset, bytes);
+        fds[fd].offset += bytes;
+    }
+    while (bytes < len && fds[fd].offset < inode->size) {
+        int off = fds[fd].offset;
+        int b = inode->blocks[off / VFS_BLOCK_SIZE];
+        int end = off - off % VFS_BLOCK_SIZE + VFS_BLOCK_SIZE; // End of this block
+        if (end > inode->size) end = inode->size;
+        int n = end - off < len - bytes ? end - off : len - bytes;
+        if (b < 0) {
+            memset(buf + bytes, 0, n); // A hole, as in gather()
+        } else {
+            memcpy(buf + bytes, blocks[b] + off % VFS_BLOCK_SIZE, n);
+        }
+        off += n;
+        bytes += n;
+        fds[fd].offset = off;
+    }
+    print_string("Read bytes: ", 17, 0);
+    print_number(bytes, 17, 12);
+    return bytes;
+}
+
+static int do_write_file(int fd, const char* buf, int len) {
+    if (!vfs_initialized) {
+        print_string("VFS not initialized in write", 18, 0);
+        return -1;
+    }
+    if (fd < 0 || fd >= MAX_FILES || !fds[fd].used || dir_fd(fd)) {
+        print_string("Invalid file descriptor in write: ", 18, 0);
+        print_number(fd, 18, 34);
+        return -1;
+    }
+    if (fds[fd].pipe >= 0) {
+        return fds[fd].pipe_write_end ? pipe_write(fds[fd].pipe, buf, len) : -1;
+    }
+    if (fds[fd].proc_file >= 0) return -1; // Read-only
+    Inode* inode = &vfs.inodes[fds[fd].inode_id];
+    if (!inode->used) {
+        print_string("Inode not used in write: ", 18, 0);
+        print_number(fds[fd].inode_id, 18, 25);
+        return -1;
+    }
+    int off = fds[fd].offset;
+    int bytes = write_inode(inode, off, buf, len);
+    fds[fd].offset = off + bytes;
+    if (bytes > 0) log_op(J_WRITE, inode->id, off, buf, bytes);
+    print_string("Wrote bytes: ", 18, 0);
+    print_number(bytes, 18, 13);
+    return bytes;
+}
+
+static void do_close_file(int fd) {
+    if (!vfs_initialized) {
+        print_string("VFS not initialized in close", 19, 0);
+        return;
+    }
+    if (fd >= 0 && fd < MAX_FILES && fds[fd].used) {
+        if (--fds[fd].refs > 0) return; // Still open in another process
+        fds[fd].used = 0;
+        int ino = fds[fd].inode_id;
+        fds[fd].inode_id = -1;
+        ZSlot* z = ino >= 0 ? zcache_find(ino) : 0;
+        if (z && z->dirty && !is_open(ino)) zcache_flush(z); // Last close: store it compressed
+        fds[fd].offset = 0;
+        if (fds[fd].proc_file >= 0) {
+            fds[fd].proc_file = -1;
+            return;
+        }
+        if (fds[fd].pipe >= 0) {
+            pipe_close(fds[fd].pipe, fds[fd].pipe_write_end);
+            fds[fd].pipe = -1;
+            return;
+        }
+        print_string("Closed fd: ", 19, 0);
+        print_number(fd, 19, 11);
+    }
+}
+
+// Switch a file to compressed (on) or raw storage
+static int do_compress(const char* path, int on) {
+    if (!vfs_initialized) return -1;
+    int i = resolve(path);
+    if (i <= VFS_ROOT || set_compressed(i, on) < 0) return -1;
+    log_op(J_COMPRESS, i, on != 0, 0, 0);
+    return 0;
+}
+
+// Cut a file that is not open to size bytes, no more than it holds
+static int do_truncate(const char* path, int size) {
+    if (!vfs_initialized) return -1;
+    int i = resolve(path);
+    if (i <= VFS_ROOT || vfs.inodes[i].type != VFS_FILE || is_open(i)) return -1;
+    if (size < 0 || size > vfs.inodes[i].size) return -1;
+    if (size == vfs.inodes[i].size) return 0;
+    truncate_inode(&vfs.inodes[i], size);
+    log_op(J_TRUNCATE, i, size, 0, 0);
+    return 0;
+}
+
+static int do_delete_file(const char* name) {
+    if (!vfs_initialized) {
+        print_string("VFS not initialized in delete", 16, 0);
+        return -1;
+    }
+    int i = resolve(name);
+    if (i < 0 || vfs.inodes[i].type != VFS_FILE) return -1;
+    if (is_open(i)) {
+        print_string("File is open: ", 16, 0);
+        print_string(name, 16, 14);
+        return -1;
+    }
+    int size = journal_attached() ? log_build(J_DELETE, i, 0, 0, 0) : 0;
+    remove_entry(i);
+    if (size) log_append(size);
+    return 0;
+}
+
+// Create a pipe and a descriptor for each end. Reads and writes on them
+// never block in here: they return PIPE_AGAIN and the caller sleeps on
+// vfs_wait_channel(fd).
+static int do_pipe(int* read_fd, int* write_fd) {
+    if (!vfs_initialized) return -1;
+    int r = alloc_fd(-1);
+    int w = alloc_fd(r);
+    if (r < 0 || w < 0) return -1;
+    int p = pipe_create();
+    if (p < 0) return -1;
+    fds[r].used = fds[w].used = 1;
+    fds[r].inode_id = fds[w].inode_id = -1;
+    fds[r].offset = fds[w].offset = 0;
+    fds[r].refs = fds[w].refs = 1;
+    fds[r].pipe = fds[w].pipe = p;
+    fds[r].proc_file = fds[w].proc_file = -1;
+    fds[r].pipe_write_end = 0;
+    fds[w].pipe_write_end = 1;
+    *read_fd = r;
+    *write_fd = w;
+    return 0;
+}
+
+// One more process descriptor shares the entry (fork); close drops one
+static int do_dup(int fd) {
+    if (fd < 0 || fd >= MAX_FILES || !fds[fd].used) return -1;
+    fds[fd].refs++;
+    return fd;
+}
+
+// Sleep channel for a descriptor whose read or write returned PIPE_AGAIN
+static const void* do_wait_channel(int fd) {
+    if (fd < 0 || fd >= MAX_FILES || !fds[fd].used || fds[fd].pipe < 0) return 0;
+    return &pipes[fds[fd].pipe];
+}
+
+// Locked entry points
+int vfs_create_file(const char* name) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int inode = do_create_file(name);
+    if (inode >= 0) vfs_stats.creates++;
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return inode;
+}
+
+int vfs_open_file(const char* name) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int fd = do_open_file(name);
+    if (fd >= 0) vfs_stats.opens++;
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return fd;
+}
+
+int vfs_read_file(int fd, char* buf, int len) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int bytes = do_read_file(fd, buf, len);
+    if (bytes >= 0) {
+        vfs_stats.reads++;
+        vfs_stats.bytes_read += bytes;
+    }
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return bytes;
+}
+
+int vfs_write_file(int fd, const char* buf, int len) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int bytes = do_write_file(fd, buf, len);
+    if (bytes >= 0) {
+        vfs_stats.writes++;
+        vfs_stats.bytes_written += bytes;
+    }
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return bytes;
+}
+
+void vfs_close_file(int fd) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    do_close_file(fd);
+    spin_unlock_irqrestore(&vfs_lock, flags);
+}
+
+int vfs_delete_file(const char* name) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int result = do_delete_file(name);
+    if (result == 0) vfs_stats.deletes++;
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result;
+}
+
+int vfs_truncate(const char* path, int size) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int result = do_truncate(path, size);
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result;
+}
+
+int vfs_mkdir(const char* path) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int inode = do_mkdir(path);
+    if (inode >= 0) vfs_stats.creates++;
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return inode;
+}
+
+int vfs_rmdir(const char* path) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int result = do_rmdir(path);
+    if (result == 0) vfs_stats.deletes++;
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result;
+}
+
+int vfs_opendir(const char* path) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int fd = do_opendir(path);
+    if (fd >= 0) vfs_stats.opens++;
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return fd;
+}
+
+// One entry: 1, or 0 at the end of the directory, -1 if not one
+int vfs_readdir(int fd, Dirent* ent) {
+    return vfs_getdents(fd, ent, 1);
+}
+
+int vfs_getdents(int fd, Dirent* ents, int count) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int result = do_getdents(fd, ents, count);
+    if (result > 0) vfs_stats.reads++;
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result;
+}
+
+// The inode a path names, -1 if none
+int vfs_lookup(const char* path) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int inode = vfs_initialized ? resolve(path) : -1;
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return inode;
+}
+
+int vfs_pipe(int* read_fd, int* write_fd) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int result = do_pipe(read_fd, write_fd);
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result;
+}
+
+int vfs_dup(int fd) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int result = do_dup(fd);
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result;
+}
+
+const void* vfs_wait_channel(int fd) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    const void* chan = do_wait_channel(fd);
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return chan;
+}
+
+int vfs_stat(const char* path, Stat* st) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int result = do_stat(path, st);
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result;
+}
+
+int vfs_fstat(int fd, Stat* st) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int result = do_fstat(fd, st);
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result;
+}
+
+int vfs_compress(const char* path, int on) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int result = do_compress(path, on);
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result;
+}
+
+// Attach a block device as the VFS's backing store (see Journal)
+int vfs_mount(BlockDevice* dev) {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int result = do_mount(dev);
+    if (result == 0) result = run_checkpoint(&flags);
+    if (result == 0) name_device(dev);
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result;
+}
+
+// Write out what is buffered and detach the device
+int vfs_unmount() {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    int result = -1;
+    if (journal_attached()) {
+        result = do_sync();
+        if (result == 0) result = run_checkpoint(&flags);
+        do_unmount();
+    }
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result;
+}
+
+// Make every change so far durable. Returns the blocks written, or -1.
+int vfs_sync() {
+    unsigned int flags = spin_lock_irqsave(&vfs_lock);
+    unsigned int before = journal_stats.blocks_written;
+    int result = do_sync();
+    if (result == 0) result = run_checkpoint(&flags);
+    spin_unlock_irqrestore(&vfs_lock, flags);
+    return result < 0 ? -1 : (int)(journal_stats.blocks_written - before);
+}
+
+// Changes are waiting for vfs_sync
+int vfs_dirty() {
+    return journal_pending() > 0 || checkpoint_due;
+}
@@ -0,0 +1,111 @@
+// Virtual File System
+#ifndef VFS_H
+#define VFS_H
+
+#include "syscall.h"
+#include "block.h"
+
+#define MAX_FILES 32 // Reduced from 32 to 16 to test memory constraints
+#define MAX_INODES 32768          // Files and directories, the root included
+#define MAX_FILE_SIZE 4096
+#define VFS_BLOCK_SIZE 512
+#define FILE_BLOCKS (MAX_FILE_SIZE / VFS_BLOCK_SIZE)
+#define VFS_BLOCKS 4096           // Data blocks shared by all files
+#define VFS_NAME_MAX DIRENT_NAME_MAX // Path component, terminator included
+#define VFS_PATH_MAX 128          // Longest path the dentry cache keeps
+#define VFS_HASH_SIZE 8192        // Directory entry hash chains (power of two)
+#define DCACHE_SIZE 64            // Dentry cache slots (power of two)
+#define VFS_ROOT 0                // Inode of "/"
+
+// Inode types
+#define VFS_FILE STAT_FILE
+#define VFS_DIR  STAT_DIR
+
+// Inode: a file or directory, named by its one entry in its parent
+typedef struct {
+    int id;
+    char name[VFS_NAME_MAX];  // Entry name in the parent directory
+    int size;                 // Bytes for a file, entries for a directory
+    int used;
+    int type;                 // VFS_FILE or VFS_DIR
+    int parent;               // Directory holding the entry; the root's is itself
+    int hash_next;            // Next inode on its entry hash chain, or on the free list
+    int first_child;          // Directory: entries in creation order, -1 when empty
+    int last_child;
+    int next_sibling;         // Links in the parent's entry list, -1 at the ends
+    int prev_sibling;
+    short blocks[FILE_BLOCKS];// File data blocks, -1 past the end (VFS_BLOCKS fits a short)
+    int zsize;                // Compressed file: LZ4 bytes in its blocks, 0 if they
+                              // hold it raw; -1 for a plain file
+} Inode;
+
+// Virtual File System mount structure
+typedef struct {
+    char device[16];          // Device name
+    char mount_point[16];     // Mount point path
+    char fs_type[16];         // Filesystem type
+    int inodes_used;          // Number of used inodes
+    int files;                // Number of files
+    int dirs;                 // Number of directories, the root included
+    int blocks_free;          // Data blocks not in any file
+    Inode inodes[MAX_INODES]; // Inode table
+} VFS_Mount;
+
+// File descriptor structure
+typedef struct {
+    int inode_id;             // Associated inode
+    int used;                 // 1: in use, 0: free
+    int offset;               // Current file offset; directories: next entry's inode, -1 at end
+    int refs;                 // Process descriptors sharing this entry (fork)
+    int pipe;                 // Pipe index for pipe ends, -1 for files
+    int pipe_write_end;       // 1: write end, 0: read end
+    int proc_file;            // procfs file for /proc names, -1 otherwise
+} FileDescriptor;
+
+// Operation counters since boot (/proc/vfs)
+typedef struct {
+    unsigned int creates;
+    unsigned int opens;
+    unsigned int reads;
+    unsigned int writes;
+    unsigned int bytes_read;
+    unsigned int bytes_written;
+    unsigned int deletes;
+    unsigned int dcache_hits;       // Paths resolved from the dentry cache
+    unsigned int dcache_misses;     // Paths walked component by component
+    unsigned int zcache_hits;       // Compressed files found decompressed
+    unsigned int zcache_misses;     // Compressed files decompressed into the cache
+    unsigned int zcache_writebacks; // Cached files compressed back into blocks
+} VfsStats;
+
+extern VFS_Mount vfs;                    // Single VFS mount
+extern VfsStats vfs_stats;
+extern FileDescriptor fds[MAX_FILES];    // File descriptor table
+extern int vfs_initialized;              // Flag to track VFS initialization
+
+void init_vfs(void);
+int vfs_create_file(const char* name);
+int vfs_open_file(const char* name);
+int vfs_read_file(int fd, char* buf, int len);
+int vfs_write_file(int fd, const char* buf, int len);
+void vfs_close_file(int fd);
+int vfs_delete_file(const char* name);
+int vfs_truncate(const char* path, int size);
+int vfs_mkdir(const char* path);
+int vfs_rmdir(const char* path);
+int vfs_opendir(const char* path);
+int vfs_readdir(int fd, Dirent* ent);
+int vfs_getdents(int fd, Dirent* ents, int count);
+int vfs_lookup(const char* path);
+int vfs_stat(const char* path, Stat* st);
+int vfs_fstat(int fd, Stat* st);
+int vfs_compress(const char* path, int on);
+int vfs_mount(BlockDevice* dev);
+int vfs_unmount(void);
+int vfs_sync(void);
+int vfs_dirty(void);
+int vfs_pipe(int* read_fd, int* write_fd);
+int vfs_dup(int fd);
+const void* vfs_wait_channel(int fd);
+
+#endif